@@ -34,6 +34,33 @@ module adb(
   input rom_select            // 0=ROM3, 1=ROM1
 );
 
+`ifdef ADB_STUB
+// Quiescent stub (vsim: make ADB=stub): a microcontroller with no keyboard
+// or mouse attached that never answers commands. $C027 reads 0 (nothing
+// pending, command register empty), $C024 reads "no movement", every other
+// register reads 0. Only for runs that need no ADB firmware traffic; the
+// ROM's ADB initialisation will see a silent GLU.
+assign dout_comb = (rw && addr == 8'h24) ? 8'h80 : 8'h00;
+assign irq = 1'b0;
+assign kbd_srq_irq = 1'b0;
+assign reset_key_pressed = 1'b0;
+always @(posedge CLK_14M) begin
+  dout <= 8'h00;
+  CLR80COL <= 1'b0;
+  STORE80 <= 1'b0;
+  RAMRD <= 1'b0;
+  RAMWRT <= 1'b0;
+  ALTZP <= 1'b0;
+  capslock <= 1'b0;
+  open_apple <= 1'b0;
+  closed_apple <= 1'b0;
+  apple_shift <= 1'b0;
+  apple_ctrl <= 1'b0;
+  akd <= 1'b0;
+  K <= 8'h00;
+end
+`else
+
 // Version - determined at runtime by rom_select
 // ROM3 (1MB Apple IIgs) = version 6, ROM1 (256K Apple IIgs) = version 5
 wire [7:0] VERSION = rom_select ? 8'd5 : 8'd6;
@@ -2217,4 +2244,5 @@ always @(posedge CLK_14M) begin
   end
 end
 
+`endif
 endmodule
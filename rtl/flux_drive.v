@@ -103,6 +103,36 @@ module flux_drive (
     input  wire        CHUNK_LOADING       // A chunk load is in progress
 );
 
+`ifdef IWM_FLUX_STUB
+    // Quiescent stub (vsim: make IWM=stub): an empty drive with the head
+    // parked on track 0. No flux, no track requests, no BRAM traffic.
+    assign WRITE_PROTECT = 1'b1;
+    assign SENSE = 1'b1;
+    assign DISK_SWITCHED_OUT = 1'b1;
+    assign STEP_BUSY_OUT = 1'b0;
+    assign STEP_DIR_OUT = 1'b0;
+    assign MOTOR_ON_SENSE_OUT = 1'b0;
+    assign AT_TRACK0_OUT = 1'b1;
+    assign MOTOR_SPINNING = 1'b0;
+    assign DRIVE_READY = 1'b0;
+    assign TRACK = 7'd0;
+    assign HEAD_QTRACK = 9'd0;
+    assign BIT_POSITION = 17'd0;
+    assign BIT_TIMER_OUT = 6'd0;
+    assign BRAM_ADDR = 16'd0;
+    assign CHUNK_RELOAD_REQ = 1'b0;
+    assign CHUNK_NEEDED = 2'd0;
+    always @(posedge CLK_14M) begin
+        FLUX_TRANSITION <= 1'b0;
+        EJECT_REQ <= 1'b0;
+        SD_TRACK_REQ <= 8'd0;
+        SD_TRACK_STROBE <= 1'b0;
+        WRITE_BYTE_OUT <= 8'd0;
+        WRITE_WE_OUT <= 1'b0;
+        WRITE_ADDR_OUT <= 16'd0;
+    end
+`else
+
     //=========================================================================
     // Parameters
     //=========================================================================
@@ -1803,4 +1833,5 @@ module flux_drive (
     end
 `endif
 
+`endif
 endmodule
@@ -209,7 +209,7 @@ module iigs
 
   logic               onesecond_irq;
   logic               qtrsecond_irq;
-  logic               snd_irq;
+  logic               snd_irq/*verilator public_flat*/;
 
   logic               valid;
 
@@ -271,7 +271,7 @@ module iigs
   logic [7:0]         C02BVAL;
 
   logic [7:0]         VGCINT; //23
-  logic [7:0]         INTEN; //41
+  logic [7:0]         INTEN/*verilator public_flat*/; //41
   reg [7:0]           INTFLAG = 0; // 46, 47 - Interrupt flags register
 
   logic               STORE80;
@@ -1744,7 +1744,7 @@ module iigs
   end
   
   // CPU interrupt output
-  wire cpu_irq;
+  wire cpu_irq/*verilator public_flat*/;
 
 `ifdef DEBUG_VERBOSE
   // Trace sound IRQ line transitions and cpu_irq composition to verify behavior
@@ -2104,7 +2104,7 @@ wire ready_out;
               );
 
   // Centralized IRQ management - matches GSplus/Clemens architecture
-  reg [15:0] irq_pending = 0;  // 16-bit interrupt pending register (bit 0=aggregator, 3=VBL, 4=QSEC, 7=SCC)
+  reg [15:0] irq_pending/*verilator public_flat*/ = 0;  // 16-bit interrupt pending register (bit 0=aggregator, 3=VBL, 4=QSEC, 7=SCC)
   reg interrupt_clear_pulse = 0;
   reg qtrsecond_irq_d = 0;
   reg vbl_started = 0;
@@ -2344,7 +2344,7 @@ wire ready_out;
 `endif
 
   wire adb_capslock;
-  wire adb_kbd_srq_irq;   // ADB keyboard SRQ interrupt (cleared via TALK-R0 drain in adb.v, not C047)
+  wire adb_kbd_srq_irq/*verilator public_flat*/;   // ADB keyboard SRQ interrupt (cleared via TALK-R0 drain in adb.v, not C047)
   assign capslock = adb_capslock;
   wire adb_open_apple, adb_closed_apple, adb_shift, adb_ctrl;
   wire adb_akd;
@@ -109,6 +109,30 @@ module iwm_flux (
     output wire        DEBUG_BYTE_VALID // Pulse when byte completes (new_byte signal)
 );
 
+`ifdef IWM_FLUX_STUB
+    // Quiescent stub (vsim: make IWM=stub): the soft-switch view from
+    // iwm_woz is kept so status and mode read back correctly, but there is
+    // no read/write shift register and no SmartPort bus.
+    //   Q7=0 Q6=0  data      : $00 while the motor is active, else $FF
+    //   Q7=0 Q6=1  status    : sense, motor active, mode[4:0]
+    //   Q7=1 Q6=0  handshake : $BF (buffer ready, no write in progress)
+    assign DATA_OUT = !SW_Q7 ? (!SW_Q6 ? (MOTOR_ACTIVE ? 8'h00 : 8'hFF)
+                                       : {SENSE_BIT, 1'b0, MOTOR_ACTIVE, SW_MODE[4:0]})
+                             : (!SW_Q6 ? 8'hBF : {SENSE_BIT, 1'b0, MOTOR_ACTIVE, SW_MODE[4:0]});
+    assign FLUX_WRITE_MODE = 1'b0;
+    assign SP_REQ = 1'b0;
+    assign DEBUG_RSH = 8'd0;
+    assign DEBUG_STATE = 3'd0;
+    assign DEBUG_BYTE_VALID = 1'b0;
+    always @(posedge CLK_14M) begin
+        FLUX_WRITE <= 1'b0;
+        FLUX_WRITE_STROBE <= 1'b0;
+        SP_WR_STROBE <= 1'b0;
+        SP_WR_DATA <= 8'd0;
+        SP_RD_STROBE <= 1'b0;
+    end
+`else
+
     //=========================================================================
     // IWM Data Registers
     //=========================================================================
@@ -2471,4 +2495,5 @@ module iwm_flux (
 	    end
 `endif
 
+`endif
 endmodule
@@ -18,6 +18,13 @@ module paddle_timer(
     output reg timer_expired    // 0=still timing, 1=expired
 );
 
+`ifdef PADDLE_STUB
+// Quiescent stub (vsim: make PADDLE=stub): the timer is always expired, so
+// PREAD sees every paddle at 0 and returns immediately.
+always @(posedge clk) timer_expired <= 1'b1;
+initial timer_expired = 1'b1;
+`else
+
 // Calculate timeout in 14MHz ticks
 // Real Apple II paddle timing: ~11.04 microseconds per paddle unit (at 1MHz)
 // At 14.318 MHz: 11.04 µs * 14.318 = ~158 ticks per paddle unit
@@ -44,4 +51,5 @@ always @(posedge clk or posedge reset) begin
     end
 end
 
+`endif
 endmodule
\ No newline at end of file
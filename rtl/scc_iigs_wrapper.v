@@ -71,7 +71,17 @@ assign scc_clk_en = (clk_div == 3'b000);
 wire scc_internal_irq_n;
 
 //`define FAKESERIAL
-`ifdef FAKESERIAL
+`ifdef SCC_STUB
+// Quiescent stub (vsim: make SCC=stub): both channels idle with nothing
+// attached. Control reads return an idle RR0 (Tx empty, Tx underrun/EOM,
+// CTS and DCD set, no Rx data); data reads return 0; no interrupts.
+assign rdata = rs[1] ? 8'h00 : 8'h6C;
+assign scc_internal_irq_n = 1'b1;
+assign txd_a = 1'b1;
+assign txd_b = 1'b1;
+assign rts_a = 1'b1;
+
+`elsif FAKESERIAL
 reg [7:0] out_reg;
 assign rdata = out_reg;
 
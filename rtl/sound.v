@@ -17,6 +17,19 @@ module sound
     // Apple II speaker input
     input             speaker_state);
 
+`ifdef SOUND_STUB
+   // Quiescent stub (vsim: make SOUND=stub): no GLU, DOC, sound RAM or
+   // filter. GLU registers read 0 (never busy), no DOC interrupts; only the
+   // Apple II speaker reaches the outputs.
+   wire signed [15:0] speaker_audio = speaker_state ? 16'sh0800 : -16'h0800;
+
+   assign host_data_out = 8'h00;
+   assign irq = 1'b0;
+   assign ca = 4'h0;
+   assign sound_out_l = speaker_audio;
+   assign sound_out_r = speaker_audio;
+`else
+
    wire [16:0]       doc_addr_out;
    wire [15:0]       ram_addr;
    wire [15:0]       glu_addr_out;
@@ -82,6 +95,29 @@ module sound
       .addr(ram_addr),
       .data_out(ram_data_out));
 
+`ifdef SOUND_CMODEL
+   // Simulation only: C++ DOC model over DPI (vsim: make SOUND=cmodel)
+   es5503_dpi doc(
+      .CLK_14M(CLK_14M),
+      .clk_7M_en(clk_7M_en),
+      .reset(reset),
+      .wr(doc_wr),
+      .host_en(doc_host_en),
+      .reg_addr(glu_addr_out[7:0]),
+      .reg_data_in(glu_data_out),
+      .sample_data_in(ram_data_out),
+      .data_out(doc_data_out),
+      .addr_out(doc_addr_out),
+      .sound_out(doc_sound_out),
+      .ca(ca),
+      .irq(irq),
+      .osc_en(osc_en),
+      .chk_data_out(8'd0),
+      .chk_addr_out(17'd0),
+      .chk_sound_out(16'd0),
+      .chk_ca(4'd0),
+      .chk_irq(1'b0));
+`else
    es5503 doc(
       .CLK_14M(CLK_14M),
       .clk_7M_en(clk_7M_en),
@@ -97,6 +133,32 @@ module sound
       .ca(ca),
       .irq(irq),
       .osc_en(osc_en));
+`endif
+
+`ifdef SOUND_CHECK
+   // Simulation only: C++ DOC model in lockstep with the RTL DOC above
+   // (vsim: make SOUND=check); divergences are reported as DOCCHK: lines.
+   es5503_dpi #(.CHECK(1)) doc_check(
+      .CLK_14M(CLK_14M),
+      .clk_7M_en(clk_7M_en),
+      .reset(reset),
+      .wr(doc_wr),
+      .host_en(doc_host_en),
+      .reg_addr(glu_addr_out[7:0]),
+      .reg_data_in(glu_data_out),
+      .sample_data_in(ram_data_out),
+      .data_out(),
+      .addr_out(),
+      .sound_out(),
+      .ca(),
+      .irq(),
+      .osc_en(),
+      .chk_data_out(doc_data_out),
+      .chk_addr_out(doc_addr_out),
+      .chk_sound_out(doc_sound_out),
+      .chk_ca(ca),
+      .chk_irq(irq));
+`endif
 
    // In stereo mode, the filter needs to run two cycles per sample period
    reg osc_en_d;
@@ -129,4 +191,5 @@ module sound
       .output_l(iir_sound_out_l),
       .output_r(iir_sound_out_r));
 
+`endif
 endmodule
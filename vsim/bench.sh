@@ -0,0 +1,115 @@
+#!/bin/bash
+# Simulator throughput on workloads built only from files in the tree, so the
+# numbers can be shared and tracked in CI (no commercial disk images):
+#
+#   rom3-boot  ROM3 cold boot to the "Check startup device" screen
+#   rom1-boot  ROM1 cold boot to the same screen
+#   selftest   --selftest for a fixed number of frames
+#   hdd        customtests/blank.2mg on the SmartPort HDD
+#   floppy35   blank.2mg's first 800K as a 3.5" disk (converted to WOZ)
+#   floppy525  blank.2mg's first 140K as a 5.25" disk (converted to WOZ)
+#   shr        a loop filling the SHR screen, injected with --load and
+#              started by a warm reset through SOFTEV
+#
+# Each build gets its own object dir (obj_bench_<build>) like stub_bench.sh.
+# cycles are the 14M master clock ticks SIMSTATS reports.
+#
+#   ./bench.sh [builds...]            default: fastsim faithful dualrate
+#   ./bench.sh fastsim fastram        fast RAM in the model vs FASTRAM=host
+#   make bench BENCH_BUILDS=fastsim BENCH_CSV=bench.csv
+
+BUILDS="$*"
+[ -z "$BUILDS" ] && BUILDS="fastsim faithful dualrate"
+WORKLOADS="rom3-boot rom1-boot selftest hdd floppy35 floppy525 shr"
+CSV=${BENCH_CSV:-}
+WORK=obj_bench
+BLANK=../customtests/blank.2mg
+
+mkdir -p $WORK
+# blank.2mg is a 4096-block ProDOS volume; its payload starts at 64
+tail -c +65 $BLANK | head -c 819200 > $WORK/blank35.po
+tail -c +65 $BLANK | head -c 143360 > $WORK/blank525.po
+
+# 00:0800  SEI / CLC XCE / REP #$30 / SEP #$20 / LDA #$C1 / STA $E1C029
+#          REP #$20 / LDA #0
+# 00:0812  LDX #0
+# 00:0815  STA $E12000,X / INX / INX / CPX #$8000 / BNE $0815
+#          INC A / BRA $0812
+printf '\x78\x18\xFB\xC2\x30\xE2\x20\xA9\xC1\x8F\x29\xC0\xE1\xC2\x20\xA9\x00\x00' > $WORK/shr.bin
+printf '\xA2\x00\x00\x9F\x00\x20\xE1\xE8\xE8\xE0\x00\x80\xD0\xF5\x1A\x80\xEF' >> $WORK/shr.bin
+# SOFTEV = $0800, PWREDUP = $08 EOR $A5
+printf '\x00\x08\xAD' > $WORK/softev.bin
+
+BOOTED='text~"startup device" -> stop'
+
+workload_args() {
+    case $1 in
+    rom3-boot) ARGS=(--rom 3 --stop-at-frame 1500 --trigger "$BOOTED") ;;
+    rom1-boot) ARGS=(--rom 1 --stop-at-frame 1500 --trigger "$BOOTED") ;;
+    selftest)  ARGS=(--selftest --stop-at-frame 600) ;;
+    hdd)       ARGS=(--disk $BLANK --stop-at-frame 600) ;;
+    floppy35)  ARGS=(--woz $WORK/blank35.po --stop-at-frame 600) ;;
+    floppy525) ARGS=(--woz $WORK/blank525.po --stop-at-frame 600) ;;
+    shr)       ARGS=(--load 300:$WORK/shr.bin@00:0800 --load 300:$WORK/softev.bin@00:03F2
+                     --reset-at-frame 300 --stop-at-frame 600) ;;
+    esac
+}
+
+build_vars() {
+    case $1 in
+    fastsim)  echo "" ;;
+    faithful) echo "FAITHFUL=1" ;;
+    dualrate) echo "DUALRATE=1" ;;
+    fastram)  echo "FASTRAM=host" ;;
+    *)        return 1 ;;
+    esac
+}
+
+[ -n "$CSV" ] && echo "build,workload,frames,cycles,wall,cycles_per_s,frames_per_s,status" > $CSV
+
+FAIL=0
+ROWS=()
+for b in $BUILDS; do
+    if ! vars=$(build_vars $b); then
+        echo "unknown build $b (fastsim, faithful, dualrate, fastram)"
+        FAIL=1
+        continue
+    fi
+    echo "=== $b ($vars) ==="
+    if ! make OBJ_DIR=obj_bench_$b $vars > obj_bench_$b.build.txt 2>&1; then
+        echo "  build failed, see obj_bench_$b.build.txt"
+        FAIL=1
+        continue
+    fi
+    for w in $WORKLOADS; do
+        workload_args $w
+        log=$WORK/$b.$w.txt
+        ./obj_bench_$b/Vemu --headless --quiet --no-cpu-log --fast-rom-load "${ARGS[@]}" > $log 2>&1
+        rc=$?
+        stats=$(grep '^SIMSTATS:' $log | tail -1)
+        if [ -z "$stats" ]; then
+            echo "  $w: no SIMSTATS line, see $log"
+            FAIL=1
+            continue
+        fi
+        status=ok
+        [ $rc -eq 3 ] && status=timeout
+        [ $rc -ne 0 ] && [ $rc -ne 3 ] && status=rc$rc
+        row=$(echo "$stats" | awk -v b=$b -v w=$w -v s=$status '{
+            for (i = 2; i <= NF; i++) { split($i, kv, "="); v[kv[1]] = kv[2] }
+            w_s = v["wall"] > 0 ? v["wall"] : 1e-9
+            printf "%s,%s,%d,%s,%s,%.0f,%.2f,%s", b, w, v["frames"], v["cycles"], v["wall"],
+                   v["cycles"] / w_s, v["frames"] / w_s, s
+        }')
+        echo "  $w: $stats"
+        ROWS+=("$row")
+        [ -n "$CSV" ] && echo "$row" >> $CSV
+    done
+done
+
+echo ""
+printf "%-9s %-10s %7s %9s %10s %8s %s\n" build workload frames "wall s" "Mcycles/s" "frames/s" status
+for r in "${ROWS[@]}"; do
+    echo "$r" | awk -F, '{ printf "%-9s %-10s %7d %9.2f %10.3f %8.2f %s\n", $1, $2, $3, $5, $6 / 1e6, $7, $8 }'
+done
+exit $FAIL
@@ -0,0 +1,71 @@
+`timescale 1ns/1ns
+
+// Drop-in replacement for rtl/es5503.v backed by the C++ model in
+// sim/es5503_model.cpp (make SOUND=cmodel). The clock-phase counter stays in
+// Verilog so osc_en is still visible to the sound GLU and sound RAM mux; the
+// register file, accumulators, IRQ stack and output registers live in C++.
+//
+// With CHECK=1 (make SOUND=check) the instance runs next to the RTL DOC and
+// compares the RTL's outputs (chk_*) against the model on every edge.
+
+import "DPI-C" function void es5503_cm_clock
+  (input int reset, input int osc_en, input int osc_en_d, input int wr, input int host_en,
+   input int reg_addr, input int reg_data_in, input int sample_data_in,
+   output int data_out, output int addr_out, output int sound_out, output int ca, output int irq);
+
+import "DPI-C" function void es5503_cm_check
+  (input int data_out, input int addr_out, input int sound_out, input int ca, input int irq);
+
+module es5503_dpi
+  #(parameter CHECK = 0)
+   (input	      CLK_14M,
+    input	      clk_7M_en,
+    input	      reset,
+    input	      wr,
+    input	      host_en,
+    input [7:0]	      reg_addr,
+    input [7:0]	      reg_data_in,
+    input [7:0]	      sample_data_in,
+    output reg [7:0]  data_out,
+    output reg [16:0] addr_out,
+    output reg [15:0] sound_out,
+    output reg [3:0]  ca,
+    output	      irq,
+    output	      osc_en,
+    // RTL outputs to compare against (CHECK=1 only)
+    input [7:0]	      chk_data_out,
+    input [16:0]      chk_addr_out,
+    input [15:0]      chk_sound_out,
+    input [3:0]	      chk_ca,
+    input	      chk_irq
+    );
+
+   reg [2:0]	     clk_phase;
+   reg		     osc_en_d;
+   reg		     irq_r;
+
+   int		     m_data, m_addr, m_sound, m_ca, m_irq;
+
+   assign osc_en = (clk_phase == 3'b111) & clk_7M_en;
+   assign irq = irq_r;
+
+   always @(posedge CLK_14M) begin
+      osc_en_d <= osc_en;
+      if (clk_7M_en)
+	clk_phase <= reset ? 3'b000 : clk_phase + 3'b001;
+
+      if (CHECK)
+	es5503_cm_check({24'b0, chk_data_out}, {15'b0, chk_addr_out}, {16'b0, chk_sound_out},
+			{28'b0, chk_ca}, {31'b0, chk_irq});
+
+      es5503_cm_clock({31'b0, reset}, {31'b0, osc_en}, {31'b0, osc_en_d}, {31'b0, wr}, {31'b0, host_en},
+		      {24'b0, reg_addr}, {24'b0, reg_data_in}, {24'b0, sample_data_in},
+		      m_data, m_addr, m_sound, m_ca, m_irq);
+
+      data_out <= m_data[7:0];
+      addr_out <= m_addr[16:0];
+      sound_out <= m_sound[15:0];
+      ca <= m_ca[3:0];
+      irq_r <= m_irq[0];
+   end
+endmodule // es5503_dpi
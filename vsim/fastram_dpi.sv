@@ -0,0 +1,31 @@
+`timescale 1ns/1ns
+
+// Drop-in replacement for the 16MB fastram dpram in sim.v (make FASTRAM=host).
+// The bytes live in a host buffer (sim/sim_fastram.cpp) instead of an array
+// inside the model, so the model shrinks by 16MB and the harness, dumps and
+// a forked child all see the same pages. Port A only, same timing as dpram:
+// q_a follows the written byte on a write, the stored byte on a read.
+
+import "DPI-C" function byte fastram_rd(input int addr);
+import "DPI-C" function void fastram_wr(input int addr, input byte data);
+
+module fastram_dpi
+   (input	      clock_a,
+    input	      wren_a,
+    input [23:0]      address_a,
+    input [7:0]	      data_a,
+    output reg [7:0]  q_a,
+    input	      ce_a
+    );
+
+   always @(posedge clock_a) begin
+      if (ce_a) begin
+	 if (wren_a) begin
+	    fastram_wr({8'b0, address_a}, data_a);
+	    q_a <= data_a;
+	 end else begin
+	    q_a <= fastram_rd({8'b0, address_a});
+	 end
+      end
+   end
+endmodule // fastram_dpi
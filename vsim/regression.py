@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+"""
+regression.py -- manifest-driven parallel regression runner.
+
+Runs every entry of regression_manifest.json on a worker pool. Each test gets
+its own output directory (regress_out/<name>/) holding its log, screenshot,
+hash log, audio fingerprint and a scratch copy of its disk images, so tests
+never share files and the run takes as long as the slowest test rather than
+the sum. Screenshots are compared in process with a per-pixel tolerance;
+results go to the console, JUnit XML and JSON.
+
+Manifest: {"defaults": {...}, "tests": [{...}, ...]}; every test key may also
+appear in defaults.
+
+    name          test name, also the output directory name (required)
+    frame         frame to screenshot and stop at (required)
+    disk, disk2   HDD images (slot 7 units 0/1)
+    woz           floppy image
+    rom           1 or 3
+    keys          list of --send-keys specs, e.g. ["200:RUN\\n"]
+    mouse         list of --send-mouse specs
+    joystick      list of --send-joystick specs
+    args          extra Vemu arguments
+    golden_png    expected screenshot
+    tolerance     {"channel": max per-channel delta, "pixels": pixels allowed over it}
+    golden_hash   expected --hash-log output (compared with tools/hashcmp)
+    hash_ignore   hashcmp --ignore list, e.g. "cycle,pc"
+    golden_audio  expected --audio-fingerprint output (tools/audiofp)
+    audio_frames  --audio-frames range for the fingerprint
+    scratch       copy disk images into the output dir first (default true)
+    timeout       seconds before the run is killed (default 900)
+
+Usage:
+    ./regression.py                          all tests, one worker per core
+    ./regression.py -j 4 -k arkanoid         subset, 4 workers
+    ./regression.py --junit r.xml --json r.json
+    ./regression.py --update                 copy outputs over the goldens
+
+Exit status is 0 when nothing failed (skips are allowed), 1 otherwise.
+"""
+import argparse
+import concurrent.futures
+import json
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import time
+import zlib
+from xml.sax.saxutils import escape, quoteattr
+
+
+# ---- PNG (8-bit RGB/RGBA, non-interlaced: what stb_image_write produces) ----
+
+def png_read(path):
+    """Return (width, height, channels, bytearray of pixels)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError(f"{path}: not a PNG")
+    pos, idat = 8, []
+    width = height = channels = None
+    while pos < len(data):
+        length, ctype = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if ctype == b"IHDR":
+            width, height, depth, colour, _, _, interlace = struct.unpack(">IIBBBBB", body)
+            if depth != 8 or colour not in (2, 6) or interlace:
+                raise ValueError(f"{path}: unsupported PNG (depth {depth}, colour {colour})")
+            channels = 3 if colour == 2 else 4
+        elif ctype == b"IDAT":
+            idat.append(body)
+        elif ctype == b"IEND":
+            break
+    raw = zlib.decompress(b"".join(idat))
+    stride = width * channels
+    out = bytearray(stride * height)
+    prev = bytearray(stride)
+    for y in range(height):
+        ftype = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        if ftype == 1:
+            for i in range(channels, stride):
+                line[i] = (line[i] + line[i - channels]) & 0xFF
+        elif ftype == 2:
+            for i in range(stride):
+                line[i] = (line[i] + prev[i]) & 0xFF
+        elif ftype == 3:
+            for i in range(stride):
+                left = line[i - channels] if i >= channels else 0
+                line[i] = (line[i] + ((left + prev[i]) >> 1)) & 0xFF
+        elif ftype == 4:
+            for i in range(stride):
+                a = line[i - channels] if i >= channels else 0
+                b = prev[i]
+                c = prev[i - channels] if i >= channels else 0
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[i] = (line[i] + pred) & 0xFF
+        out[y * stride:(y + 1) * stride] = line
+        prev = line
+    return width, height, channels, out
+
+
+def png_write_rgb(path, width, height, pixels):
+    def chunk(ctype, body):
+        return struct.pack(">I", len(body)) + ctype + body + struct.pack(">I", zlib.crc32(ctype + body))
+    stride = width * 3
+    raw = b"".join(b"\x00" + bytes(pixels[y * stride:(y + 1) * stride]) for y in range(height))
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)))
+        f.write(chunk(b"IDAT", zlib.compress(raw, 6)))
+        f.write(chunk(b"IEND", b""))
+
+
+def png_compare(golden, test, channel_tol, pixel_tol, diff_path):
+    """Return (ok, message). Writes a diff image (red = over tolerance) on failure."""
+    with open(golden, "rb") as f1, open(test, "rb") as f2:
+        if f1.read() == f2.read():
+            return True, "identical"
+    gw, gh, gc, gp = png_read(golden)
+    tw, th, tc, tp = png_read(test)
+    if (gw, gh) != (tw, th):
+        return False, f"size {tw}x{th}, expected {gw}x{gh}"
+    bad, worst = 0, 0
+    diff = bytearray(gw * gh * 3)
+    for i in range(gw * gh):
+        d = max(abs(gp[i * gc + k] - tp[i * tc + k]) for k in range(3))
+        worst = max(worst, d)
+        if d > channel_tol:
+            bad += 1
+            diff[i * 3] = 255
+        else:
+            v = (tp[i * tc] + tp[i * tc + 1] + tp[i * tc + 2]) // 12
+            diff[i * 3:i * 3 + 3] = bytes((v, v, v))
+    if bad <= pixel_tol:
+        return True, f"{bad} pixels over tolerance (max delta {worst})"
+    png_write_rgb(diff_path, gw, gh, diff)
+    return False, f"{bad} pixels differ (max delta {worst}), see {diff_path}"
+
+
+# ---- running one test ----
+
+def run_test(t, opts):
+    name = t["name"]
+    out = os.path.join(opts.out, name)
+    shutil.rmtree(out, ignore_errors=True)
+    os.makedirs(out)
+    res = {"name": name, "status": "pass", "message": "", "time": 0.0, "log": os.path.join(out, "log.txt")}
+
+    cmd = [opts.exe]
+    if not opts.gui:
+        cmd.append("--headless")
+    for key, flag in (("disk", "--disk"), ("disk2", "--disk2"), ("woz", "--woz")):
+        if key not in t:
+            continue
+        src = t[key]
+        if not os.path.exists(src):
+            res.update(status="skip", message=f"missing image {src}")
+            return res
+        if t.get("scratch", True):
+            dst = os.path.join(out, os.path.basename(src))
+            shutil.copyfile(src, dst)
+            src = dst
+        cmd += [flag, src]
+    if "rom" in t:
+        cmd += ["--rom", str(t["rom"])]
+    for key, flag in (("keys", "--send-keys"), ("mouse", "--send-mouse"), ("joystick", "--send-joystick")):
+        for spec in t.get(key, []):
+            cmd += [flag, spec]
+
+    frame = int(t["frame"])
+    shot = os.path.join(out, "screen.png")
+    cmd += ["--stop-at-frame", str(frame), "--screenshot", str(frame), "--screenshot-name", shot]
+    hlog = os.path.join(out, "hash.hlog")
+    if "golden_hash" in t:
+        cmd += ["--hash-log", hlog]
+    afp = os.path.join(out, "audio.afp")
+    if "golden_audio" in t:
+        cmd += ["--audio-fingerprint", afp]
+        if "audio_frames" in t:
+            cmd += ["--audio-frames", t["audio_frames"]]
+    cmd += [str(a) for a in t.get("args", [])]
+    res["command"] = cmd
+
+    start = time.time()
+    with open(res["log"], "w") as log:
+        try:
+            rc = subprocess.run(cmd, stdout=log, stderr=subprocess.STDOUT, timeout=t.get("timeout", 900)).returncode
+        except subprocess.TimeoutExpired:
+            rc = None
+    res["time"] = time.time() - start
+    if rc is None:
+        res.update(status="error", message=f"timeout after {t.get('timeout', 900)} s")
+        return res
+    if rc != 0:
+        res.update(status="error", message=f"Vemu exited with {rc}")
+        return res
+
+    # Each check can fail the test; a missing golden only skips that check.
+    notes, failed, checked = [], False, 0
+
+    def check(golden, produced, what, compare):
+        nonlocal failed, checked
+        if not golden:
+            return
+        if opts.update:
+            if os.path.exists(produced):
+                shutil.copyfile(produced, golden)
+                notes.append(f"{what} golden updated")
+            return
+        if not os.path.exists(golden):
+            notes.append(f"{what}: no golden")
+            return
+        if not os.path.exists(produced):
+            failed = True
+            notes.append(f"{what}: not produced")
+            return
+        checked += 1
+        ok, msg = compare(golden, produced)
+        failed |= not ok
+        notes.append(f"{what}: {msg}")
+
+    tol = t.get("tolerance", {})
+    check(t.get("golden_png"), shot, "screen",
+          lambda g, p: png_compare(g, p, tol.get("channel", 0), tol.get("pixels", 0), os.path.join(out, "diff.png")))
+
+    def tool(binary, argv):
+        r = subprocess.run([binary] + argv, capture_output=True, text=True)
+        lines = r.stdout.strip().splitlines()
+        return r.returncode == 0, lines[-1] if lines else r.stderr.strip()
+
+    hash_args = ["--ignore", t["hash_ignore"]] if t.get("hash_ignore") else []
+    check(t.get("golden_hash"), hlog, "hash", lambda g, p: tool("tools/hashcmp", [g, p] + hash_args))
+    check(t.get("golden_audio"), afp, "audio", lambda g, p: tool("tools/audiofp", [g, p]))
+
+    res["message"] = "; ".join(notes)
+    if failed:
+        res["status"] = "fail"
+    elif not checked and not opts.update:
+        res["status"] = "skip"
+    return res
+
+
+# ---- reports ----
+
+def write_junit(path, results, wall):
+    fails = sum(r["status"] == "fail" for r in results)
+    errors = sum(r["status"] == "error" for r in results)
+    skips = sum(r["status"] == "skip" for r in results)
+    with open(path, "w") as f:
+        f.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+        f.write(f'<testsuite name="iigs-regression" tests="{len(results)}" failures="{fails}" '
+                f'errors="{errors}" skipped="{skips}" time="{wall:.1f}">\n')
+        for r in results:
+            f.write(f'  <testcase classname="regression" name={quoteattr(r["name"])} time="{r["time"]:.1f}">\n')
+            msg = quoteattr(r["message"])
+            if r["status"] == "fail":
+                f.write(f'    <failure message={msg}/>\n')
+            elif r["status"] == "error":
+                f.write(f'    <error message={msg}/>\n')
+            elif r["status"] == "skip":
+                f.write(f'    <skipped message={msg}/>\n')
+            f.write(f'    <system-out>{escape(r["log"])}</system-out>\n')
+            f.write('  </testcase>\n')
+        f.write('</testsuite>\n')
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Parallel IIgs regression runner")
+    ap.add_argument("manifest", nargs="?", default="regression_manifest.json")
+    ap.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 1)
+    ap.add_argument("-k", "--filter", help="only run tests whose name contains this")
+    ap.add_argument("--exe", default="./obj_dir/Vemu")
+    ap.add_argument("--out", default="regress_out")
+    ap.add_argument("--junit", help="write JUnit XML here")
+    ap.add_argument("--json", help="write JSON results here")
+    ap.add_argument("--gui", action="store_true", help="run with the GUI instead of --headless")
+    ap.add_argument("--update", action="store_true", help="copy outputs over the goldens")
+    opts = ap.parse_args()
+
+    with open(opts.manifest) as f:
+        manifest = json.load(f)
+    defaults = manifest.get("defaults", {})
+    tests = [{**defaults, **t} for t in manifest["tests"]]
+    if opts.filter:
+        tests = [t for t in tests if opts.filter in t["name"]]
+    if not os.path.exists(opts.exe):
+        print(f"ERROR: {opts.exe} not found. Run 'make' first.")
+        return 1
+    for tool, target in (("tools/hashcmp", "hashcmp"), ("tools/audiofp", "audiofp")):
+        if not os.path.exists(tool) and any(("golden_hash" if target == "hashcmp" else "golden_audio") in t for t in tests):
+            subprocess.run(["make", "-s", target], check=False)
+
+    os.makedirs(opts.out, exist_ok=True)
+    print(f"Running {len(tests)} tests on {opts.jobs} workers...")
+    start = time.time()
+    results = []
+    with concurrent.futures.ThreadPoolExecutor(max_workers=opts.jobs) as pool:
+        futures = [pool.submit(run_test, t, opts) for t in tests]
+        for fut in concurrent.futures.as_completed(futures):
+            r = fut.result()
+            results.append(r)
+            print(f"  {r['status'].upper()}: {r['name']} ({r['time']:.1f} s) {r['message']}", flush=True)
+    wall = time.time() - start
+    order = {t["name"]: i for i, t in enumerate(tests)}
+    results.sort(key=lambda r: order[r["name"]])
+
+    counts = {s: sum(r["status"] == s for r in results) for s in ("pass", "fail", "error", "skip")}
+    serial = sum(r["time"] for r in results)
+    print(f"\n{counts['pass']} passed, {counts['fail']} failed, {counts['error']} errors, "
+          f"{counts['skip']} skipped in {wall:.1f} s (serial {serial:.1f} s)")
+
+    if opts.junit:
+        write_junit(opts.junit, results, wall)
+    if opts.json:
+        with open(opts.json, "w") as f:
+            json.dump({"wall": wall, "counts": counts, "tests": results}, f, indent=2)
+    return 1 if counts["fail"] or counts["error"] else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
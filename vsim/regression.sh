@@ -1,5 +1,7 @@
 #!/bin/bash
 # This will run the vsim and snapshot known working hard disks and compare the images
+# one after another. regression.py runs the same set (regression_manifest.json)
+# in parallel with isolated output directories and JUnit/JSON results.
 
 # Check for required disk images
 MISSING_DISKS=0
@@ -72,7 +74,8 @@ else
 fi
 
 echo "Running Arkanoid test..."
-./obj_dir/Vemu --disk arkanoid.hdv --stop-at-frame 485 --screenshot 485 &> arkanoid.txt
+./obj_dir/Vemu --disk arkanoid.hdv --stop-at-frame 485 --screenshot 485 \
+    --audio-fingerprint arkanoid.afp --audio-frames 300..484 &> arkanoid.txt
 if [ -f "regression_images/arkanoid_screenshot_frame_0485.png" ]; then
     if diff screenshot_frame_0485.png regression_images/arkanoid_screenshot_frame_0485.png > /dev/null 2>&1; then
         echo "  PASS: Arkanoid"
@@ -83,6 +86,19 @@ if [ -f "regression_images/arkanoid_screenshot_frame_0485.png" ]; then
 else
     echo "  SKIP: Arkanoid - missing reference image"
 fi
+# Audio: per-frame energy/spectrum fingerprint (ES5503 + sound GLU path).
+# Refresh the golden with: cp arkanoid.afp regression_images/arkanoid_audio.afp
+if [ -f "regression_images/arkanoid_audio.afp" ]; then
+    [ -x tools/audiofp ] || make -s audiofp
+    if tools/audiofp regression_images/arkanoid_audio.afp arkanoid.afp > arkanoid_audio.txt; then
+        echo "  PASS: Arkanoid audio"
+    else
+        echo "  FAIL: Arkanoid audio - fingerprint differs (see arkanoid_audio.txt)"
+        FAILED=1
+    fi
+else
+    echo "  SKIP: Arkanoid audio - missing reference fingerprint"
+fi
 
 echo "Running Total Replay II test..."
 ./obj_dir/Vemu --disk "Total Replay II v1.0-alpha.4.hdv" --stop-at-frame 156 --screenshot 156 &> totalreplay2.txt
@@ -348,6 +348,18 @@ iigs  iigs(
    //dpram #(.widthad_a(24),.prefix("fast")) fastram - unified ROM+RAM
 
 
+`ifdef FASTRAM_HOST
+// Same bytes in a host buffer over DPI (make FASTRAM=host)
+fastram_dpi fastram
+(
+        .clock_a(clk_sys),
+        .address_a( mem_addr ),
+        .data_a(ioctl_download ? ioctl_dout : iigs_dout),
+        .q_a(fastram_dout),
+        .wren_a((we & fastram_ce) | ioctl_wr),
+        .ce_a(fastram_ce | rom_ce | ioctl_download)
+);
+`else
 dpram #(.widthad_a(24),.prefix("fast")) fastram
 (
         .clock_a(clk_sys),
@@ -362,6 +374,7 @@ dpram #(.widthad_a(24),.prefix("fast")) fastram
         .data_b(8'h00),
         .q_b()
 );
+`endif
 
 
 // ROM is now loaded via ioctl into the unified dpram at startup
@@ -0,0 +1,238 @@
+#include "es5503_model.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Deferred writes: the RTL is one always block of nonblocking assignments, so
+// every decision below reads pre-edge state and queues its writes; they are
+// applied in source order at the end of the edge (later writes win, per bit).
+// ---------------------------------------------------------------------------
+namespace {
+struct Write {
+	void *p;
+	uint32_t mask, val;
+	uint8_t wide;
+};
+
+struct WriteLog {
+	Write w[24];
+	int n = 0;
+	void b(uint8_t &r, uint32_t v, uint32_t mask = 0xff) { w[n++] = Write{ &r, mask, v, 0 }; }
+	void l(uint32_t &r, uint32_t v, uint32_t mask = 0xffffffffu) { w[n++] = Write{ &r, mask, v, 1 }; }
+	void apply() {
+		for (int i = 0; i < n; i++) {
+			if (w[i].wide) {
+				uint32_t *p = (uint32_t *)w[i].p;
+				*p = (*p & ~w[i].mask) | (w[i].val & w[i].mask);
+			} else {
+				uint8_t *p = (uint8_t *)w[i].p;
+				*p = (uint8_t)((*p & ~w[i].mask) | (w[i].val & w[i].mask));
+			}
+		}
+		n = 0;
+	}
+};
+}
+
+ES5503Model::ES5503Model()
+{
+	// Verilator's --x-initial fast leaves the RTL registers at zero
+	memset(this, 0, sizeof(*this));
+}
+
+// mux_addr() from the RTL: wave table address for one oscillator
+static inline uint32_t mux_addr(uint32_t acc, uint8_t ptr, int tbl, int res)
+{
+	uint32_t ptr_mask = (0xffu << tbl) & 0xff;
+	uint32_t acc_mask = 0xffffu >> (8 - tbl);
+	uint32_t acc_bits = (acc >> (9 + res - tbl)) & 0xffff & acc_mask;
+	uint32_t ptr_bits = ((uint32_t)(ptr & ptr_mask) << 8) & 0xffff;
+	return acc_bits | ptr_bits;
+}
+
+void ES5503Model::Clock(bool reset, bool osc_en, bool osc_en_d, bool wr, bool host_en,
+                        uint8_t reg_addr, uint8_t reg_data_in, uint8_t sample_data_in)
+{
+	WriteLog q;
+	const int cur = current_osc;
+	const bool irq = irq_pending != 0;
+
+	uint32_t new_addr = ((uint32_t)((table_size[cur] >> 6) & 1) << 16) |
+		mux_addr(acc[cur], table_ptr[cur], (table_size[cur] >> 3) & 7, table_size[cur] & 7);
+
+	// ---- host register access ----
+	const int r = reg_addr & 31;
+	if (wr && host_en) {
+		switch (reg_addr >> 5) {
+		case 0: q.b(freq_lo[r], reg_data_in); break;
+		case 1: q.b(freq_hi[r], reg_data_in); break;
+		case 2: q.b(volume[r], reg_data_in); break;
+		case 4: q.b(table_ptr[r], reg_data_in); break;
+		case 5:
+			q.b(control[r], reg_data_in);
+			if ((control[r] & 1) && !(reg_data_in & 1)) {
+				q.l(acc[r], 0);
+				q.b(sample[r], 0x80);	// don't halt on the next scan
+			}
+			break;
+		case 6: q.b(table_size[r], reg_data_in); break;
+		case 7:
+			if (r == 1) q.b(oscs_enabled, (reg_data_in >> 1) & 31);
+			break;
+		}
+	} else {
+		switch (reg_addr >> 5) {
+		case 0: data_out = freq_lo[r]; break;
+		case 1: data_out = freq_hi[r]; break;
+		case 2: data_out = volume[r]; break;
+		case 3: data_out = sample[r]; break;
+		case 4: data_out = table_ptr[r]; break;
+		case 5: data_out = control[r]; break;
+		case 6: data_out = table_size[r]; break;
+		case 7:
+			switch (reg_addr & 3) {
+			case 0: {	// OIR
+				if (irq && host_en) {
+					int top = irq_stack[(irq_sp - 1) & 31];
+					data_out = (uint8_t)((!irq) << 7 | 1 << 6 | top << 1 | 1);
+					q.l(irq_pending, 0, 1u << top);
+					q.b(irq_sp, (irq_sp - 1) & 31);
+				} else {
+					data_out = (uint8_t)((!irq) << 7 | 1 << 6 | irq_stack[0] << 1 | 1);
+				}
+				break;
+			}
+			case 1: data_out = (uint8_t)(oscs_enabled << 1); break;
+			}
+			break;
+		}
+	}
+
+	// ---- oscillator scan ----
+	if (osc_en) {
+		const uint8_t ctl = control[cur];
+		if (!(ctl & 1) && !refreshing) {
+			uint32_t freq = (uint32_t)freq_hi[cur] << 8 | freq_lo[cur];
+			uint32_t sum = acc[cur] + freq;				// 25 bits
+			uint32_t flip = (sum & 0x1000000) | ((sum ^ acc[cur]) & 0xffffff);
+			bool wrapped = (flip >> (17 + (table_size[cur] & 7))) & 1;
+			q.l(acc[cur], sum & 0xffffff);
+
+			if (wrapped || sample[cur] == 0) {
+				q.b(control[cur], ((ctl >> 1) & 1) || sample[cur] == 0, 1);
+
+				if (ctl & 2)	// oneshot or swap: clear the oscillator
+					q.l(acc[cur], 0);
+
+				if (ctl & 4) {	// sync / swap / AM
+					q.l(acc[cur], 0);
+					if (cur != 0 && !(cur & 1) && !(control[cur - 1] & 2))
+						q.l(acc[cur - 1], 0);
+					if (((ctl >> 1) & 3) == 3) {
+						q.b(control[cur ^ 1], 0, 1);
+						q.b(sample[cur ^ 1], 0x80);
+						q.l(acc[cur ^ 1], 0);
+					}
+				}
+
+				if ((ctl & 8) && !((irq_pending >> cur) & 1)) {
+					q.l(irq_pending, 1u << cur, 1u << cur);
+					q.b(irq_stack[irq_sp], (uint32_t)cur);
+					q.b(irq_sp, (irq_sp + 1) & 31);
+				}
+			}
+
+			if (((ctl >> 1) & 3) == 2 && (cur & 1)) {
+				// AM: no output, modulate the partner's volume
+				sound_out = 0;
+				if (cur != 31)
+					q.b(volume[cur + 1], sample[cur] ^ 0x80);
+			} else {
+				sound_out = (uint16_t)((int8_t)(sample[cur] ^ 0x80) * (int)volume[cur]);
+			}
+			ca = ctl >> 4;
+		} else {
+			sound_out = 0;
+		}
+	} else if (osc_en_d) {
+		// synchronous sound RAM: the fetch lands one edge after osc_en
+		if (!(control[cur] & 1))
+			q.b(sample[cur], sample_data_in);
+
+		if (cur == oscs_enabled && !refreshing) {
+			q.b(refreshing, 1);
+			q.b(current_refresh, 0);
+		} else if (refreshing) {
+			if (current_refresh) {
+				q.b(refreshing, 0);
+				q.b(current_osc, 0);
+			} else {
+				q.b(current_refresh, 1);
+			}
+		} else {
+			q.b(current_osc, (cur + 1) & 31);
+		}
+	}
+
+	q.apply();
+	addr_out = new_addr;
+
+	if (reset) {
+		current_osc = 0;
+		refreshing = 0;
+		current_refresh = 0;
+		memset(acc, 0, sizeof(acc));
+		irq_pending = 0;
+		irq_sp = 0;
+		irq_stack[0] = 0x1f;
+		sound_out = 0;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// DPI entry points (es5503_dpi.sv)
+// ---------------------------------------------------------------------------
+static ES5503Model g_doc;
+static uint64_t g_doc_edges;
+static uint64_t g_doc_mismatches;
+
+static void doc_check_summary()
+{
+	printf("DOCCHK: %llu edges compared, %llu mismatches\n",
+	       (unsigned long long)g_doc_edges, (unsigned long long)g_doc_mismatches);
+}
+
+extern "C" void es5503_cm_clock(int reset, int osc_en, int osc_en_d, int wr, int host_en,
+                                int reg_addr, int reg_data_in, int sample_data_in,
+                                int *data_out, int *addr_out, int *sound_out, int *ca, int *irq)
+{
+	g_doc.Clock(reset, osc_en, osc_en_d, wr, host_en,
+	            (uint8_t)reg_addr, (uint8_t)reg_data_in, (uint8_t)sample_data_in);
+	*data_out = g_doc.data_out;
+	*addr_out = (int)g_doc.addr_out;
+	*sound_out = g_doc.sound_out;
+	*ca = g_doc.ca;
+	*irq = g_doc.Irq();
+}
+
+// Lockstep check: called on each edge before es5503_cm_clock with the RTL
+// DOC's registered outputs, which must equal what the model produced on the
+// previous edge. Reports the first mismatches in full, then every 2^n-th.
+extern "C" void es5503_cm_check(int data_out, int addr_out, int sound_out, int ca, int irq)
+{
+	if (g_doc_edges++ == 0)
+		atexit(doc_check_summary);
+	if ((uint8_t)data_out == g_doc.data_out && (uint32_t)(addr_out & 0x1ffff) == g_doc.addr_out &&
+	    (uint16_t)sound_out == g_doc.sound_out && (ca & 15) == g_doc.ca && (irq & 1) == g_doc.Irq())
+		return;
+	g_doc_mismatches++;
+	if (g_doc_mismatches <= 16 || !(g_doc_mismatches & (g_doc_mismatches - 1))) {
+		printf("DOCCHK: edge %llu osc %d%s: rtl data=%02X addr=%05X snd=%04X ca=%X irq=%d"
+		       " model data=%02X addr=%05X snd=%04X ca=%X irq=%d (mismatch #%llu)\n",
+		       (unsigned long long)g_doc_edges, g_doc.current_osc, g_doc.refreshing ? " (refresh)" : "",
+		       data_out & 0xff, addr_out & 0x1ffff, sound_out & 0xffff, ca & 15, irq & 1,
+		       g_doc.data_out, g_doc.addr_out, g_doc.sound_out, g_doc.ca, g_doc.Irq(),
+		       (unsigned long long)g_doc_mismatches);
+	}
+}
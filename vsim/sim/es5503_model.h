@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+// Behavioural model of rtl/es5503.v (Ensoniq DOC), cycle-compatible with the
+// RTL at the CLK_14M edge. Built with `make SOUND=cmodel` it replaces the RTL
+// DOC through the DPI wrapper es5503_dpi.sv; with `make SOUND=check` both run
+// side by side and every edge is compared (DOCCHK: lines on divergence).
+//
+// The oscillator scan, osc_en / osc_en_d phases, sound RAM fetch timing, IRQ
+// stack and host register file follow the RTL exactly, including its
+// nonblocking-assignment ordering: everything on the right-hand side reads the
+// state from before the edge, and when two branches write the same register
+// the later one in the RTL wins.
+struct ES5503Model {
+	// per-oscillator registers (structure of arrays, indexed by oscillator)
+	uint8_t freq_lo[32];
+	uint8_t freq_hi[32];
+	uint8_t volume[32];
+	uint8_t sample[32];
+	uint8_t table_ptr[32];
+	uint8_t control[32];
+	uint8_t table_size[32];
+	uint32_t acc[32];		// 24-bit accumulators
+
+	uint32_t irq_pending;		// one bit per oscillator
+	uint8_t irq_stack[32];
+	uint8_t irq_sp;			// 5 bits
+
+	uint8_t oscs_enabled;		// 5 bits
+	uint8_t current_osc;		// 5 bits
+	uint8_t refreshing;
+	uint8_t current_refresh;
+
+	// registered outputs
+	uint8_t data_out;
+	uint32_t addr_out;		// 17 bits
+	uint16_t sound_out;
+	uint8_t ca;
+
+	ES5503Model();
+	void Clock(bool reset, bool osc_en, bool osc_en_d, bool wr, bool host_en,
+	           uint8_t reg_addr, uint8_t reg_data_in, uint8_t sample_data_in);
+	bool Irq() const { return irq_pending != 0; }
+};
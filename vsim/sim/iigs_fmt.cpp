@@ -4,6 +4,12 @@
 #include "iigs_fmt.h"
 #include <string.h>
 
+// x86 hosts get an SSSE3 bulk translator, picked at run time (no -m flags).
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define IIGS_FMT_SSSE3 1
+#endif
+
 // ---------------------------------------------------------------------------
 // little/big-endian helpers
 // ---------------------------------------------------------------------------
@@ -14,6 +20,9 @@ static inline uint32_t rd_le32(const uint8_t *p) {
 static inline uint32_t rd_be32(const uint8_t *p) {
 	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
 }
+static inline uint64_t rd_be64(const uint8_t *p) {
+	return ((uint64_t)rd_be32(p) << 32) | rd_be32(p + 4);
+}
 static inline void wr_le16(uint8_t *p, uint16_t v) { p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; }
 static inline void wr_le32(uint8_t *p, uint32_t v) {
 	p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = (v >> 24) & 0xff;
@@ -21,18 +30,45 @@ static inline void wr_le32(uint8_t *p, uint32_t v) {
 static inline void wr_be32(uint8_t *p, uint32_t v) {
 	p[0] = (v >> 24) & 0xff; p[1] = (v >> 16) & 0xff; p[2] = (v >> 8) & 0xff; p[3] = v & 0xff;
 }
+static inline void wr_be64(uint8_t *p, uint64_t v) { wr_be32(p, (uint32_t)(v >> 32)); wr_be32(p + 4, (uint32_t)v); }
 
 // ---------------------------------------------------------------------------
-// CRC32 (zlib/WOZ compatible)
+// CRC32 (zlib/WOZ compatible), slicing-by-8
 // ---------------------------------------------------------------------------
+// The tables are filled by FmtTables below (static init, so concurrent callers
+// never race a lazy first-use build).
+static uint32_t crc32_tab[8][256];
+
+static void init_crc32_tab(void)
+{
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t c = i;
+		for (int b = 0; b < 8; b++)
+			c = (c >> 1) ^ (0xEDB88320u & (~(c & 1) + 1));
+		crc32_tab[0][i] = c;
+	}
+	for (uint32_t i = 0; i < 256; i++)
+		for (int k = 1; k < 8; k++)
+			crc32_tab[k][i] = (crc32_tab[k - 1][i] >> 8) ^ crc32_tab[0][crc32_tab[k - 1][i] & 0xff];
+}
+
 uint32_t woz_crc32(const uint8_t *data, size_t len)
 {
 	uint32_t crc = 0xFFFFFFFFu;
-	for (size_t i = 0; i < len; i++) {
-		crc ^= data[i];
-		for (int b = 0; b < 8; b++)
-			crc = (crc >> 1) ^ (0xEDB88320u & (~(crc & 1) + 1));
+	// eight bytes per step: fold the running crc into the first word, then
+	// look every byte up in its own shifted table
+	while (len >= 8) {
+		uint32_t lo = crc ^ rd_le32(data);
+		uint32_t hi = rd_le32(data + 4);
+		crc = crc32_tab[7][lo & 0xff] ^ crc32_tab[6][(lo >> 8) & 0xff] ^
+		      crc32_tab[5][(lo >> 16) & 0xff] ^ crc32_tab[4][lo >> 24] ^
+		      crc32_tab[3][hi & 0xff] ^ crc32_tab[2][(hi >> 8) & 0xff] ^
+		      crc32_tab[1][(hi >> 16) & 0xff] ^ crc32_tab[0][hi >> 24];
+		data += 8;
+		len -= 8;
 	}
+	while (len--)
+		crc = (crc >> 8) ^ crc32_tab[0][(crc ^ *data++) & 0xff];
 	return crc ^ 0xFFFFFFFFu;
 }
 
@@ -178,6 +214,111 @@ int woz_disk_type(const uint8_t *buf, size_t size)
 	return -1;
 }
 
+// ===========================================================================
+// WOZ chunks, tracks and bit framing
+// ===========================================================================
+const uint8_t *woz_find_chunk(const uint8_t *woz, size_t size, const char *id, uint32_t *out_size)
+{
+	size_t pos = 12;
+	while (pos + 8 <= size) {
+		uint32_t csize = rd_le32(woz + pos + 4);
+		if (memcmp(woz + pos, id, 4) == 0) {
+			if (out_size) *out_size = csize;
+			return woz + pos + 8;
+		}
+		pos += 8 + (size_t)csize;
+	}
+	return NULL;
+}
+
+int woz_tmap(const uint8_t *woz, size_t size, int idx)
+{
+	uint32_t len = 0;
+	const uint8_t *tmap = woz_find_chunk(woz, size, "TMAP", &len);
+	if (!tmap || idx < 0 || (uint32_t)idx >= len || tmap + idx >= woz + size) return -1;
+	return tmap[idx] == 0xFF ? -1 : tmap[idx];
+}
+
+// WOZ1 TRKS: fixed 6656-byte records (bitstream, then bytes_used and
+// bit_count at 6646/6648). WOZ2: 160 x 8-byte entries pointing at 512-byte
+// blocks.
+#define WOZ1_TRK_LEN 6656
+
+int woz_track_bits(const uint8_t *woz, size_t size, int trk, const uint8_t **bits, uint32_t *bit_count)
+{
+	uint32_t len = 0;
+	const uint8_t *trks = woz_find_chunk(woz, size, "TRKS", &len);
+	if (!trks || trk < 0 || trk >= 160) return 0;
+	if (memcmp(woz, "WOZ1", 4) == 0) {
+		size_t off = (size_t)(trks - woz) + (size_t)trk * WOZ1_TRK_LEN;
+		if (off + WOZ1_TRK_LEN > size) return 0;
+		uint32_t bc = rd_le16(woz + off + 6648);
+		if (bc == 0 || bc > 6646 * 8) return 0;
+		*bits = woz + off;
+		*bit_count = bc;
+		return 1;
+	}
+	if (trks + (trk + 1) * 8 > woz + size) return 0;
+	const uint8_t *e = trks + trk * 8;
+	uint16_t start_block = rd_le16(e + 0);
+	uint16_t blk_cnt     = rd_le16(e + 2);
+	uint32_t bc          = rd_le32(e + 4);
+	if (blk_cnt == 0 || bc == 0) return 0;
+	size_t off = (size_t)start_block * A2_BLOCK_SIZE;
+	if (off + (size_t)blk_cnt * A2_BLOCK_SIZE > size || bc > (uint32_t)blk_cnt * A2_BLOCK_SIZE * 8) return 0;
+	*bits = woz + off;
+	*bit_count = bc;
+	return 1;
+}
+
+// Self-sync framer: WOZ BITS -> disk bytes.
+// Between nibbles the shift register is empty, so each nibble is just the 8
+// bits starting at the next 1 bit. Find it with a count-leading-zeros over a
+// 64-bit window instead of shifting one bit at a time; when the window holds
+// seven back-to-back nibbles (inside address/data fields) take them all at
+// once. The last < 64 bits of the track go through the bit-serial loop.
+static inline int clz64(uint64_t v)
+{
+#if defined(__GNUC__)
+	return __builtin_clzll(v);
+#else
+	int n = 0;
+	while (!(v & 0x8000000000000000ull)) { v <<= 1; n++; }
+	return n;
+#endif
+}
+
+int woz_frame_bits(const uint8_t *bits, uint32_t bit_count, uint8_t *out, int out_cap)
+{
+	int n = 0;
+	uint32_t p = 0;
+	while (n < out_cap && p + 64 <= bit_count) {
+		// at least 57 real bits, the low (p & 7) bits are shifted-in zeros
+		uint64_t w = rd_be64(bits + (p >> 3)) << (p & 7);
+		if ((w & 0x8080808080808000ull) == 0x8080808080808000ull && n + 8 <= out_cap) {
+			wr_be64(out + n, w);
+			n += 7;
+			p += 56;
+			continue;
+		}
+		if (!w) { p += 57; continue; }
+		int lz = clz64(w);
+		if (lz > 57 - 8) { p += lz; continue; }   // nibble runs past the window
+		out[n++] = (uint8_t)(w >> (56 - lz));
+		p += lz + 8;
+	}
+	uint8_t reg = 0;
+	for (uint32_t i = p; i < bit_count && n < out_cap; i++) {
+		int bit = (bits[i >> 3] >> (7 - (i & 7))) & 1;
+		reg = (uint8_t)((reg << 1) | bit);
+		if (reg & 0x80) {
+			out[n++] = reg;
+			reg = 0;
+		}
+	}
+	return n;
+}
+
 // ===========================================================================
 // 140K sector order (DOS 3.3 <-> ProDOS)
 // ===========================================================================
@@ -217,8 +358,10 @@ static const uint8_t data_epilog[] = { 0xde, 0xaa, 0xeb };
 
 static const int soft_interleave[16] =
     { 0, 7, 0xE, 6, 0xD, 5, 0xC, 4, 0xB, 3, 0xA, 2, 9, 1, 8, 0xF };
-static const int phys_interleave[16] =
-    { 0, 0xD, 0xB, 9, 7, 5, 3, 1, 0xE, 0xC, 0xA, 8, 6, 4, 2, 0xF };
+// physical position -> logical sector (inverse of the DOS 3.3 physical
+// interleave 0,D,B,9,7,5,3,1,E,C,A,8,6,4,2,F)
+static const int phys_to_logical_525[16] =
+    { 0, 7, 0xE, 6, 0xD, 5, 0xC, 4, 0xB, 3, 0xA, 2, 9, 1, 8, 0xF };
 
 static const uint8_t gcr6_table[0x40] = {
 	0x96, 0x97, 0x9a, 0x9b, 0x9d, 0x9e, 0x9f, 0xa6,
@@ -231,12 +374,75 @@ static const uint8_t gcr6_table[0x40] = {
 	0xf7, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
 };
 
-static inline uint8_t translate(uint8_t b) { return gcr6_table[b & 0x3f]; }
+// 5-and-3 disk bytes (13-sector DOS 3.2 format); only used by the track scan
+static const uint8_t gcr5_table[0x20] = {
+	0xab, 0xad, 0xae, 0xaf, 0xb5, 0xb6, 0xb7, 0xba,
+	0xbb, 0xbd, 0xbe, 0xbf, 0xd6, 0xd7, 0xda, 0xdb,
+	0xdd, 0xde, 0xdf, 0xea, 0xeb, 0xed, 0xee, 0xef,
+	0xf5, 0xf6, 0xf7, 0xfa, 0xfb, 0xfd, 0xfe, 0xff
+};
+
+// ---------------------------------------------------------------------------
+// derived lookup tables
+// ---------------------------------------------------------------------------
+// gcr6_inv: disk byte -> 6-bit value, 0x80 = not a valid 6-and-2 nibble.
+// gcr5_inv likewise for 5-and-3. Filled at static-init time alongside the
+// crc tables.
+static uint8_t gcr6_inv[256];
+static uint8_t gcr5_inv[256];
+
+static struct FmtTables {
+	FmtTables()
+	{
+		init_crc32_tab();
+
+		memset(gcr6_inv, 0x80, sizeof(gcr6_inv));
+		for (int i = 0; i < 0x40; i++) gcr6_inv[gcr6_table[i]] = (uint8_t)i;
+		memset(gcr5_inv, 0x80, sizeof(gcr5_inv));
+		for (int i = 0; i < 0x20; i++) gcr5_inv[gcr5_table[i]] = (uint8_t)i;
+	}
+} fmt_tables;
 
-static uint8_t untranslate(uint8_t x)
+// Invalid nibbles decode as 0, matching the original dsk2nib_lib behaviour.
+static inline uint8_t untranslate(uint8_t x) { return gcr6_inv[x] & 0x3f; }
+
+// ---------------------------------------------------------------------------
+// bulk 6-bit -> disk byte translation (SSSE3 when the host has it)
+// ---------------------------------------------------------------------------
+#ifdef IIGS_FMT_SSSE3
+// 64-entry lookup as four 16-entry pshufb lookups selected by bits 4-5.
+__attribute__((target("ssse3")))
+static void gcr6_encode_ssse3(uint8_t *p, size_t n)
+{
+	const __m128i t0 = _mm_loadu_si128((const __m128i *)(gcr6_table + 0x00));
+	const __m128i t1 = _mm_loadu_si128((const __m128i *)(gcr6_table + 0x10));
+	const __m128i t2 = _mm_loadu_si128((const __m128i *)(gcr6_table + 0x20));
+	const __m128i t3 = _mm_loadu_si128((const __m128i *)(gcr6_table + 0x30));
+	const __m128i m0f = _mm_set1_epi8(0x0f);
+	const __m128i m03 = _mm_set1_epi8(0x03);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m128i v  = _mm_loadu_si128((const __m128i *)(p + i));
+		__m128i lo = _mm_and_si128(v, m0f);
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), m03);
+		__m128i r  = _mm_and_si128(_mm_shuffle_epi8(t0, lo), _mm_cmpeq_epi8(hi, _mm_setzero_si128()));
+		r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(t1, lo), _mm_cmpeq_epi8(hi, _mm_set1_epi8(1))));
+		r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(t2, lo), _mm_cmpeq_epi8(hi, _mm_set1_epi8(2))));
+		r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(t3, lo), _mm_cmpeq_epi8(hi, m03)));
+		_mm_storeu_si128((__m128i *)(p + i), r);
+	}
+	for (; i < n; i++) p[i] = gcr6_table[p[i] & 0x3f];
+}
+#endif
+
+// Translate n 6-bit values (upper bits ignored) to disk bytes in place.
+static void gcr6_encode_block(uint8_t *p, size_t n)
 {
-	const uint8_t *p = (const uint8_t *)memchr(gcr6_table, x, 0x40);
-	return p ? (uint8_t)(p - gcr6_table) : 0;
+#ifdef IIGS_FMT_SSSE3
+	static const int have_ssse3 = __builtin_cpu_supports("ssse3");
+	if (have_ssse3) { gcr6_encode_ssse3(p, n); return; }
+#endif
+	for (size_t i = 0; i < n; i++) p[i] = gcr6_table[p[i] & 0x3f];
 }
 
 static void odd_even_encode(uint8_t a[2], int i)
@@ -249,29 +455,33 @@ static uint8_t odd_even_decode(uint8_t b1, uint8_t b2)
 	return (uint8_t)(((b1 << 1) & 0xaa) | (b2 & 0x55));
 }
 
+// The low two data bits are stored swapped in the secondary buffer.
+static const uint8_t swap2[4] = { 0, 2, 1, 3 };
+
 // Encode one 256-byte sector's data field (342 nibbles + checksum) at dest.
 static void nibbilize(const uint8_t *src, uint8_t *dest)
 {
-	uint8_t primary[PRIMARY_BUF_LEN];
 	uint8_t secondary[SECONDARY_BUF_LEN];
-	memset(secondary, 0, sizeof(secondary));
 
-	for (int i = 0; i < PRIMARY_BUF_LEN; i++) {
-		primary[i] = src[i] >> 2;
-		int index = i % SECONDARY_BUF_LEN;
-		int section = i / SECONDARY_BUF_LEN;
-		uint8_t pair = ((src[i] & 2) >> 1) | ((src[i] & 1) << 1);
-		secondary[index] |= pair << (section * 2);
+	// byte i lands in secondary[i % 86] at bit pair (i / 86); the third
+	// section only covers 84 entries (256 - 2*86)
+	for (int i = 0; i < SECONDARY_BUF_LEN; i++) {
+		uint8_t v = swap2[src[i] & 3] | (swap2[src[i + SECONDARY_BUF_LEN] & 3] << 2);
+		if (i + 2 * SECONDARY_BUF_LEN < PRIMARY_BUF_LEN)
+			v |= swap2[src[i + 2 * SECONDARY_BUF_LEN] & 3] << 4;
+		secondary[i] = v;
 	}
 
-	int idx = 0;
-	dest[idx++] = translate(secondary[0]);
+	// each nibble carries the XOR with its predecessor; translate in one go
+	uint8_t *o = dest;
+	*o++ = secondary[0];
 	for (int i = 1; i < SECONDARY_BUF_LEN; i++)
-		dest[idx++] = translate(secondary[i] ^ secondary[i - 1]);
-	dest[idx++] = translate(primary[0] ^ secondary[SECONDARY_BUF_LEN - 1]);
+		*o++ = secondary[i] ^ secondary[i - 1];
+	*o++ = (src[0] >> 2) ^ secondary[SECONDARY_BUF_LEN - 1];
 	for (int i = 1; i < PRIMARY_BUF_LEN; i++)
-		dest[idx++] = translate(primary[i] ^ primary[i - 1]);
-	dest[idx++] = translate(primary[PRIMARY_BUF_LEN - 1]);   // data checksum
+		*o++ = (src[i] >> 2) ^ (src[i - 1] >> 2);
+	*o++ = src[PRIMARY_BUF_LEN - 1] >> 2;   // data checksum
+	gcr6_encode_block(dest, DATA_LEN + 1);
 }
 
 // Build one full 6656-byte NIB track from a 4096-byte DOS-order track.
@@ -279,9 +489,7 @@ static void nib_track_from_dsk(uint8_t *nibtrack, const uint8_t *dsktrack, int t
 {
 	for (int phys = 0; phys < A2_SECTORS_PER_TRACK; phys++) {
 		// physical position -> logical sector
-		int logical = 0;
-		for (int i = 0; i < A2_SECTORS_PER_TRACK; i++)
-			if (phys_interleave[i] == phys) { logical = i; break; }
+		int logical = phys_to_logical_525[phys];
 
 		int soft = soft_interleave[logical];
 		const uint8_t *sec = dsktrack + soft * A2_SECTOR_SIZE;
@@ -314,53 +522,70 @@ void a2_dsk_to_nib(uint8_t *nib, const uint8_t *dsk)
 		                   dsk + (size_t)t * A2_TRACK_SIZE, t);
 }
 
+#define SCAN_ADDR_TO_DATA 64     // max bytes from address epilogue to data mark
+
 // Parse one NIB sector out of a byte stream. Returns 1 and fills sector/track
 // on success. State machine ported from dsk2nib_lib.cpp parse_nib_sector.
-static int parse_nib_sector(const uint8_t *d, int len, uint8_t *out256, int *track, int *sector)
+// With check set, the address-field checksum, every data nibble and the data
+// checksum must be valid too, and the data mark must follow the address field
+// closely (otherwise a damaged data mark pairs this address with the next
+// sector's data), or the sector is rejected.
+static int parse_nib_sector(const uint8_t *d, int len, uint8_t *out256, int *track, int *sector, int check)
 {
-	int pos = 0, state = 0;
-	uint8_t primary[PRIMARY_BUF_LEN], secondary[SECONDARY_BUF_LEN], checksum;
+	int pos = 0, state = 0, addr_end = 0;
+	uint8_t primary[PRIMARY_BUF_LEN], secondary[SECONDARY_BUF_LEN], checksum, volume = 0;
 
 	while (pos < len) {
 		uint8_t b = d[pos++];
+		if (check && state >= 7 && pos - addr_end > SCAN_ADDR_TO_DATA) return 0;
 		switch (state) {
 		case 0: if (b == 0xd5) state = 1; break;
 		case 1: state = (b == 0xaa) ? 2 : 0; break;
 		case 2: state = (b == 0x96) ? 3 : 0; break;
-		case 3: if (pos >= len) return 0; odd_even_decode(b, d[pos++]); state = 4; break; // volume
+		case 3: if (pos >= len) return 0; volume = odd_even_decode(b, d[pos++]); state = 4; break;
 		case 4: if (pos >= len) return 0; *track  = odd_even_decode(b, d[pos++]); state = 5; break;
 		case 5: if (pos >= len) return 0; *sector = odd_even_decode(b, d[pos++]); state = 6; break;
-		case 6: if (pos >= len) return 0; pos++;  state = 7; break;  // checksum (ignored)
+		case 6:
+			if (pos >= len) return 0;
+			if (check && (uint8_t)(volume ^ *track ^ *sector) != odd_even_decode(b, d[pos])) return 0;
+			pos++;
+			addr_end = pos;
+			state = 7;
+			break;
 		case 7: if (b == 0xde) state = 8; break;
 		case 8: state = (b == 0xaa) ? 9 : 7; break;
 		case 9: if (b == 0xd5) state = 10; break;
 		case 10: state = (b == 0xaa) ? 11 : 9; break;
 		case 11: state = (b == 0xad) ? 12 : 9; break;
 		case 12: {
-			checksum = untranslate(b);
-			secondary[0] = checksum;
-			for (int i = 1; i < SECONDARY_BUF_LEN; i++) {
-				if (pos >= len) return 0;
-				checksum ^= untranslate(d[pos++]);
+			// b is the first data nibble; the field needs DATA_LEN more bytes
+			// (341 data + checksum), all of which must be in range
+			if (len - pos < DATA_LEN) return 0;
+			const uint8_t *p = d + pos - 1;
+			checksum = 0;
+			for (int i = 0; i < SECONDARY_BUF_LEN; i++) {
+				checksum ^= untranslate(*p++);
 				secondary[i] = checksum;
 			}
 			for (int i = 0; i < PRIMARY_BUF_LEN; i++) {
-				if (pos >= len) return 0;
-				checksum ^= untranslate(d[pos++]);
+				checksum ^= untranslate(*p++);
 				primary[i] = checksum;
 			}
-			if (pos >= len) return 0;
-			checksum ^= untranslate(d[pos++]);   // data checksum (ignored)
+			if (check) {
+				// every nibble a valid disk byte, and the running XOR ends at zero
+				uint8_t bad = 0;
+				for (int i = 0; i <= DATA_LEN; i++) bad |= gcr6_inv[d[pos - 1 + i]];
+				if ((bad & 0x80) || (checksum ^ untranslate(*p))) return 0;
+			}
 
-			for (int i = 0; i < PRIMARY_BUF_LEN; i++) {
-				int index = i % SECONDARY_BUF_LEN;
-				uint8_t bit0, bit1;
-				switch (i / SECONDARY_BUF_LEN) {
-				case 0: bit0 = (secondary[index] & 2) > 0; bit1 = (secondary[index] & 1) > 0; break;
-				case 1: bit0 = (secondary[index] & 8) > 0; bit1 = (secondary[index] & 4) > 0; break;
-				default: bit0 = (secondary[index] & 0x20) > 0; bit1 = (secondary[index] & 0x10) > 0; break;
-				}
-				out256[i] = (primary[i] << 2) | (bit1 << 1) | bit0;
+			for (int i = 0; i < SECONDARY_BUF_LEN; i++) {
+				uint8_t s = secondary[i];
+				out256[i] = (uint8_t)((primary[i] << 2) | swap2[s & 3]);
+				out256[i + SECONDARY_BUF_LEN] =
+					(uint8_t)((primary[i + SECONDARY_BUF_LEN] << 2) | swap2[(s >> 2) & 3]);
+				if (i + 2 * SECONDARY_BUF_LEN < PRIMARY_BUF_LEN)
+					out256[i + 2 * SECONDARY_BUF_LEN] =
+						(uint8_t)((primary[i + 2 * SECONDARY_BUF_LEN] << 2) | swap2[(s >> 4) & 3]);
 			}
 			return 1;
 		}
@@ -370,22 +595,38 @@ static int parse_nib_sector(const uint8_t *d, int len, uint8_t *out256, int *tra
 	return 0;
 }
 
-// Parse one 6656-byte NIB track into a 4096-byte DOS-order track. Returns the
-// number of sectors recovered.
-static int nib_track_to_dsk_track(const uint8_t *nt, uint8_t *dt)
+// Parse a track's disk bytes (a 6656-byte NIB track, or a framed WOZ track)
+// into a 4096-byte DOS-order track. Sector searches start below lim; a parse
+// may read on up to len. Returns the number of sectors recovered and, if seen
+// is given, ORs in a bit per logical sector found. check_track < 0 takes
+// sectors as they parse; otherwise only sectors whose checksums verify and
+// whose address field names that track are stored.
+static int nib_track_to_dsk_track(const uint8_t *nt, int len, int lim, uint8_t *dt, unsigned *seen,
+                                  int check_track)
 {
+	int check = check_track >= 0;
 	int got = 0, pos = 0;
-	while (pos < A2_NIB_TRACK_SIZE - 400) {
+	while (pos < lim) {
 		uint8_t sec[A2_SECTOR_SIZE];
 		int tr, s;
-		if (parse_nib_sector(nt + pos, A2_NIB_TRACK_SIZE - pos, sec, &tr, &s)) {
-			if (s >= 0 && s < A2_SECTORS_PER_TRACK) {
+		// The parser idles in state 0 until it sees $D5, so starting anywhere
+		// before the next $D5 behaves exactly like starting on it. Hop there
+		// instead of rescanning the rest of the track once per byte.
+		int from = pos;
+		if (nt[pos] != 0xd5) {
+			const uint8_t *q = (const uint8_t *)memchr(nt + pos, 0xd5, len - pos);
+			from = q ? (int)(q - nt) : len;
+		}
+		if (from < len &&
+		    parse_nib_sector(nt + from, len - from, sec, &tr, &s, check)) {
+			if (s >= 0 && s < A2_SECTORS_PER_TRACK && (!check || tr == check_track)) {
 				memcpy(dt + soft_interleave[s] * A2_SECTOR_SIZE, sec, A2_SECTOR_SIZE);
+				if (seen) *seen |= 1u << s;
 				got++;
 			}
 			pos += BYTES_PER_NIB_SECTOR;
 		} else {
-			pos++;
+			pos = from + 1;   // every start in [pos, from] fails the same way
 		}
 	}
 	return got;
@@ -396,7 +637,8 @@ int a2_nib_to_dsk(uint8_t *dsk, const uint8_t *nib)
 	int ok = 1;
 	for (int t = 0; t < A2_TRACKS_525; t++) {
 		int got = nib_track_to_dsk_track(nib + (size_t)t * A2_NIB_TRACK_SIZE,
-		                                 dsk + (size_t)t * A2_TRACK_SIZE);
+		                                 A2_NIB_TRACK_SIZE, A2_NIB_TRACK_SIZE - 400,
+		                                 dsk + (size_t)t * A2_TRACK_SIZE, NULL, -1);
 		if (got < A2_SECTORS_PER_TRACK) ok = 0;
 	}
 	return ok;
@@ -428,7 +670,7 @@ size_t a2_dsk_to_woz525(uint8_t *woz, size_t woz_cap, const uint8_t *dsk)
 	memset(woz, 0, WOZ525_SIZE);
 
 	// nibblize all tracks first
-	static uint8_t nib[A2_NIB_IMAGE_SIZE];
+	static thread_local uint8_t nib[A2_NIB_IMAGE_SIZE];
 	a2_dsk_to_nib(nib, dsk);
 
 	uint8_t *p = woz;
@@ -490,56 +732,63 @@ size_t a2_dsk_to_woz525(uint8_t *woz, size_t woz_cap, const uint8_t *dsk)
 	return WOZ525_SIZE;
 }
 
-// Locate a chunk by id; returns pointer to its data and fills *out_size, or NULL.
-static const uint8_t *woz_find_chunk(const uint8_t *woz, size_t size,
-                                     const char *id, uint32_t *out_size)
+// Framed-track scratch size; WOZ tracks are at most a few hundred bits over
+// 6656 bytes, copy-protected ones included.
+#define WOZ_FRAME_MAX   (16 * 1024)
+#define WOZ525_WRAP     512             // bytes of the track start re-read past the index
+
+// Frame one 5.25" track (quarter-track 4*track via TMAP) and pull its
+// sectors. The track is a loop, so the first WOZ525_WRAP bytes' worth of bits
+// are appended after the last bit and framed in one pass: a sector that
+// straddles the index, or one misframed at bit 0, is then read in sync on the
+// second go. Sectors seen twice carry the same bits, so only distinct sectors
+// are counted.
+static int woz525_track_to_dsk(const uint8_t *woz, size_t woz_size, int track, uint8_t *dt, int check)
 {
-	size_t pos = 12;
-	while (pos + 8 <= size) {
-		uint32_t csize = rd_le32(woz + pos + 4);
-		if (memcmp(woz + pos, id, 4) == 0) {
-			if (out_size) *out_size = csize;
-			return woz + pos + 8;
+	const uint8_t *bits;
+	uint32_t bit_count;
+	int trk = woz_tmap(woz, woz_size, track * 4);
+	if (trk < 0 || !woz_track_bits(woz, woz_size, trk, &bits, &bit_count)) return 0;
+
+	static thread_local uint8_t loop[WOZ_FRAME_MAX + WOZ525_WRAP + 1];
+	static thread_local uint8_t bytes[WOZ_FRAME_MAX + WOZ525_WRAP];
+	uint32_t total = bit_count;
+	if ((bit_count + 7) / 8 <= WOZ_FRAME_MAX) {
+		memcpy(loop, bits, (bit_count + 7) / 8);
+		for (uint32_t i = 0; i < WOZ525_WRAP * 8; i++) {
+			uint32_t from = i % bit_count, to = bit_count + i;
+			uint8_t m = (uint8_t)(0x80 >> (to & 7));
+			if ((bits[from >> 3] << (from & 7)) & 0x80) loop[to >> 3] |= m;
+			else                                         loop[to >> 3] &= (uint8_t)~m;
 		}
-		pos += 8 + csize;
+		bits = loop;
+		total = bit_count + WOZ525_WRAP * 8;
 	}
-	return NULL;
+	int n = woz_frame_bits(bits, total, bytes, sizeof(bytes));
+
+	unsigned seen = 0;
+	nib_track_to_dsk_track(bytes, n, n, dt, &seen, check ? track : -1);
+	int got = 0;
+	for (; seen; seen &= seen - 1) got++;
+	return got;
 }
 
 int a2_woz525_to_dsk(uint8_t *dsk, const uint8_t *woz, size_t woz_size)
 {
 	if (woz_disk_type(woz, woz_size) != 1) return 0;
-	const uint8_t *trks = woz_find_chunk(woz, woz_size, "TRKS", NULL);
-	if (!trks) return 0;
-
-	static uint8_t nib[A2_NIB_IMAGE_SIZE];
-	memset(nib, 0, sizeof(nib));
-
-	for (int t = 0; t < A2_TRACKS_525; t++) {
-		const uint8_t *e = trks + t * 8;
-		uint16_t start_block = rd_le16(e + 0);
-		uint16_t block_cnt   = rd_le16(e + 2);
-		if (block_cnt == 0) continue;
-		size_t off = (size_t)start_block * A2_BLOCK_SIZE;
-		if (off + A2_NIB_TRACK_SIZE > woz_size) return 0;
-		memcpy(nib + (size_t)t * A2_NIB_TRACK_SIZE, woz + off, A2_NIB_TRACK_SIZE);
-	}
-	return a2_nib_to_dsk(dsk, nib);
+	int ok = 1;
+	for (int t = 0; t < A2_TRACKS_525; t++)
+		if (woz525_track_to_dsk(woz, woz_size, t, dsk + (size_t)t * A2_TRACK_SIZE, 0) < A2_SECTORS_PER_TRACK)
+			ok = 0;
+	return ok;
 }
 
 // Decode a single 5.25" track from a WOZ into dsk (143360) at track*4096.
-int a2_woz525_decode_track(const uint8_t *woz, size_t woz_size, int track, uint8_t *dsk)
+int a2_woz525_decode_track(const uint8_t *woz, size_t woz_size, int track, uint8_t *dsk, int check)
 {
 	if (woz_disk_type(woz, woz_size) != 1) return 0;
-	const uint8_t *trks = woz_find_chunk(woz, woz_size, "TRKS", NULL);
-	if (!trks || track < 0 || track >= A2_TRACKS_525) return 0;
-	const uint8_t *e = trks + track * 8;
-	uint16_t start_block = rd_le16(e + 0);
-	uint16_t block_cnt   = rd_le16(e + 2);
-	if (block_cnt == 0) return 0;
-	size_t off = (size_t)start_block * A2_BLOCK_SIZE;
-	if (off + A2_NIB_TRACK_SIZE > woz_size) return 0;
-	return nib_track_to_dsk_track(woz + off, dsk + (size_t)track * A2_TRACK_SIZE);
+	if (track < 0 || track >= A2_TRACKS_525) return 0;
+	return woz525_track_to_dsk(woz, woz_size, track, dsk + (size_t)track * A2_TRACK_SIZE, check);
 }
 
 // Map a WOZ file LBA (512-block index) to its track index, or -1 (header/unmapped).
@@ -589,41 +838,67 @@ static int base_block_of_track(int nt)
 	return base;
 }
 
-// reverse 6-and-2 table (disk byte 0x80..0xFF -> 6-bit value; 0x80 = invalid)
-static uint8_t from_gcr6[128];
-static void init_from_gcr6(void)
-{
-	static int done = 0;
-	if (done) return;
-	memset(from_gcr6, 0x80, sizeof(from_gcr6));
-	for (int i = 0; i < 0x40; i++) from_gcr6[gcr6_table[i] - 0x80] = (uint8_t)i;
-	done = 1;
-}
-static inline uint8_t un62(uint8_t disk) { return (disk & 0x80) ? from_gcr6[disk - 0x80] : 0x80; }
+static inline uint8_t un62(uint8_t disk) { return gcr6_inv[disk]; }
 
 // ---- bit writer (MSB-first), matching Clemens' bit ordering ----
-typedef struct { uint8_t *buf; size_t cap; uint32_t bit; } BitW;
-static void bw_bits(BitW *w, uint32_t val, int nbits)
-{
-	for (int i = nbits - 1; i >= 0; i--) {
-		size_t byte = w->bit >> 3;
-		int off = 7 - (int)(w->bit & 7);
-		if (byte < w->cap) {
-			if (val & (1u << i)) w->buf[byte] |= (1 << off);
-			else                 w->buf[byte] &= ~(1 << off);
-		}
-		w->bit++;
+// Bits collect in a 64-bit accumulator and go out 32 at a time; bw_flush
+// writes the zero-padded tail. Bits past cap are counted but dropped.
+typedef struct { uint8_t *buf; size_t cap; uint32_t bit; uint64_t acc; int nacc; size_t pos; } BitW;
+
+static inline void bw_put32(BitW *w, uint32_t v)
+{
+	if (w->pos + 4 <= w->cap) {
+		wr_be32(w->buf + w->pos, v);
+	} else {
+		for (int k = 0; k < 4; k++)
+			if (w->pos + k < w->cap) w->buf[w->pos + k] = (uint8_t)(v >> (24 - 8 * k));
+	}
+	w->pos += 4;
+}
+// nbits <= 32, val must fit in nbits
+static inline void bw_bits(BitW *w, uint32_t val, int nbits)
+{
+	w->acc = (w->acc << nbits) | val;
+	w->nacc += nbits;
+	w->bit += nbits;
+	if (w->nacc >= 32) {
+		w->nacc -= 32;
+		bw_put32(w, (uint32_t)(w->acc >> w->nacc));
+	}
+}
+static void bw_flush(BitW *w)
+{
+	while (w->nacc > 0) {
+		uint8_t v = (w->nacc >= 8) ? (uint8_t)(w->acc >> (w->nacc - 8))
+		                           : (uint8_t)(w->acc << (8 - w->nacc));
+		if (w->pos < w->cap) w->buf[w->pos] = v;
+		w->pos++;
+		w->nacc -= 8;
 	}
+	w->nacc = 0;
 }
 static inline void bw_byte(BitW *w, uint8_t v)   { bw_bits(w, v, 8); }
-static inline void bw_sync(BitW *w, int cnt)     { for (int i = 0; i < cnt; i++) bw_bits(w, 0xFF, 10); }
 static inline void bw_62(BitW *w, uint8_t v)     { bw_byte(w, gcr6_table[v & 0x3f]); }
+// 10-bit self-sync groups (two zero bits then $FF), three per 30-bit write
+static void bw_sync(BitW *w, int cnt)
+{
+	for (; cnt >= 3; cnt -= 3) bw_bits(w, (0xFFu << 20) | (0xFFu << 10) | 0xFFu, 30);
+	for (; cnt > 0; cnt--)     bw_bits(w, 0xFF, 10);
+}
+static void bw_bytes(BitW *w, const uint8_t *p, size_t n)
+{
+	for (; n >= 4; n -= 4, p += 4) bw_bits(w, rd_be32(p), 32);
+	for (; n > 0; n--) bw_byte(w, *p++);
+}
+
+#define GCR35_DATA_LEN 699      // 175 groups of 4, last group has 3
 
 // Encode one 512-byte sector's data field (12 tag + 512 data -> GCR + checksum).
 static void encode_data_35(BitW *w, const uint8_t *buf)
 {
 	uint8_t s0[175], s1[175], s2[175];
 	uint8_t data[524];
+	uint8_t out[GCR35_DATA_LEN + 4];
 	unsigned chk[3] = { 0, 0, 0 };
 	unsigned di = 0, si = 0;
 	uint8_t v;
@@ -654,31 +929,42 @@ static void encode_data_35(BitW *w, const uint8_t *buf)
 	}
 	s2[si++] = 0;
 
+	// gather the 6-bit groups, translate them in one pass, then emit
+	uint8_t *o = out;
 	for (unsigned i = 0; i < si; i++) {
-		uint8_t top = ((s0[i] & 0xc0) >> 2) | ((s1[i] & 0xc0) >> 4) | ((s2[i] & 0xc0) >> 6);
-		bw_62(w, top);
-		bw_62(w, s0[i]);
-		bw_62(w, s1[i]);
-		if (i < si - 1) bw_62(w, s2[i]);
+		*o++ = ((s0[i] & 0xc0) >> 2) | ((s1[i] & 0xc0) >> 4) | ((s2[i] & 0xc0) >> 6);
+		*o++ = s0[i];
+		*o++ = s1[i];
+		if (i < si - 1) *o++ = s2[i];
 	}
-	uint8_t top = ((chk[0] & 0xc0) >> 6) | ((chk[1] & 0xc0) >> 4) | ((chk[2] & 0xc0) >> 2);
-	bw_62(w, top);
-	bw_62(w, chk[2]);
-	bw_62(w, chk[1]);
-	bw_62(w, chk[0]);
+	*o++ = ((chk[0] & 0xc0) >> 6) | ((chk[1] & 0xc0) >> 4) | ((chk[2] & 0xc0) >> 2);
+	*o++ = (uint8_t)chk[2];
+	*o++ = (uint8_t)chk[1];
+	*o++ = (uint8_t)chk[0];
+	gcr6_encode_block(out, (size_t)(o - out));
+	bw_bytes(w, out, (size_t)(o - out));
 }
 
-// Decode one sector's 699-byte GCR data field back to 512 bytes. 1 ok.
-static int decode_data_35(const uint8_t *gcr, uint8_t *out512)
+// Decode one sector's 699-byte GCR data field back to 512 bytes. 1 ok. With
+// check set, the 4 checksum nibbles that follow the field must match too.
+static int decode_data_35(const uint8_t *gcr, uint8_t *out512, int check)
 {
+	// translate the whole field first; any invalid nibble sets bit 7
+	uint8_t six[GCR35_DATA_LEN];
+	uint8_t bad = 0;
+	for (int i = 0; i < GCR35_DATA_LEN; i++) {
+		six[i] = un62(gcr[i]);
+		bad |= six[i];
+	}
+	if (bad & 0x80) return 0;
+
 	uint8_t s0[175], s1[175], s2[175];
-	const uint8_t *p = gcr;
+	const uint8_t *p = six;
 	for (int i = 0; i < 175; i++) {
-		uint8_t b = un62(*p++); if (b == 0x80) return 0;
-		uint8_t r0 = un62(*p++); if (r0 == 0x80) return 0;
-		uint8_t r1 = un62(*p++); if (r1 == 0x80) return 0;
-		uint8_t r2 = 0;
-		if (i < 174) { r2 = un62(*p++); if (r2 == 0x80) return 0; }
+		uint8_t b  = *p++;
+		uint8_t r0 = *p++;
+		uint8_t r1 = *p++;
+		uint8_t r2 = (i < 174) ? *p++ : 0;
 		s0[i] = (uint8_t)(((b << 2) & 0xc0) | r0);
 		s1[i] = (uint8_t)(((b << 4) & 0xc0) | r1);
 		s2[i] = (uint8_t)(((b << 6) & 0xc0) | r2);
@@ -706,6 +992,15 @@ static int decode_data_35(const uint8_t *gcr, uint8_t *out512)
 		data[di++] = v2;
 	}
 	memcpy(out512, data + TAG35, 512);
+	if (check) {
+		const uint8_t *c = gcr + GCR35_DATA_LEN;
+		uint8_t hi = un62(c[0]), c2 = un62(c[1]), c1 = un62(c[2]), c0 = un62(c[3]);
+		if ((hi | c2 | c1 | c0) & 0x80) return 0;
+		if ((uint8_t)(((hi << 2) & 0xc0) | c2) != (uint8_t)chk[2] ||
+		    (uint8_t)(((hi << 4) & 0xc0) | c1) != (uint8_t)chk[1] ||
+		    (uint8_t)(((hi << 6) & 0xc0) | c0) != (uint8_t)chk[0])
+			return 0;
+	}
 	return 1;
 }
 
@@ -785,13 +1080,13 @@ size_t a2_po_to_woz35(uint8_t *woz, size_t woz_cap, const uint8_t *po)
 	uint8_t *trk_dir = p + 8;
 	memset(trk_dir, 0, WOZ_TRK_DIR);
 
-	static uint8_t tmp[16 * 1024];
+	static thread_local uint8_t tmp[16 * 1024];
 	int block = WOZ525_FIRST_BLOCK;
 	int largest = 0;
 	for (int nt = 0; nt < NT35; nt++) {
-		memset(tmp, 0, sizeof(tmp));
-		BitW w = { tmp, sizeof(tmp), 0 };
+		BitW w = { tmp, sizeof(tmp), 0, 0, 0, 0 };   // flush writes every byte it covers
 		encode_track_35(&w, nt, po);
+		bw_flush(&w);
 		uint32_t bits = w.bit;
 		uint32_t bytes = (bits + 7) / 8;
 		uint16_t blocks = (uint16_t)((bytes + A2_BLOCK_SIZE - 1) / A2_BLOCK_SIZE);
@@ -818,60 +1113,45 @@ size_t a2_po_to_woz35(uint8_t *woz, size_t woz_cap, const uint8_t *po)
 	return total;
 }
 
-// Frame a track's WOZ BITS into disk bytes (simple self-sync framer).
-static int frame_track(const uint8_t *bits, uint32_t bit_count, uint8_t *out, int out_cap)
-{
-	int n = 0;
-	uint8_t reg = 0;
-	for (uint32_t i = 0; i < bit_count; i++) {
-		int bit = (bits[i >> 3] >> (7 - (i & 7))) & 1;
-		reg = (uint8_t)((reg << 1) | bit);
-		if (reg & 0x80) {
-			if (n < out_cap) out[n++] = reg;
-			reg = 0;
-		}
-	}
-	return n;
-}
-
 // Decode a single 3.5" track nt into po (819200). Reports the ProDOS block range
-// written via *base_block / *block_count. Returns the number of sectors decoded.
+// written via *base_block / *block_count. Returns the number of distinct sectors
+// decoded; with check set only sectors whose data checksum verifies are stored.
 int a2_woz35_decode_track(const uint8_t *woz, size_t woz_size, int nt, uint8_t *po,
-                          int *base_block, int *block_count)
+                          int *base_block, int *block_count, int check)
 {
-	init_from_gcr6();
 	if (nt < 0 || nt >= NT35) return 0;
-	const uint8_t *trks = woz_find_chunk(woz, woz_size, "TRKS", NULL);
-	if (!trks) return 0;
-
-	const uint8_t *e = trks + nt * 8;
-	uint16_t start_block = rd_le16(e + 0);
-	uint16_t blk_cnt     = rd_le16(e + 2);
-	uint32_t bit_count   = rd_le32(e + 4);
-	if (blk_cnt == 0 || bit_count == 0) return 0;
-	size_t off = (size_t)start_block * A2_BLOCK_SIZE;
-	if (off + (size_t)blk_cnt * A2_BLOCK_SIZE > woz_size) return 0;
+	const uint8_t *bits;
+	uint32_t bit_count;
+	if (!woz_track_bits(woz, woz_size, nt, &bits, &bit_count)) return 0;
 
-	static uint8_t bytes[20 * 1024];
-	int n = frame_track(woz + off, bit_count, bytes, sizeof(bytes));
+	static thread_local uint8_t bytes[20 * 1024];
+	int n = woz_frame_bits(bits, bit_count, bytes, sizeof(bytes));
 	int base = base_block_of_track(nt);
 	int want = sectors_per_region_35[region_of_track(nt)];
 	int got = 0;
+	unsigned seen = 0;
 
 	int i = 0;
 	while (i + 3 < n && got < want) {
-		if (bytes[i] == 0xd5 && bytes[i + 1] == 0xaa && bytes[i + 2] == 0xad) {
+		if (bytes[i] != 0xd5) {
+			const uint8_t *q = (const uint8_t *)memchr(bytes + i, 0xd5, n - i);
+			if (!q) break;
+			i = (int)(q - bytes);
+			continue;
+		}
+		if (bytes[i + 1] == 0xaa && bytes[i + 2] == 0xad) {
 			int dpos = i + 4;                        // skip mark(3) + spare(1)
-			if (dpos + 699 > n) break;
+			if (dpos + GCR35_DATA_LEN > n) break;
 			uint8_t lsec = un62(bytes[i + 3]);        // logical sector from spare byte
 			if (lsec < (uint8_t)want) {
 				uint8_t sec[512];
-				if (decode_data_35(bytes + dpos, sec)) {
+				if (decode_data_35(bytes + dpos, sec, check)) {
 					memcpy(po + (size_t)(base + lsec) * 512, sec, 512);
-					got++;
+					if (!(seen & 1u << lsec)) got++;
+					seen |= 1u << lsec;
 				}
 			}
-			i = dpos + 699;
+			i = dpos + GCR35_DATA_LEN;
 		} else {
 			i++;
 		}
@@ -886,10 +1166,111 @@ int a2_woz35_to_po(uint8_t *po, const uint8_t *woz, size_t woz_size)
 	if (woz_disk_type(woz, woz_size) != 2) return 0;
 	int placed = 0;
 	for (int nt = 0; nt < NT35; nt++)
-		placed += a2_woz35_decode_track(woz, woz_size, nt, po, NULL, NULL);
+		placed += a2_woz35_decode_track(woz, woz_size, nt, po, NULL, NULL, 0);
 	return placed == (A2_35_IMAGE_SIZE / 512) ? 1 : 0;
 }
 
+// ===========================================================================
+// sector-level track scan (checksums verified), for pre-screening WOZ images
+// ===========================================================================
+// XOR-chained 5.25" data field (6-and-2: 342+1, 5-and-3: 410+1 nibbles):
+// every nibble valid and the running XOR, checksum included, ends at zero.
+static int xor_field_ok(const uint8_t *p, int len, const uint8_t *inv)
+{
+	uint8_t x = 0, bad = 0;
+	for (int i = 0; i < len; i++) {
+		uint8_t v = inv[p[i]];
+		bad |= v;
+		x ^= v;
+	}
+	return !(bad & 0x80) && x == 0;
+}
+
+int a2_scan_track(const uint8_t *b, int n, int lim, int disk_type, int track, A2TrackScan *s)
+{
+	memset(s, 0, sizeof(*s));
+	if (lim > n) lim = n;
+	uint32_t seen = 0, seen13 = 0;
+	int sec = -1, sec_end = 0, five3 = 0;
+
+	int i = 0;
+	while (i + 2 < n) {
+		if (b[i] != 0xd5) {
+			const uint8_t *q = (const uint8_t *)memchr(b + i, 0xd5, n - i);
+			if (!q) break;
+			i = (int)(q - b);
+			continue;
+		}
+		if (b[i + 1] != 0xaa) { i++; continue; }
+		int count = i < lim;
+		uint8_t m = b[i + 2];
+
+		if (m == 0x96 || (m == 0xb5 && disk_type == 1)) {
+			// address field: 5.25" 4-and-4 vol/trk/sec/sum, 3.5" 6-and-2
+			// trk/sec/side/fmt/sum; either way the epilogue is DE AA
+			const uint8_t *p = b + i + 3;
+			int len = disk_type == 1 ? 8 : 5;
+			if (i + 3 + len + 2 > n) break;
+			int ok = 1, trk = 0;
+			sec = -1;
+			if (disk_type == 1) {
+				for (int k = 0; k < 8; k++) if ((p[k] & 0xaa) != 0xaa) ok = 0;
+				uint8_t v = odd_even_decode(p[0], p[1]), t = odd_even_decode(p[2], p[3]);
+				uint8_t sc = odd_even_decode(p[4], p[5]), ck = odd_even_decode(p[6], p[7]);
+				if (v ^ t ^ sc ^ ck) ok = 0;
+				trk = t;
+				if (ok) sec = sc & 0x1f;
+			} else {
+				uint8_t v[5], bad = 0;
+				for (int k = 0; k < 5; k++) bad |= (v[k] = un62(p[k]));
+				if ((bad & 0x80) || (v[0] ^ v[1] ^ v[2] ^ v[3] ^ v[4])) ok = 0;
+				trk = v[0] | ((v[2] & 0x1f) << 6);
+				if (ok) sec = v[1] & 0x1f;
+			}
+			int end = i + 3 + len;
+			if (count) {
+				s->addr_fields++;
+				if (!ok) s->addr_bad++;
+				else {
+					if (trk != track) s->wrong_track++;
+					if (b[end] != 0xde || b[end + 1] != 0xaa) s->epilog_bad++;
+				}
+			}
+			five3 = m == 0xb5;
+			sec_end = end;
+			i = end;
+		} else if (m == 0xad) {
+			int hdr = disk_type == 1 ? 3 : 4;      // 3.5" adds a sector byte
+			int len = disk_type == 1 ? (five3 ? 411 : 343) : GCR35_DATA_LEN + 4;
+			if (i + hdr + len > n) break;
+			int ok;
+			if (disk_type == 1) {
+				ok = xor_field_ok(b + i + 3, len, five3 ? gcr5_inv : gcr6_inv);
+			} else {
+				uint8_t tmp[512];
+				ok = decode_data_35(b + i + 4, tmp, 1);
+			}
+			if (count) {
+				if (ok) s->data_ok++;
+				else    s->data_bad++;
+			}
+			if (ok && sec >= 0 && i - sec_end <= SCAN_ADDR_TO_DATA) {
+				if (five3) seen13 |= 1u << sec;
+				else       seen   |= 1u << sec;
+			}
+			sec = -1;
+			i += hdr + len;
+		} else {
+			if (count) s->odd_prologs++;
+			i += 3;
+		}
+	}
+	for (; seen; seen &= seen - 1) s->sectors++;
+	for (; seen13; seen13 &= seen13 - 1) s->sectors13++;
+	s->sectors += s->sectors13;
+	return s->sectors;
+}
+
 // ===========================================================================
 // classification
 // ===========================================================================
@@ -87,6 +87,18 @@ size_t dc42_build(uint8_t *out, size_t out_cap, const uint8_t *payload,
 int woz_disk_type(const uint8_t *buf, size_t size);
 // zlib-compatible CRC32 (poly 0xEDB88320), init 0.
 uint32_t woz_crc32(const uint8_t *data, size_t len);
+// Locate a chunk by id; returns a pointer to its data (fills *out_size), or NULL.
+const uint8_t *woz_find_chunk(const uint8_t *woz, size_t size, const char *id, uint32_t *out_size);
+// TMAP entry idx (quarter-track for 5.25", track*2+side for 3.5") -> TRKS
+// index, or -1 if unmapped / no TMAP.
+int woz_tmap(const uint8_t *woz, size_t size, int idx);
+// Bitstream of TRKS entry trk (WOZ1 or WOZ2). Returns 1 and fills bits /
+// bit_count, 0 if the track is absent or out of range of the file.
+int woz_track_bits(const uint8_t *woz, size_t size, int trk,
+                   const uint8_t **bits, uint32_t *bit_count);
+// Self-sync framer: turns a WOZ bitstream into disk bytes the way the IWM
+// latch does (shift until bit 7 set). Returns bytes written (<= out_cap).
+int woz_frame_bits(const uint8_t *bits, uint32_t bit_count, uint8_t *out, int out_cap);
 
 // ---- 140K sector order (DOS 3.3 <-> ProDOS) ----
 // dst and src are 143360-byte 5.25" images; in-place safe only if dst!=src.
@@ -102,6 +114,7 @@ int  a2_nib_to_dsk(uint8_t *dsk, const uint8_t *nib);   // 1 if all tracks parse
 // ---- 5.25" "easy WOZ" (DOS-order DSK <-> WOZ2) ----
 // Builds a fully-allocated standard-layout WOZ2 (all 35 tracks present) so the
 // core can read and write it; trivially reversible. Returns bytes written / 0.
+// The decode side frames each track's bits, so it also reads real WOZ1/WOZ2.
 size_t a2_dsk_to_woz525(uint8_t *woz, size_t woz_cap, const uint8_t *dsk);
 int    a2_woz525_to_dsk(uint8_t *dsk, const uint8_t *woz, size_t woz_size);
 
@@ -116,11 +129,35 @@ int    a2_woz35_to_po(uint8_t *po, const uint8_t *woz, size_t woz_size);
 // ---- per-track decode + LBA mapping (for floppy write-back) ----
 // Map a WOZ file LBA (512-block index) to its track index, or -1 (header/unmapped).
 int a2_woz_track_for_lba(const uint8_t *woz, size_t woz_size, uint32_t lba);
+// check: only store sectors that verify (data checksum; on 5.25" also the
+// address checksum and track number), leaving the rest of the buffer untouched.
+// Both return the number of distinct sectors stored.
 // 3.5": decode one track into po (819200); reports the ProDOS block range written.
 int a2_woz35_decode_track(const uint8_t *woz, size_t woz_size, int track, uint8_t *po,
-                          int *base_block, int *block_count);
+                          int *base_block, int *block_count, int check);
 // 5.25": decode one track into dsk (143360) at track*4096 (16 sectors, DOS order).
-int a2_woz525_decode_track(const uint8_t *woz, size_t woz_size, int track, uint8_t *dsk);
+// Frames the track bits, so any bit alignment (e.g. after an IWM write) parses.
+int a2_woz525_decode_track(const uint8_t *woz, size_t woz_size, int track, uint8_t *dsk, int check);
+
+// ---- sector-level track scan (pre-screening) ----
+// Walks framed disk bytes (woz_frame_bits output) the way RWTS / the 3.5"
+// driver would, verifying address and data field checksums. Counters cover
+// marks that start before lim (so a caller can append a wrapped copy of the
+// track start without double counting); fields may extend up to n.
+typedef struct {
+	int addr_fields;     // address marks (D5 AA 96, or D5 AA B5 on 5.25")
+	int addr_bad;        // ... with an invalid nibble or checksum
+	int epilog_bad;      // good address field not followed by DE AA
+	int wrong_track;     // good address field naming another track
+	int data_ok;         // data fields (D5 AA AD) whose checksum verifies
+	int data_bad;        // data fields with an invalid nibble or checksum
+	int odd_prologs;     // D5 AA xx marks with any other third byte
+	int sectors;         // distinct sectors read (good address + data)
+	int sectors13;       // of those, 13-sector (5-and-3) sectors
+} A2TrackScan;
+// disk_type: 1 = 5.25", 2 = 3.5". track: the track (5.25") or cylinder (3.5")
+// the bytes came from. Returns s->sectors.
+int a2_scan_track(const uint8_t *bytes, int n, int lim, int disk_type, int track, A2TrackScan *s);
 
 #ifdef __cplusplus
 }
@@ -2,31 +2,172 @@
 #include <iostream>
 #include <fstream>
 #include <list>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+#include <SDL.h>
 using namespace std;
 
-SimClock clk;
 bool outputToFile;
 ofstream audioFile;
 
+// ---------------------------------------------------------------------------
+// SPSC ring
+// ---------------------------------------------------------------------------
+bool SimAudioRing::Push(int16_t l, int16_t r) {
+	uint32_t h = head.load(std::memory_order_relaxed);
+	if (h - tail.load(std::memory_order_acquire) >= kFrames) return false;
+	buf[(h & (kFrames - 1)) * 2] = l;
+	buf[(h & (kFrames - 1)) * 2 + 1] = r;
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+bool SimAudioRing::Pop(int16_t &l, int16_t &r) {
+	uint32_t t = tail.load(std::memory_order_relaxed);
+	if (head.load(std::memory_order_acquire) == t) return false;
+	l = buf[(t & (kFrames - 1)) * 2];
+	r = buf[(t & (kFrames - 1)) * 2 + 1];
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+uint32_t SimAudioRing::Size() const {
+	return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+void SimAudioRing::Clear() {
+	tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------------
+// producer (sim thread)
+// ---------------------------------------------------------------------------
+static uint64_t now_ns() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void sdl_audio_callback(void *userdata, Uint8 *stream, int len) {
+	((SimAudio *)userdata)->Fill((int16_t *)stream, len / 4);
+}
+
 SimAudio::SimAudio(int systemClockFrequency, bool saveToFile)
 {
-	clk = SimClock(systemClockFrequency / 44100);
+	input_rate = systemClockFrequency;
 	outputToFile = saveToFile;
+	debug_pos = 0;
+	BuildFilter();
+}
+
+// Blackman-windowed sinc, cutoff at 0.42 x the output rate, unity DC gain.
+// Relative to the oversampled rate, so it does not depend on sample_rate.
+void SimAudio::BuildFilter() {
+	double fc = 0.42 / kOversample, sum = 0;
+	for (int k = 0; k < kTaps; k++) {
+		double m = k - (kTaps - 1) / 2.0;
+		double x = 2.0 * M_PI * fc * m;
+		double s = m == 0 ? 2.0 * fc : sin(x) / (M_PI * m);
+		double w = 0.42 - 0.5 * cos(2.0 * M_PI * k / (kTaps - 1)) + 0.08 * cos(4.0 * M_PI * k / (kTaps - 1));
+		taps[k] = (float)(s * w);
+		sum += taps[k];
+	}
+	for (int k = 0; k < kTaps; k++) taps[k] = (float)(taps[k] / sum);
+	memset(hist_l, 0, sizeof(hist_l));
+	memset(hist_r, 0, sizeof(hist_r));
 }
 
 SimAudio::~SimAudio()
 {
-
+	capture.Close();
 }
 
+// Called on every 14M rising edge. The core's output only changes at the
+// DOC sample rate, so the common path is two adds and a compare.
 void SimAudio::Clock(signed short left, signed short right) {
-	clk.Tick();
-	if (clk.IsRising()) {
-		// Output audio (left channel only for now)
-		float l = left / 32768.0f;
-		if (outputToFile) {
-			audioFile.write((const char*)&l, sizeof(float));
+	acc_l += left;
+	acc_r += right;
+	acc_n++;
+	phase += (int64_t)sample_rate * kOversample;
+	if (phase < input_rate) return;
+	phase -= input_rate;
+
+	// stage 1 done: one boxcar-averaged frame at kOversample x the output rate
+	float l = (float)acc_l / acc_n, r = (float)acc_r / acc_n;
+	acc_l = acc_r = 0;
+	acc_n = 0;
+	hist_l[hist_pos] = hist_l[hist_pos + kTaps] = l;
+	hist_r[hist_pos] = hist_r[hist_pos + kTaps] = r;
+	if (++hist_pos == kTaps) hist_pos = 0;
+	if (++decim < kOversample) return;
+	decim = 0;
+
+	// stage 2: low-pass FIR evaluated only at the decimated instants
+	float sl = 0, sr = 0;
+	const float *hl = hist_l + hist_pos, *hr = hist_r + hist_pos;
+	for (int k = 0; k < kTaps; k++) {
+		sl += taps[k] * hl[k];
+		sr += taps[k] * hr[k];
+	}
+	Emit(sl, sr);
+}
+
+void SimAudio::Emit(float l, float r) {
+	int il = (int)lrintf(l), ir = (int)lrintf(r);
+	int16_t sl = (int16_t)(il > 32767 ? 32767 : il < -32768 ? -32768 : il);
+	int16_t sr = (int16_t)(ir > 32767 ? 32767 : ir < -32768 ? -32768 : ir);
+	if (playing && !ring.Push(sl, sr)) overruns++;
+	if (outputToFile) {
+		// raw interleaved 16-bit stereo at sample_rate (no header)
+		int16_t f[2] = { sl, sr };
+		audioFile.write((const char*)f, sizeof(f));
+	}
+	if (capture.active) capture.Put(sl, sr);
+	if ((++produced & 1023) == 0) Report();
+}
+
+void SimAudio::Report() {
+	uint64_t t = now_ns();
+	if (!report_ticks) { report_ticks = t; report_produced = produced; return; }
+	uint64_t dt = t - report_ticks;
+	if (dt < 500000000ull) return;
+	sim_speed = (float)((double)(produced - report_produced) / sample_rate / (dt * 1e-9));
+	buffered_ms = 1000.0f * ring.Size() / sample_rate;
+	underruns = underrun_frames.load(std::memory_order_relaxed);
+	report_ticks = t;
+	report_produced = produced;
+}
+
+// ---------------------------------------------------------------------------
+// consumer (SDL audio thread)
+// ---------------------------------------------------------------------------
+// Never waits on the sim. On underrun the last frame decays towards zero
+// (no click), and playback re-primes until a few blocks are queued so a slow
+// sim plays in short bursts rather than sample-by-sample crackle.
+void SimAudio::Fill(int16_t *out, int frames) {
+	if (priming && ring.Size() < (uint32_t)frames * 2) {
+		for (int i = 0; i < frames; i++) {
+			last_l = (int16_t)(last_l * 255 / 256);
+			last_r = (int16_t)(last_r * 255 / 256);
+			out[i * 2] = last_l;
+			out[i * 2 + 1] = last_r;
+		}
+		return;
+	}
+	priming = false;
+	int missing = 0;
+	for (int i = 0; i < frames; i++) {
+		if (!ring.Pop(last_l, last_r)) {
+			last_l = (int16_t)(last_l * 255 / 256);
+			last_r = (int16_t)(last_r * 255 / 256);
+			missing++;
 		}
+		out[i * 2] = last_l;
+		out[i * 2 + 1] = last_r;
+	}
+	if (missing) {
+		priming = true;
+		underrun_frames.fetch_add(missing, std::memory_order_relaxed);
 	}
 }
 
@@ -47,6 +188,29 @@ void SimAudio::Initialise() {
 		debug_wave_r[c] = 0;
 		debug_positions[c] = (double)c / (double)debug_max_samples;
 	}
+
+	if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+		fprintf(stderr, "AUDIO: SDL audio unavailable: %s\n", SDL_GetError());
+	} else {
+		SDL_AudioSpec want, have;
+		SDL_zero(want);
+		want.freq = sample_rate;
+		want.format = AUDIO_S16SYS;
+		want.channels = 2;
+		want.samples = 1024;
+		want.callback = sdl_audio_callback;
+		want.userdata = this;
+		device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+		if (!device) {
+			fprintf(stderr, "AUDIO: cannot open output device: %s\n", SDL_GetError());
+		} else {
+			playing = true;
+			SDL_PauseAudioDevice(device, 0);
+			printf("AUDIO: %d Hz stereo, %d-frame device buffer, %u-frame ring\n",
+			       have.freq, have.samples, SimAudioRing::kFrames);
+		}
+	}
+
 	if (outputToFile)
 	{
 		// Setup Audio output stream
@@ -54,9 +218,209 @@ void SimAudio::Initialise() {
 	}
 }
 void SimAudio::CleanUp() {
+	capture.Close();
+	if (device) {
+		SDL_CloseAudioDevice(device);
+		device = 0;
+		playing = false;
+		printf("AUDIO: sim ran at %.0f%% of real time; %u underrun frames, %u overrun frames\n",
+		       sim_speed.load() * 100.0f, underrun_frames.load(), overruns.load());
+	}
 	if (outputToFile)
 	{
 		audioFile.close();
 	}
 }
 
+// ---------------------------------------------------------------------------
+// capture (--audio-out / --audio-fingerprint)
+// ---------------------------------------------------------------------------
+static void put_le(uint8_t *p, uint32_t v, int n) {
+	for (int i = 0; i < n; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+void SimAudioCapture::WriteHeader(uint32_t data_bytes) {
+	uint8_t h[44];
+	memcpy(h, "RIFF", 4);      put_le(h + 4, 36 + data_bytes, 4);
+	memcpy(h + 8, "WAVEfmt ", 8);
+	put_le(h + 16, 16, 4);      // fmt chunk size
+	put_le(h + 20, 1, 2);       // PCM
+	put_le(h + 22, 2, 2);       // stereo
+	put_le(h + 24, rate, 4);
+	put_le(h + 28, rate * 4, 4);
+	put_le(h + 32, 4, 2);       // block align
+	put_le(h + 34, 16, 2);      // bits per sample
+	memcpy(h + 36, "data", 4);  put_le(h + 40, data_bytes, 4);
+	fwrite(h, 1, sizeof(h), wav);
+}
+
+bool SimAudioCapture::OpenWav(const char *path, int sample_rate) {
+	wav = fopen(path, "wb");
+	if (!wav) {
+		fprintf(stderr, "AUDIO: cannot create %s\n", path);
+		return false;
+	}
+	rate = sample_rate;
+	WriteHeader(0);		// patched with the real sizes in Close()
+	block.reserve(kBlockFrames * 2);
+	stopping = false;
+	writer = std::thread(&SimAudioCapture::WriterLoop, this);
+	active = true;
+	return true;
+}
+
+bool SimAudioCapture::OpenFingerprint(const char *path, int sample_rate) {
+	fp = fopen(path, "w");
+	if (!fp) {
+		fprintf(stderr, "AUDIO: cannot create %s\n", path);
+		return false;
+	}
+	rate = sample_rate;
+	fprintf(fp, "# iigs audio fingerprint v1 rate=%d\n", rate);
+	fprintf(fp, "# frame  rms_l_db  rms_r_db  bands(<150,<300,<600,<1.2k,<2.4k,<4.8k,<9.6k,rest; hex = 6 dB steps above -96 dBFS)\n");
+	active = true;
+	return true;
+}
+
+void SimAudioCapture::WriterLoop() {
+	std::unique_lock<std::mutex> g(lock);
+	for (;;) {
+		wake.wait(g, [this] { return stopping || !queue.empty(); });
+		if (queue.empty()) break;	// stopping and drained
+		std::vector<int16_t> b = std::move(queue.front());
+		queue.pop_front();
+		g.unlock();
+		fwrite(b.data(), sizeof(int16_t), b.size(), wav);	// host is little-endian
+		g.lock();
+	}
+}
+
+void SimAudioCapture::Frame(int f) {
+	if (in_range && fp && fr_mono.size()) EmitFingerprint();
+	fr_mono.clear();
+	fr_sq_l = fr_sq_r = 0;
+	frame = f;
+	in_range = f >= first_frame && (last_frame < 0 || f <= last_frame);
+}
+
+void SimAudioCapture::Put(int16_t l, int16_t r) {
+	if (!in_range) return;
+	if (wav) {
+		block.push_back(l);
+		block.push_back(r);
+		wav_frames++;
+		if (block.size() >= (size_t)kBlockFrames * 2) {
+			{
+				std::lock_guard<std::mutex> g(lock);
+				queue.push_back(std::move(block));
+			}
+			wake.notify_one();
+			block = std::vector<int16_t>();
+			block.reserve(kBlockFrames * 2);
+		}
+	}
+	if (fp) {
+		float fl = l / 32768.0f, fr = r / 32768.0f;
+		fr_sq_l += fl * fl;
+		fr_sq_r += fr * fr;
+		fr_mono.push_back(0.5f * (fl + fr));
+	}
+}
+
+// In-place radix-2 FFT, n a power of two.
+static void fft(float *re, float *im, int n) {
+	for (int i = 1, j = 0; i < n; i++) {
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if (i < j) { std::swap(re[i], re[j]); std::swap(im[i], im[j]); }
+	}
+	for (int len = 2; len <= n; len <<= 1) {
+		double a = -2.0 * M_PI / len;
+		float wr = (float)cos(a), wi = (float)sin(a);
+		for (int i = 0; i < n; i += len) {
+			float cr = 1, ci = 0;
+			for (int k = 0; k < len / 2; k++) {
+				int p = i + k, q = p + len / 2;
+				float tr = re[q] * cr - im[q] * ci, ti = re[q] * ci + im[q] * cr;
+				re[q] = re[p] - tr; im[q] = im[p] - ti;
+				re[p] += tr;        im[p] += ti;
+				float nr = cr * wr - ci * wi;
+				ci = cr * wi + ci * wr;
+				cr = nr;
+			}
+		}
+	}
+}
+
+static float to_db(double ms) {
+	return ms > 1e-12 ? (float)(10.0 * log10(ms)) : -120.0f;
+}
+
+void SimAudioCapture::EmitFingerprint() {
+	static const int kN = 1024;
+	static const float edges[kBands] = { 150, 300, 600, 1200, 2400, 4800, 9600, 1e9f };
+	float re[kN], im[kN];
+	int n = (int)fr_mono.size();
+	const float *x = fr_mono.data();
+	if (n > kN) { x += n - kN; n = kN; }
+	double wsum = 0;
+	for (int i = 0; i < kN; i++) {
+		float w = i < n ? 0.5f - 0.5f * (float)cos(2.0 * M_PI * i / (n > 1 ? n - 1 : 1)) : 0.0f;
+		re[i] = i < n ? x[i] * w : 0.0f;
+		im[i] = 0;
+		wsum += (double)w * w;
+	}
+	fft(re, im, kN);
+
+	// one-sided band power, scaled so a band's value is its mean-square level
+	double band[kBands] = { 0 };
+	for (int k = 1; k < kN / 2; k++) {
+		float hz = (float)k * rate / kN;
+		int b = 0;
+		while (hz >= edges[b]) b++;
+		band[b] += 2.0 * ((double)re[k] * re[k] + (double)im[k] * im[k]);
+	}
+	char spec[kBands + 1];
+	for (int b = 0; b < kBands; b++) {
+		float db = to_db(wsum > 0 ? band[b] / (kN * wsum) : 0);
+		int q = (int)((db + 96.0f) / 6.0f);
+		spec[b] = "0123456789abcdef"[q < 0 ? 0 : q > 15 ? 15 : q];
+	}
+	spec[kBands] = 0;
+
+	int cnt = (int)fr_mono.size();
+	char line[96];
+	int len = snprintf(line, sizeof(line), "%d %.1f %.1f %s\n", frame,
+	                   to_db(fr_sq_l / cnt), to_db(fr_sq_r / cnt), spec);
+	fputs(line, fp);
+	for (int i = 0; i < len; i++) fp_hash = (fp_hash ^ (uint8_t)line[i]) * 16777619u;
+	fp_lines++;
+}
+
+void SimAudioCapture::Close() {
+	if (!active) return;
+	active = false;
+	if (wav) {
+		{
+			std::lock_guard<std::mutex> g(lock);
+			if (block.size()) queue.push_back(std::move(block));
+			stopping = true;
+		}
+		wake.notify_one();
+		writer.join();
+		uint64_t bytes = wav_frames * 4;
+		fseek(wav, 0, SEEK_SET);
+		WriteHeader(bytes > 0xFFFFFFD0ull ? 0xFFFFFFD0u : (uint32_t)bytes);
+		fclose(wav);
+		wav = nullptr;
+		printf("AUDIO: wrote %llu frames (%.2f s) to WAV\n",
+		       (unsigned long long)wav_frames, (double)wav_frames / rate);
+	}
+	if (fp) {
+		fprintf(fp, "# frames=%d hash=%08x\n", fp_lines, fp_hash);
+		fclose(fp);
+		fp = nullptr;
+		printf("AUDIO: fingerprint %d frames, hash %08x\n", fp_lines, fp_hash);
+	}
+}
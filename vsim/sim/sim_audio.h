@@ -1,23 +1,140 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdio.h>
+#include <stdint.h>
 #include "sim_clock.h"
 
+// Single-producer / single-consumer ring of stereo frames. The sim thread
+// pushes, the SDL audio callback pops; neither side locks or waits.
+struct SimAudioRing {
+	static const uint32_t kFrames = 1 << 14;	// ~340 ms at 48 kHz, power of two
+
+	int16_t buf[kFrames * 2];
+	std::atomic<uint32_t> head{0};	// written by the producer only
+	std::atomic<uint32_t> tail{0};	// written by the consumer only
+
+	bool Push(int16_t l, int16_t r);
+	bool Pop(int16_t &l, int16_t &r);
+	uint32_t Size() const;
+	void Clear();
+};
+
+// Offline capture of the decimated output over a frame range, for headless
+// and regression runs. The WAV body is handed to a writer thread in blocks so
+// the sim thread never waits on the disk; the fingerprint is one short text
+// line per video frame (L/R energy plus a quantised band spectrum) that
+// tools/audiofp compares against a golden in milliseconds.
+struct SimAudioCapture {
+	static const int kBlockFrames = 8192;
+	static const int kBands = 8;
+
+	bool active = false;		// any output open
+	int first_frame = 0, last_frame = -1;	// inclusive; last < 0 = open ended
+
+	bool OpenWav(const char *path, int rate);
+	bool OpenFingerprint(const char *path, int rate);
+	void Frame(int frame);		// video frame boundary
+	void Put(int16_t l, int16_t r);
+	void Close();
+
+private:
+	int rate = 0;
+	int frame = -1;
+	bool in_range = false;
+
+	// WAV writer
+	FILE *wav = nullptr;
+	uint64_t wav_frames = 0;
+	std::vector<int16_t> block;
+	std::deque<std::vector<int16_t>> queue;
+	std::mutex lock;
+	std::condition_variable wake;
+	std::thread writer;
+	bool stopping = false;
+	void WriterLoop();
+	void WriteHeader(uint32_t data_bytes);
+
+	// fingerprint
+	FILE *fp = nullptr;
+	uint32_t fp_hash = 2166136261u;	// FNV-1a over every line written
+	int fp_lines = 0;
+	std::vector<float> fr_mono;
+	double fr_sq_l = 0, fr_sq_r = 0;
+	void EmitFingerprint();
+};
+
 struct SimAudio {
 public:
 
 	SimClock clock;
-	
+
 	static const unsigned short debug_max_samples = 600;
 	float debug_positions[debug_max_samples];
 	float debug_wave_l[debug_max_samples];
 	float debug_wave_r[debug_max_samples];
 	int debug_pos;
 
+	// Output pipeline: AUDIO_L/R at the 14M rate -> boxcar to kOversample x
+	// the output rate -> FIR low-pass decimator -> ring -> SDL callback.
+	static const int kOversample = 4;
+	static const int kTaps = 160;
+	int sample_rate = 48000;	// 44100 or 48000; set before Initialise()
+
+	// Real-time report, refreshed about twice a second by the sim thread and
+	// read by the GUI thread.
+	std::atomic<float> sim_speed{0};	// sim-generated audio seconds per wall second
+	std::atomic<float> buffered_ms{0};	// audio queued ahead of the device
+	std::atomic<uint32_t> underruns{0};	// device wanted frames the sim hadn't made
+	std::atomic<uint32_t> overruns{0};	// frames dropped because the ring was full
+	bool playing = false;		// SDL device open
+
+	SimAudioCapture capture;	// --audio-out / --audio-fingerprint
+	int frame = -1;			// last video frame passed to capture
+
 	SimAudio(int systemClockFrequency, bool saveToFile);
 	~SimAudio();
 	void Clock(signed short left, signed short right);
+	// Tell the capture which video frame the following samples belong to.
+	void Frame(int f) { if (f != frame) { frame = f; if (capture.active) capture.Frame(f); } }
 	void CollectDebug(signed short left, signed short right);
 	void Initialise();
 	void CleanUp();
+
+	// SDL callback side (public so the C callback can reach it)
+	void Fill(int16_t *out, int frames);
+
+private:
+	int input_rate;
+	SimAudioRing ring;
+
+	// stage 1: fractional-step boxcar
+	int32_t acc_l = 0, acc_r = 0;
+	int acc_n = 0;
+	int64_t phase = 0;
+
+	// stage 2: FIR over the last kTaps oversampled frames
+	float taps[kTaps];
+	float hist_l[kTaps * 2], hist_r[kTaps * 2];	// doubled so a window never wraps
+	int hist_pos = 0, decim = 0;
+
+	// consumer state (audio thread only)
+	int16_t last_l = 0, last_r = 0;
+	bool priming = true;
+	std::atomic<uint32_t> underrun_frames{0};
+
+	// speed measurement (sim thread)
+	uint64_t produced = 0, report_produced = 0;
+	uint64_t report_ticks = 0;
+	uint32_t device = 0;
+
+	void BuildFilter();
+	void Emit(float l, float r);
+	void Report();
 };
@@ -6,7 +6,9 @@
 
 #include "sim_blkdevice.h"
 #include "sim_console.h"
+#include "sim_log.h"
 #include "verilated.h"
+#include "iigs_fmt.h"
 
 #ifndef _MSC_VER
 #else
@@ -41,9 +43,11 @@ void SimBlockDevice::MountDisk( std::string file, int index) {
 	bool was_mounted = disk[index].is_open();
 	// Close existing disk if already mounted
 	if (was_mounted) {
-		printf("BLKDEV: Closing existing disk %d before re-mount\n", index);
+		SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: Closing existing disk %d before re-mount\n", index);
+		WriteBack(index);
 		disk[index].close();
 	}
+	SetFloppySource(index, FloppySource());
 	disk[index].open(file.c_str(), std::ios::out | std::ios::in | std::ios::binary | std::ios::ate);
         if (disk[index]) {
            long int new_size = disk[index].tellg();
@@ -54,13 +58,13 @@ void SimBlockDevice::MountDisk( std::string file, int index) {
            if (slash != std::string::npos)
                basename = file.substr(slash + 1);
            disk_name[index] = basename;
-           printf("BLKDEV: disk %d inserted (%s) size=%ld bytes\n", index, file.c_str(), new_size);
+           SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: disk %d inserted (%s) size=%ld bytes\n", index, file.c_str(), new_size);
            if (index == 0) {
                // NIB floppy format check: 232960 = 35 tracks × 6656 bytes/track
                if (new_size == 232960) {
-                   printf("BLKDEV: Detected 5.25\" NIB format (35 tracks × 6656 bytes)\n");
+                   SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: Detected 5.25\" NIB format (35 tracks × 6656 bytes)\n");
                } else {
-                   printf("BLKDEV: WARNING - Floppy size %ld doesn't match expected NIB size 232960\n", new_size);
+                   SIMLOG(LOG_DISK, LOG_WARN, "BLKDEV: WARNING - Floppy size %ld doesn't match expected NIB size 232960\n", new_size);
                }
            }
            // MiSTer behavior: single mount pulse with new size, whether fresh or swap
@@ -69,9 +73,9 @@ void SimBlockDevice::MountDisk( std::string file, int index) {
            mountQueue[index] = 1;
            header_size[index] = 0;
            if (was_mounted)
-               printf("BLKDEV: Disk swap for drive %d (single pulse, size=%ld)\n", index, new_size);
+               SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: Disk swap for drive %d (single pulse, size=%ld)\n", index, new_size);
            else
-               printf("BLKDEV: Fresh mount for drive %d (size=%ld)\n", index, new_size);
+               SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: Fresh mount for drive %d (size=%ld)\n", index, new_size);
         }else {
 		fprintf(stderr,"BLKDEV ERROR: Failed to open: %s\n",file.c_str());
 	}
@@ -80,18 +84,132 @@ void SimBlockDevice::MountDisk( std::string file, int index) {
 
 void SimBlockDevice::EjectDisk(int index) {
 	if (disk[index].is_open()) {
+		WriteBack(index);
 		disk[index].close();
 	}
+	SetFloppySource(index, FloppySource());
 	disk_size[index] = 0;
 	mountQueue[index] = 1;  // Triggers mount pulse with size=0, Verilog sees unmount
 	disk_name[index].clear();
-	printf("BLKDEV: disk %d ejected\n", index);
+	SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: disk %d ejected\n", index);
 }
 
 bool SimBlockDevice::IsMounted(int index) {
 	return disk[index].is_open();
 }
 
+void SimBlockDevice::SetFloppySource(int index, const FloppySource &src) {
+	floppy_src[index] = src;
+	dirty_track[index].assign(160, false);
+	woz_dir[index].clear();
+	if (src.path.empty() || !disk[index].is_open()) return;
+
+	// Keep the WOZ header blocks (INFO/TMAP/TRKS directory) so a write LBA
+	// can be mapped to its track without touching the file.
+	long n = disk_size[index] < 3 * kBLKSZ ? disk_size[index] : 3 * kBLKSZ;
+	woz_dir[index].resize(n);
+	disk[index].clear();
+	disk[index].seekg(0);
+	disk[index].read((char *)woz_dir[index].data(), n);
+	disk[index].clear();
+	disk[index].seekg(0);
+	SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: drive %d writes back to %s\n", index, src.path.c_str());
+}
+
+int SimBlockDevice::DirtyTracks(int index) {
+	int n = 0;
+	for (bool d : dirty_track[index]) n += d;
+	return n;
+}
+
+int SimBlockDevice::WriteBack(int index) {
+	FloppySource &src = floppy_src[index];
+	int ntracks = DirtyTracks(index);
+	if (src.path.empty() || !ntracks || !disk[index].is_open()) return 0;
+
+	// Pull the WOZ back in (at most ~1.4MB) and the source payload alongside
+	// it. Tracks are decoded checked: a sector is only patched if its
+	// checksums (and on 5.25" its address-field track) verify, so a corrupt or
+	// half-written sector keeps its original contents in the source image.
+	std::vector<uint8_t> woz(disk_size[index]);
+	disk[index].flush();
+	disk[index].clear();
+	disk[index].seekg(0);
+	disk[index].read((char *)woz.data(), woz.size());
+	disk[index].clear();
+	if (!disk[index]) {
+		fprintf(stderr, "BLKDEV ERROR: write-back of drive %d: cannot re-read WOZ\n", index);
+		return -1;
+	}
+
+	std::fstream out(src.path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+	std::vector<uint8_t> image(src.length);
+	out.seekg(src.offset);
+	out.read((char *)image.data(), image.size());
+	if (!out) {
+		fprintf(stderr, "BLKDEV ERROR: write-back of drive %d: cannot open %s\n", index, src.path.c_str());
+		return -1;
+	}
+
+	bool is35 = src.length == A2_35_IMAGE_SIZE;
+	std::vector<uint8_t> dsk;
+	if (!is35) {
+		dsk.resize(A2_525_IMAGE_SIZE);
+		if (src.prodos_order) a2_prodos_to_dos(dsk.data(), image.data());
+		else                  memcpy(dsk.data(), image.data(), A2_525_IMAGE_SIZE);
+	}
+
+	// Decode each dirty track, remembering which byte range of the payload it covers.
+	std::vector<std::pair<long, long>> ranges;
+	int patched = 0, expected = 0;
+	for (int t = 0; t < (int)dirty_track[index].size(); t++) {
+		if (!dirty_track[index][t]) continue;
+		if (is35) {
+			int base = 0, count = 0;
+			patched += a2_woz35_decode_track(woz.data(), woz.size(), t, image.data(), &base, &count, 1);
+			expected += count;
+			if (count) ranges.push_back({(long)base * A2_BLOCK_SIZE, (long)count * A2_BLOCK_SIZE});
+		} else {
+			patched += a2_woz525_decode_track(woz.data(), woz.size(), t, dsk.data(), 1);
+			expected += A2_SECTORS_PER_TRACK;
+			ranges.push_back({(long)t * A2_TRACK_SIZE, A2_TRACK_SIZE});
+		}
+	}
+	if (!is35) {
+		// Sector order only permutes within a track, so track ranges carry over.
+		if (src.prodos_order) a2_dos_to_prodos(image.data(), dsk.data());
+		else                  memcpy(image.data(), dsk.data(), A2_525_IMAGE_SIZE);
+	}
+
+	for (auto &r : ranges) {
+		out.seekp(src.offset + r.first);
+		out.write((const char *)image.data() + r.first, r.second);
+	}
+	if (src.dc42) {
+		uint32_t sum = dc42_checksum(image.data(), image.size());
+		uint8_t be[4] = { (uint8_t)(sum >> 24), (uint8_t)(sum >> 16), (uint8_t)(sum >> 8), (uint8_t)sum };
+		out.seekp(0x48);
+		out.write((const char *)be, 4);
+	}
+	out.flush();
+	if (!out) {
+		fprintf(stderr, "BLKDEV ERROR: write-back of drive %d: write to %s failed\n", index, src.path.c_str());
+		return -1;
+	}
+
+	dirty_track[index].assign(160, false);
+	SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: drive %d wrote back %d/%d sectors on %d track(s) to %s\n",
+	       index, patched, expected, ntracks, src.path.c_str());
+	if (patched < expected)
+		SIMLOG(LOG_DISK, LOG_WARN, "BLKDEV: WARNING - %d sector(s) failed verification; kept previous contents\n", expected - patched);
+	return patched;
+}
+
+void SimBlockDevice::FlushAll(void) {
+	for (int i = 0; i < kVDNUM; i++)
+		WriteBack(i);
+}
+
 
 void SimBlockDevice::BeforeEval(int cycles)
 {
@@ -115,13 +233,15 @@ void SimBlockDevice::BeforeEval(int cycles)
          *sd_buff_dout = disk[i].get();
          *sd_buff_addr = bytecnt++;
          *sd_buff_wr= 1;
+         bytes_moved++;
          //printf("cycles %x reading %X : %X ack %x\n",cycles,*sd_buff_addr,*sd_buff_dout,*sd_ack );
       } else if(writing && *sd_buff_addr != bytecnt && (*sd_buff_addr< kBLKSZ)) {
       //} else if(writing && (bytecnt < kBLKSZ)) {
         if (i == 5 && bytecnt < 8)
-            printf("WOZ_SAVE_DMA[%d]: addr=%d bytecnt=%d data=%02X\n", i, *sd_buff_addr, bytecnt, *(sd_buff_din[i]));
+            SIMLOG(LOG_FLOPPY, LOG_DEBUG, "WOZ_SAVE_DMA[%d]: addr=%d bytecnt=%d data=%02X\n", i, *sd_buff_addr, bytecnt, *(sd_buff_din[i]));
         disk[i].put(*(sd_buff_din[i]));
         *sd_buff_addr = bytecnt;
+        bytes_moved++;
       } else {
 	  *sd_buff_wr=0;
 
@@ -129,7 +249,7 @@ void SimBlockDevice::BeforeEval(int cycles)
 		  if (bytecnt>=kBLKSZ) {
 			  writing=0;
 			  if (i == 4 || i == 5) {
-			      printf("WOZ_DMA[%d]: Block write complete (bytecnt=%d)\n", i, bytecnt);
+			      SIMLOG(LOG_FLOPPY, LOG_DEBUG, "WOZ_DMA[%d]: Block write complete (bytecnt=%d)\n", i, bytecnt);
 			      disk[i].flush();  // Ensure data reaches disk (survives kill)
 			  }
 		  }
@@ -183,9 +303,9 @@ void SimBlockDevice::BeforeEval(int cycles)
                             }
                     }
             }
-           printf("BLKDEV: Mounting drive %d, img_size=%ld, header_offset=%ld\n", i, disk_size[i], header_size[i]);
+           SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: Mounting drive %d, img_size=%ld, header_offset=%ld\n", i, disk_size[i], header_size[i]);
            if (i == 0) {
-               printf("FLOPPY: Mount signal sent - setting img_mounted[0], expecting floppy_track to detect mount\n");
+               SIMLOG(LOG_FLOPPY, LOG_INFO, "FLOPPY: Mount signal sent - setting img_mounted[0], expecting floppy_track to detect mount\n");
            }
            mountQueue[i]=0;
            *img_size = disk_size[i];
@@ -196,7 +316,7 @@ void SimBlockDevice::BeforeEval(int cycles)
     } else if (ack_delay==1 && bitcheck(*img_mounted,i)) {
            // Clear mount flag after ack_delay expires - allows next queued mount to proceed
            // Verilog side latches state on rising edge (WOZ) or level (HDD), so pulse is sufficient
-           printf("BLKDEV: Mount flag cleared for drive %d\n", i);
+           SIMLOG(LOG_DISK, LOG_INFO, "BLKDEV: Mount flag cleared for drive %d\n", i);
         bitclear(*img_mounted,i) ;
     } else { if (!reading && !writing && ack_delay>0) ack_delay--; }
 
@@ -216,6 +336,10 @@ void SimBlockDevice::BeforeEval(int cycles)
         disk[i].clear();
         if (writing) {
             disk[i].seekp((lba) * kBLKSZ + header_size[i]);
+            if (!woz_dir[i].empty()) {
+                int t = a2_woz_track_for_lba(woz_dir[i].data(), woz_dir[i].size(), lba);
+                if (t >= 0) dirty_track[i][t] = true;
+            }
         } else {
             disk[i].seekg((lba) * kBLKSZ + header_size[i]);
         }
@@ -223,11 +347,11 @@ void SimBlockDevice::BeforeEval(int cycles)
         if (i == 0) {
             int track = lba / 13;  // 13 sectors per track
             int sector = lba % 13;
-            printf("FLOPPY DMA: LBA=%d (track=%d sector=%d) seek=%06X reading=%d writing=%d\n",
-                   lba, track, sector, (lba) * kBLKSZ + header_size[i], reading, writing);
+            SIMLOG(LOG_FLOPPY, LOG_DEBUG, "FLOPPY DMA: LBA=%d (track=%d sector=%d) seek=%06lX reading=%d writing=%d\n",
+                   lba, track, sector, (long)((lba) * kBLKSZ + header_size[i]), reading, writing);
         }
         if (i == 4 || i == 5) {
-            printf("WOZ_DMA[%d]: LBA=%d seek=0x%06lX %s\n",
+            SIMLOG(LOG_FLOPPY, LOG_DEBUG, "WOZ_DMA[%d]: LBA=%d seek=0x%06lX %s\n",
                    i, lba, (long)((lba) * kBLKSZ + header_size[i]),
                    writing ? "WRITE" : "READ");
         }
@@ -282,5 +406,6 @@ SimBlockDevice::SimBlockDevice(DebugConsole c) {
 }
 
 SimBlockDevice::~SimBlockDevice() {
+	FlushAll();
 
 }
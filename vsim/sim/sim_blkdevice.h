@@ -2,6 +2,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include "verilated.h"
 #include "sim_console.h"
 
@@ -14,6 +15,17 @@
 #define kVDNUM 10
 #define kBLKSZ 512
 
+// Where a converted floppy's sectors live in the image it was converted from.
+// prepareFloppyImage() fills this when it turns a .po/.dsk/.2mg/DC42 into a
+// temporary WOZ; the block device uses it to write dirty tracks back.
+struct FloppySource {
+	std::string path;        // original image; empty = the WOZ is the original
+	long offset = 0;         // payload offset (2MG data_offset, DC42 84)
+	long length = 0;         // payload length (143360 or 819200)
+	bool prodos_order = false;   // 5.25" payload stored in ProDOS sector order
+	bool dc42 = false;       // DiskCopy 4.2: refresh the data checksum too
+};
+
 struct SimBlockDevice {
 public:
 
@@ -30,6 +42,7 @@ public:
 	QData* img_size;
 
 	int bytecnt;
+	uint64_t bytes_moved = 0;	// DMA bytes read + written (perf panel)
         long int disk_size[kVDNUM];
 	long int header_size[kVDNUM];
 	bool reading;
@@ -46,6 +59,17 @@ public:
 	void EjectDisk(int index);
 	bool IsMounted(int index);
 
+	// Floppy write-back (drives 4/5). Writes that land in a WOZ track mark it
+	// dirty; WriteBack decodes only those tracks and patches their sectors into
+	// the source image. Runs on eject, swap and FlushAll (exit).
+	FloppySource floppy_src[kVDNUM];
+	std::vector<uint8_t> woz_dir[kVDNUM];     // WOZ header blocks (INFO/TMAP/TRKS)
+	std::vector<bool> dirty_track[kVDNUM];
+	void SetFloppySource(int index, const FloppySource &src);
+	int  DirtyTracks(int index);
+	int  WriteBack(int index);   // sectors patched, -1 on error
+	void FlushAll(void);
+
 	SimBlockDevice(DebugConsole c);
 	~SimBlockDevice();
 
@@ -0,0 +1,102 @@
+#include "sim_busstats.h"
+#include <algorithm>
+#include <vector>
+
+const char *SimBusStats::Name(int t)
+{
+	static const char *const names[kTypes] = {
+		"fast", "refresh", "slow", "sync_io", "sync_shadow", "sync_e0e1", "sync_other",
+	};
+	return t >= 0 && t < kTypes ? names[t] : "?";
+}
+
+SimBusStats::~SimBusStats()
+{
+	if (log) fclose(log);
+}
+
+// CSV, one line per frame: cycles of each class, then total ticks
+bool SimBusStats::OpenLog(const char *path)
+{
+	log = fopen(path, "w");
+	if (!log) {
+		fprintf(stderr, "BUSSTATS: cannot write %s\n", path);
+		return false;
+	}
+	fprintf(log, "frame");
+	for (int t = 0; t < kTypes; t++) fprintf(log, ",%s", Name(t));
+	fprintf(log, ",ticks\n");
+	active = true;
+	return true;
+}
+
+void SimBusStats::Frame(int frame)
+{
+	frames++;
+	if (log) {
+		uint64_t ticks = 0;
+		fprintf(log, "%d", frame);
+		for (int t = 0; t < kTypes; t++) {
+			fprintf(log, ",%llu", (unsigned long long)frame_cycles[t]);
+			ticks += frame_ticks[t];
+		}
+		fprintf(log, ",%llu\n", (unsigned long long)ticks);
+	}
+	for (int t = 0; t < kTypes; t++) frame_cycles[t] = frame_ticks[t] = 0;
+}
+
+static double pct(uint64_t a, uint64_t b)
+{
+	return b ? 100.0 * a / b : 0.0;
+}
+
+void SimBusStats::Summary(FILE *f) const
+{
+	uint64_t ticks = 0;
+	for (int t = 0; t < kTypes; t++) ticks += total_ticks[t];
+	fprintf(f, "BUSSTATS:");
+	for (int t = 0; t < kTypes; t++) fprintf(f, " %s=%.1f%%", Name(t), pct(total_ticks[t], ticks));
+	fprintf(f, " (share of 14M ticks)\n");
+}
+
+bool SimBusStats::Write(const char *path) const
+{
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "BUSSTATS: cannot write %s\n", path);
+		return false;
+	}
+	uint64_t cycles = 0, ticks = 0;
+	for (int t = 0; t < kTypes; t++) {
+		cycles += total_cycles[t];
+		ticks += total_ticks[t];
+	}
+	fprintf(f, "# Bus cycles: %llu cycles, %llu 14M ticks over %d frames (%.3f MHz effective)\n",
+	        (unsigned long long)cycles, (unsigned long long)ticks, frames,
+	        ticks ? 14.31818 * cycles / ticks : 0.0);
+	fprintf(f, "# %llu fast/refresh cycles carried the NTSC scanline stretch\n\n", (unsigned long long)stretched);
+	fprintf(f, "# class             cycles  cycles%%          ticks   ticks%%  ticks/cyc  per_frame\n");
+	for (int t = 0; t < kTypes; t++) {
+		fprintf(f, "%-12s %13llu %7.2f %14llu %7.2f %10.2f %10.0f\n", Name(t),
+		        (unsigned long long)total_cycles[t], pct(total_cycles[t], cycles),
+		        (unsigned long long)total_ticks[t], pct(total_ticks[t], ticks),
+		        total_cycles[t] ? (double)total_ticks[t] / total_cycles[t] : 0.0,
+		        frames ? (double)total_cycles[t] / frames : 0.0);
+	}
+
+	std::vector<int> banks;
+	for (int b = 0; b < 256; b++)
+		if (pbr_ticks[b]) banks.push_back(b);
+	std::sort(banks.begin(), banks.end(), [this](int a, int b) { return pbr_ticks[a] > pbr_ticks[b]; });
+	fprintf(f, "\n# Per PBR (code bank): cycles of each class\n# PBR  ticks%%");
+	for (int t = 0; t < kTypes; t++) fprintf(f, " %12s", Name(t));
+	fprintf(f, "\n");
+	for (int b : banks) {
+		fprintf(f, "  %02X %7.2f", b, pct(pbr_ticks[b], ticks));
+		for (int t = 0; t < kTypes; t++) fprintf(f, " %12llu", (unsigned long long)pbr_cycles[b][t]);
+		fprintf(f, "\n");
+	}
+	fclose(f);
+	printf("BUSSTATS: report -> %s\n", path);
+	return true;
+}
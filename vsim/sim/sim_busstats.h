@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Bus-cycle accounting (--bus-stats, --bus-log). Every CPU cycle is put in
+// one class from the clock divider state (slow, slowMem) and its length in
+// 14M ticks, and sync cycles are split by what caused them (bus address):
+//
+//   FAST         5 ticks (7 with the NTSC per-scanline stretch)
+//   REFRESH      fast cycle stretched to 10 (12) by Mega II RAM refresh
+//   SLOW         1 MHz mode (speed register, 5.25" motor)
+//   SYNC_IO      $C0xx in banks 00/01/E0/E1
+//   SYNC_SHADOW  write to banks 00-7F that synced: a shadowed video write
+//   SYNC_E0E1    bank $E0/$E1 memory
+//   SYNC_OTHER   any other sync cycle
+//
+// Counted per frame (streamed to --bus-log), per PBR and for the whole run.
+struct SimBusStats {
+	enum Type { FAST, REFRESH, SLOW, SYNC_IO, SYNC_SHADOW, SYNC_E0E1, SYNC_OTHER, kTypes };
+
+	bool active = false;
+
+	~SimBusStats();
+	bool OpenLog(const char *path);
+
+	// CPU clock edge: addr is the 24-bit bus address, tick the free-running 14M count
+	void Cycle(uint32_t addr, bool we, uint8_t pbr, bool slow, bool sync, uint64_t tick) {
+		uint32_t ticks = (uint32_t)(tick - last_tick);
+		last_tick = tick;
+		if (!started) { started = true; return; }
+		Type t;
+		if (slow) {
+			t = SLOW;
+		} else if (sync) {
+			uint32_t bank = addr >> 16, a16 = addr & 0xFFFF;
+			bool e0e1 = bank == 0xE0 || bank == 0xE1;
+			if ((bank <= 0x01 || e0e1) && (a16 & 0xFF00) == 0xC000) t = SYNC_IO;
+			else if (e0e1) t = SYNC_E0E1;
+			else if (we && bank < 0x80) t = SYNC_SHADOW;
+			else t = SYNC_OTHER;
+		} else {
+			t = ticks >= 10 ? REFRESH : FAST;
+			if (ticks == 7 || ticks == 12) stretched++;
+		}
+		frame_cycles[t]++;
+		frame_ticks[t] += ticks;
+		total_cycles[t]++;
+		total_ticks[t] += ticks;
+		pbr_cycles[pbr][t]++;
+		pbr_ticks[pbr] += ticks;
+	}
+
+	// vblank: close the frame's counters (and log them)
+	void Frame(int frame);
+
+	bool Write(const char *path) const;
+	void Summary(FILE *f) const;		// one line: share of ticks per class
+
+	static const char *Name(int t);
+
+private:
+	uint64_t last_tick = 0;
+	bool started = false;
+	uint64_t frame_cycles[kTypes] = {}, frame_ticks[kTypes] = {};
+	uint64_t total_cycles[kTypes] = {}, total_ticks[kTypes] = {};
+	uint64_t pbr_cycles[256][kTypes] = {};
+	uint64_t pbr_ticks[256] = {};
+	uint64_t stretched = 0;
+	int frames = 0;
+	FILE *log = nullptr;
+};
@@ -0,0 +1,172 @@
+#include "sim_calltrace.h"
+#include <stdio.h>
+#include <algorithm>
+
+static const char *const kToolSets[] = {
+	nullptr, "Tool Locator", "Memory Manager", "Misc Tools", "QuickDraw II", "Desk Manager",
+	"Event Manager", "Scheduler", "Sound Manager", "Apple Desktop Bus", "SANE", "Integer Math",
+	"Text Tools", "RAM Disk", "Window Manager", "Menu Manager", "Control Manager", "System Loader",
+	"QuickDraw II Aux", "Print Manager", "LineEdit", "Dialog Manager", "Scrap Manager",
+	"Standard File", nullptr, "Note Synthesizer", "Note Sequencer", "Font Manager", "List Manager",
+	"ACE", "Resource Manager", nullptr, "MIDI Tools", "Video Overlay", "TextEdit",
+};
+
+// Functions 1-6 are the same housekeeping calls in every tool set
+static const char *const kToolHousekeeping[] = {
+	nullptr, "BootInit", "StartUp", "ShutDown", "Version", "Reset", "Status",
+};
+
+// GS/OS class 1 numbers; ProDOS 16 (class 0) uses the same low byte for most
+static const struct { uint8_t num; const char *name; } kGsos[] = {
+	{0x01, "Create"}, {0x02, "Destroy"}, {0x04, "ChangePath"}, {0x05, "SetFileInfo"},
+	{0x06, "GetFileInfo"}, {0x08, "Volume"}, {0x09, "SetPrefix"}, {0x0A, "GetPrefix"},
+	{0x0B, "ClearBackupBit"}, {0x0C, "SetSysPrefs"}, {0x0D, "Null"}, {0x0E, "ExpandPath"},
+	{0x0F, "GetSysPrefs"}, {0x10, "Open"}, {0x11, "NewLine"}, {0x12, "Read"}, {0x13, "Write"},
+	{0x14, "Close"}, {0x15, "Flush"}, {0x16, "SetMark"}, {0x17, "GetMark"}, {0x18, "SetEOF"},
+	{0x19, "GetEOF"}, {0x1A, "SetLevel"}, {0x1B, "GetLevel"}, {0x1C, "GetDirEntry"},
+	{0x1D, "BeginSession"}, {0x1E, "EndSession"}, {0x1F, "SessionStatus"}, {0x20, "GetDevNumber"},
+	{0x24, "Format"}, {0x25, "EraseDisk"}, {0x26, "ResetCache"}, {0x27, "GetName"},
+	{0x28, "GetBootVol"}, {0x29, "Quit"}, {0x2A, "GetVersion"}, {0x2B, "GetFSTInfo"},
+	{0x2C, "DInfo"}, {0x2D, "DStatus"}, {0x2E, "DControl"}, {0x2F, "DRead"}, {0x30, "DWrite"},
+	{0x31, "BindInt"}, {0x32, "UnbindInt"}, {0x33, "FSTSpecific"}, {0x34, "AddNotifyProc"},
+	{0x35, "DelNotifyProc"}, {0x36, "DRename"}, {0x37, "GetStdRefNum"}, {0x38, "GetRefNum"},
+	{0x39, "GetRefInfo"}, {0x3A, "SetStdRefNum"},
+};
+
+static const struct { uint8_t num; const char *name; } kMli[] = {
+	{0x40, "ALLOC_INTERRUPT"}, {0x41, "DEALLOC_INTERRUPT"}, {0x65, "QUIT"}, {0x80, "READ_BLOCK"},
+	{0x81, "WRITE_BLOCK"}, {0x82, "GET_TIME"}, {0xC0, "CREATE"}, {0xC1, "DESTROY"}, {0xC2, "RENAME"},
+	{0xC3, "SET_FILE_INFO"}, {0xC4, "GET_FILE_INFO"}, {0xC5, "ON_LINE"}, {0xC6, "SET_PREFIX"},
+	{0xC7, "GET_PREFIX"}, {0xC8, "OPEN"}, {0xC9, "NEWLINE"}, {0xCA, "READ"}, {0xCB, "WRITE"},
+	{0xCC, "CLOSE"}, {0xCD, "FLUSH"}, {0xCE, "SET_MARK"}, {0xCF, "GET_MARK"}, {0xD0, "SET_EOF"},
+	{0xD1, "GET_EOF"}, {0xD2, "SET_BUF"}, {0xD3, "GET_BUF"},
+};
+
+// 24-bit little-endian pointer at a bank 00 stack address
+uint32_t SimCallTrace::Long(uint32_t addr) const
+{
+	return read(addr & 0xFFFF) | read((addr + 1) & 0xFFFF) << 8 | read((addr + 2) & 0xFFFF) << 16;
+}
+
+// RTL/RTS return to the pushed address + 1, wrapping within the bank
+static uint32_t after(uint32_t addr, uint32_t n)
+{
+	return (addr & 0xFF0000) | ((addr + n) & 0xFFFF);
+}
+
+void SimCallTrace::Entry(uint32_t addr, uint16_t sp, uint16_t x)
+{
+	Call c;
+	c.start = cycles;
+	c.frame = frame;
+	switch (addr) {
+	case 0xE10000:
+	case 0xE10008:
+		c.key = (addr == 0xE10000 ? TOOL : USER_TOOL) << 16 | x;
+		c.ret = after(Long(sp + 1), 1);
+		break;
+	case 0xE10004:
+	case 0xE1000C:
+		c.key = (addr == 0xE10004 ? TOOL : USER_TOOL) << 16 | x;
+		c.ret = after(Long(sp + 4), 1);
+		break;
+	case 0xE100A8: {
+		uint32_t r = after(Long(sp + 1), 1);
+		c.key = GSOS << 16 | read(r) | read(after(r, 1)) << 8;
+		c.ret = after(r, 6);
+		break;
+	}
+	case 0x00BF00: {
+		uint32_t r = ((read((sp + 1) & 0xFFFF) | read((sp + 2) & 0xFFFF) << 8) + 1) & 0xFFFF;
+		c.key = MLI << 16 | read(r);
+		c.ret = after(r, 3);
+		break;
+	}
+	default:
+		return;			// another E1 vector, not a call entry
+	}
+	if (pending.size() >= kMaxPending) {
+		pending.erase(pending.begin());
+		dropped++;
+	}
+	pending.push_back(c);
+}
+
+void SimCallTrace::Return(size_t i, uint8_t p)
+{
+	const Call &c = pending[i];
+	Stats &s = stats[c.key];
+	uint64_t d = cycles - c.start;
+	s.calls++;
+	s.total += d;
+	if (d > s.max) {
+		s.max = d;
+		s.max_frame = c.frame;
+	}
+	if (p & 1) s.errors++;
+	dropped += pending.size() - i - 1;	// calls above it never returned normally
+	pending.resize(i);
+}
+
+std::string SimCallTrace::Name(uint32_t key)
+{
+	char buf[80];
+	unsigned kind = key >> 16, num = key & 0xFFFF;
+	if (kind == TOOL || kind == USER_TOOL) {
+		unsigned set = num & 0xFF, fn = num >> 8;
+		const char *sname = kind == TOOL && set < sizeof(kToolSets) / sizeof(kToolSets[0]) ? kToolSets[set] : nullptr;
+		const char *fname = fn < sizeof(kToolHousekeeping) / sizeof(kToolHousekeeping[0]) ? kToolHousekeeping[fn] : nullptr;
+		char setbuf[24], fnbuf[8];
+		if (!sname) {
+			snprintf(setbuf, sizeof(setbuf), kind == TOOL ? "tool set $%02X" : "user tool set $%02X", set);
+			sname = setbuf;
+		}
+		if (!fname) {
+			snprintf(fnbuf, sizeof(fnbuf), "#$%02X", fn);
+			fname = fnbuf;
+		}
+		snprintf(buf, sizeof(buf), "Tool  $%04X %s %s", num, sname, fname);
+	} else if (kind == GSOS) {
+		const char *n = nullptr;
+		for (const auto &g : kGsos)
+			if (g.num == (num & 0xFF)) n = g.name;
+		snprintf(buf, sizeof(buf), "%s $%04X %s", num & 0x2000 ? "GS/OS" : "P16  ", num, n ? n : "?");
+	} else {
+		const char *n = nullptr;
+		for (const auto &m : kMli)
+			if (m.num == num) n = m.name;
+		snprintf(buf, sizeof(buf), "MLI   $%02X   %s", num, n ? n : "?");
+	}
+	return buf;
+}
+
+bool SimCallTrace::Write(const char *path) const
+{
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "CALLTRACE: cannot write %s\n", path);
+		return false;
+	}
+	std::vector<std::pair<uint32_t, Stats>> v(stats.begin(), stats.end());
+	std::sort(v.begin(), v.end(), [](const std::pair<uint32_t, Stats> &a, const std::pair<uint32_t, Stats> &b) {
+		return a.second.total > b.second.total;
+	});
+	uint64_t calls = 0;
+	for (const auto &e : v) calls += e.second.calls;
+	fprintf(f, "# %llu calls to %zu functions over %llu CPU cycles; cycles are inclusive of nested calls\n",
+	        (unsigned long long)calls, v.size(), (unsigned long long)cycles);
+	if (dropped || !pending.empty())
+		fprintf(f, "# %llu calls never returned, %zu still open at exit (not counted)\n",
+		        (unsigned long long)dropped, pending.size());
+	fprintf(f, "#    calls    total_cycles   run%%   mean_cycles    max_cycles  max@frame  errors  call\n");
+	for (const auto &e : v) {
+		const Stats &s = e.second;
+		fprintf(f, "%10llu %15llu %6.2f %13.0f %13llu %10d %7llu  %s\n",
+		        (unsigned long long)s.calls, (unsigned long long)s.total,
+		        cycles ? 100.0 * s.total / cycles : 0.0, (double)s.total / s.calls,
+		        (unsigned long long)s.max, s.max_frame, (unsigned long long)s.errors, Name(e.first).c_str());
+	}
+	fclose(f);
+	printf("CALLTRACE: %llu calls, %zu functions -> %s\n", (unsigned long long)calls, v.size(), path);
+	return true;
+}
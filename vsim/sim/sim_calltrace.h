@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// System call tracer (--calltrace). Recognises calls at their entry point,
+// so it doesn't matter how the caller got there:
+//
+//   E1:0000 / E1:0008   Toolbox dispatcher (system / user), JSL; X = function:tool set
+//   E1:0004 / E1:000C   glue entries; the caller's return address is the second one on the stack
+//   E1:00A8             GS/OS and ProDOS 16, JSL + inline call number and parameter pointer
+//   00:BF00             ProDOS 8 MLI, JSR + inline command byte and parameter pointer
+//
+// The return address is read off the stack at entry; the call ends at the
+// first opcode fetch from it. Nested calls (a tool calling the Memory Manager)
+// are timed independently, so cycles are inclusive. At exit the report lists
+// calls, total / mean / slowest cycles and error returns (carry set) per function.
+struct SimCallTrace {
+	static const size_t kMaxPending = 64;
+
+	bool active = false;
+	int frame = 0;			// current video frame, for the slowest-call location
+
+	// Reads guest memory for the stack and inline parameters (24-bit address)
+	typedef std::function<uint8_t(uint32_t)> Reader;
+	Reader read;
+
+	// Every CPU cycle
+	void Cycle() { cycles++; }
+
+	// Opcode fetch (VPA && NextState == 1), with the CPU registers at that point
+	void Fetch(uint32_t addr, uint16_t sp, uint16_t x, uint8_t p) {
+		for (size_t i = pending.size(); i-- > 0;)
+			if (pending[i].ret == addr) { Return(i, p); break; }
+		if (((addr >> 16) == 0xE1 && (addr & 0xFFFF) <= 0x00A8) || addr == 0x00BF00)
+			Entry(addr, sp, x);
+	}
+
+	bool Write(const char *path) const;
+
+private:
+	enum Kind { TOOL, USER_TOOL, GSOS, MLI };
+	struct Call {
+		uint32_t key;			// Kind << 16 | number
+		uint32_t ret;
+		uint64_t start;
+		int frame;
+	};
+	struct Stats {
+		uint64_t calls = 0, total = 0, max = 0, errors = 0;
+		int max_frame = 0;
+	};
+	uint64_t cycles = 0;
+	std::vector<Call> pending;
+	std::map<uint32_t, Stats> stats;
+	uint64_t dropped = 0;
+
+	void Entry(uint32_t addr, uint16_t sp, uint16_t x);
+	void Return(size_t i, uint8_t p);
+	uint32_t Long(uint32_t addr) const;
+	static std::string Name(uint32_t key);
+};
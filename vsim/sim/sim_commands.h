@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+
+// Single-producer, single-consumer ring of closures between the GUI thread and
+// the simulation thread. In GUI mode the sim runs on its own thread
+// (sim_main.cpp); everything the GUI wants to change in the model -- reset,
+// run state, disk mounts, host input, breakpoints, memory edits -- is pushed
+// here and runs on the sim thread between batches, so the model is only ever
+// written from one thread. A second ring carries results back to the GUI.
+//
+// The producer fills a slot and publishes it with a release store of head;
+// the consumer runs every slot up to an acquire load of head and returns it
+// by advancing tail. No locks: an empty Run() is two atomic loads.
+//
+// The ring is bounded and the sim thread only drains it between batches, so
+// a slow batch can fill it. Commands that must not be lost (key-ups, resets,
+// disk mounts, memory edits) go through Send(), which parks them in order on
+// the producer side until Retry() -- called by the producer once per pass --
+// gets them into the ring.
+struct SimCommands {
+	static const unsigned kSize = 256;
+
+	// Producer side; false (command dropped) when the consumer is kSize behind
+	bool Push(std::function<void()> fn) {
+		unsigned h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) == kSize) return false;
+		ring[h % kSize] = std::move(fn);
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Producer side; never drops, keeps order behind anything already parked
+	void Send(std::function<void()> fn) {
+		Retry();
+		if (overflow.empty() && Push(fn)) return;
+		overflow.push_back(std::move(fn));
+	}
+
+	// Producer side: move parked commands into the ring while there is room
+	void Retry() {
+		while (!overflow.empty() && Push(overflow.front())) overflow.pop_front();
+	}
+
+	// Consumer side: run everything queued so far, in order
+	int Run() {
+		unsigned t = tail.load(std::memory_order_relaxed);
+		unsigned h = head.load(std::memory_order_acquire);
+		int n = 0;
+		for (; t != h; t++, n++) {
+			ring[t % kSize]();
+			ring[t % kSize] = nullptr;
+			tail.store(t + 1, std::memory_order_release);
+		}
+		return n;
+	}
+
+private:
+	std::function<void()> ring[kSize];
+	std::atomic<unsigned> head{0}, tail{0};
+	std::deque<std::function<void()>> overflow;	// producer thread only
+};
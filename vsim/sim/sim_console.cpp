@@ -1,5 +1,6 @@
 #include "sim_console.h"
 #include <string>
+#include <mutex>
 #include "imgui.h"
 
 // Demonstrate creating a simple console window, with scrolling, filtering, completion and history.
@@ -28,6 +29,8 @@ bool                  ScrollToBottom;
 
 ImVector<char*>       Items;
 ImVector<char*>       FilteredItems;
+// AddLog is called from the sim thread (log compare) while the GUI thread draws
+static std::recursive_mutex& ItemsLock() { static std::recursive_mutex m; return m; }
 static char* Strdup(const char* str) { size_t len = strlen(str) + 1; void* buf = malloc(len); IM_ASSERT(buf); return (char*)memcpy(buf, (const void*)str, len); }
 
 
@@ -41,6 +44,7 @@ void DebugConsole::AddLog(const char* fmt, ...)
 	vsnprintf(buf, IM_ARRAYSIZE(buf), fmt, args);
 	buf[IM_ARRAYSIZE(buf) - 1] = 0;
 	va_end(args);
+	std::lock_guard<std::recursive_mutex> g(ItemsLock());
 	Items.push_back(Strdup(buf));
 	if (Filter.IsActive() && Filter.PassFilter(buf))
 		FilteredItems.push_back(Strdup(buf));
@@ -73,6 +77,7 @@ static int   Strnicmp(const char* str1, const char* str2, int n) { int d = 0; wh
 static void  Strtrim(char* str) { char* str_end = str + strlen(str); while (str_end > str && str_end[-1] == ' ') str_end--; *str_end = 0; }
 void DebugConsole::ClearLogTop(int n)
 {
+  std::lock_guard<std::recursive_mutex> g(ItemsLock());
   for (int i=0;i<n;i++)
    Items.erase(Items.begin());
 
@@ -102,6 +107,7 @@ void DebugConsole::CopyFiltered()
 
 void DebugConsole::ClearLog()
 {
+	std::lock_guard<std::recursive_mutex> g(ItemsLock());
 	for (int i = 0; i < Items.Size; i++)
 		free(Items[i]);
 	Items.clear();
@@ -110,6 +116,7 @@ void DebugConsole::ClearLog()
 
 void DebugConsole::Draw(const char* title, bool* p_open, ImVec2 size)
 {
+	std::lock_guard<std::recursive_mutex> g(ItemsLock());
 	ImGui::SetWindowSize(title, size, ImGuiCond_Once);
 	if (!ImGui::Begin(title, p_open))
 	{
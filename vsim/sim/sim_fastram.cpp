@@ -0,0 +1,74 @@
+#include "sim_fastram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+SimFastRam fastram_host;
+
+static const size_t kHugePage = 2 << 20;
+
+bool SimFastRam::Allocate()
+{
+	if (mem) return true;
+#ifdef _WIN32
+	mem = (uint8_t *)calloc(1, kSize);
+	backing = "heap";
+#else
+#ifdef MAP_HUGETLB
+	// Explicit huge pages only exist if vm.nr_hugepages was set aside
+	map = mmap(NULL, kSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (map != MAP_FAILED) {
+		map_len = kSize;
+		mem = (uint8_t *)map;
+		backing = "hugetlb";
+		return true;
+	}
+#endif
+	// Over-map by one huge page so the buffer can start on a 2MB boundary,
+	// which is what lets the kernel back it with transparent huge pages
+	map_len = kSize + kHugePage;
+	map = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED) {
+		map = nullptr;
+		map_len = 0;
+		fprintf(stderr, "FASTRAM: cannot map %zu bytes\n", kSize);
+		return false;
+	}
+	mem = (uint8_t *)(((uintptr_t)map + kHugePage - 1) & ~(uintptr_t)(kHugePage - 1));
+	backing = "4k";
+#ifdef MADV_HUGEPAGE
+	if (madvise(mem, kSize, MADV_HUGEPAGE) == 0) backing = "thp";
+#endif
+#endif
+	return mem != nullptr;
+}
+
+void SimFastRam::Free()
+{
+#ifdef _WIN32
+	free(mem);
+#else
+	if (map) munmap(map, map_len);
+#endif
+	map = nullptr;
+	map_len = 0;
+	mem = nullptr;
+	backing = "none";
+}
+
+// DPI from fastram_dpi.sv. main() allocates up front; the checks cover a
+// model evaluated before that (the DPI calls are the only user then).
+extern "C" char fastram_rd(int addr)
+{
+	if (!fastram_host.mem) fastram_host.Allocate();
+	return (char)fastram_host.mem[addr & (SimFastRam::kSize - 1)];
+}
+
+extern "C" void fastram_wr(int addr, char data)
+{
+	if (!fastram_host.mem) fastram_host.Allocate();
+	fastram_host.mem[addr & (SimFastRam::kSize - 1)] = (uint8_t)data;
+}
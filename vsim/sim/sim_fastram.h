@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Host buffer behind fastram_dpi.sv (make FASTRAM=host): the 16MB of fast RAM
+// and ROM that otherwise sits in the model as the fastram dpram array. The
+// buffer is an anonymous mapping, on explicit huge pages when the kernel has
+// any reserved and on 2MB-aligned transparent huge pages otherwise, so the
+// random-access 24-bit address space costs a handful of TLB entries instead of
+// four thousand. Being a private mapping it is copy-on-write across fork().
+// The harness reaches it through fastRam() in sim_main.cpp in both builds.
+struct SimFastRam {
+	static const size_t kSize = 1 << 24;
+
+	uint8_t *mem = nullptr;
+	const char *backing = "none";	// "hugetlb", "thp", "4k" or "heap", for the startup line
+
+	bool Allocate();
+	void Free();
+
+private:
+	void *map = nullptr;
+	size_t map_len = 0;
+};
+
+extern SimFastRam fastram_host;
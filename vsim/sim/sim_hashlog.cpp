@@ -0,0 +1,92 @@
+#include "sim_hashlog.h"
+#include <string.h>
+
+// 64-bit multiply/rotate hash over 8-byte words. Not cryptographic; it only
+// has to make an accidental collision between two diverging runs unlikely
+// and keep up with a full framebuffer every frame.
+static inline uint64_t rotl64(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+uint64_t SimHashLog::Hash(const void *data, size_t len, uint64_t seed)
+{
+	const uint64_t k1 = 0x9E3779B185EBCA87ull, k2 = 0xC2B2AE3D27D4EB4Full;
+	const uint8_t *p = (const uint8_t *)data;
+	uint64_t h = seed ^ (len * k1);
+	size_t n = len / 8;
+	for (size_t i = 0; i < n; i++) {
+		uint64_t w;
+		memcpy(&w, p + i * 8, 8);
+		h = rotl64(h ^ (w * k2), 31) * k1;
+	}
+	uint64_t tail = 0;
+	memcpy(&tail, p + n * 8, len & 7);
+	h = rotl64(h ^ (tail * k2), 31) * k1;
+	// final avalanche
+	h ^= h >> 33; h *= k2;
+	h ^= h >> 29; h *= k1;
+	h ^= h >> 32;
+	return h;
+}
+
+bool SimHashLog::Open(const char *path)
+{
+	out = fopen(path, "w");
+	if (!out) {
+		fprintf(stderr, "HASHLOG: cannot create %s\n", path);
+		return false;
+	}
+	fprintf(out, "# iigs hash log v1\n");
+	fprintf(out, "# frame cycle pbr:pc video cpu softsw slowram fastram dirty_pages\n");
+	memset(dirty, 0, sizeof(dirty));
+	chain = 0;
+	lines = 0;
+	active = true;
+	return true;
+}
+
+void SimHashLog::Frame(int frame, uint64_t cycle, uint32_t pbr_pc,
+                       const uint32_t *fb, size_t fb_pixels,
+                       const uint8_t *cpu, size_t cpu_len,
+                       const uint8_t *softsw, size_t softsw_len,
+                       const uint8_t *slowram, size_t slowram_len,
+                       const uint8_t *fastram)
+{
+	if (!out) return;
+
+	uint64_t h_video = fb ? Hash(fb, fb_pixels * 4) : 0;
+	uint64_t h_cpu = Hash(cpu, cpu_len);
+	uint64_t h_ss = Hash(softsw, softsw_len);
+	uint64_t h_slow = Hash(slowram, slowram_len);
+
+	// fastram: only the pages written this frame, keyed by page number so the
+	// same bytes landing on a different page still differ
+	uint64_t h_fast = 0;
+	int ndirty = 0;
+	for (int i = 0; i < kPages / 64; i++) {
+		uint64_t bits = dirty[i];
+		while (bits) {
+			int page = i * 64 + __builtin_ctzll(bits);
+			bits &= bits - 1;
+			h_fast = Hash(fastram + ((size_t)page << 8), 256, h_fast ^ page);
+			ndirty++;
+		}
+		dirty[i] = 0;
+	}
+
+	char line[192];
+	int n = snprintf(line, sizeof(line), "%d %llu %02X:%04X %016llx %016llx %016llx %016llx %016llx %d\n",
+	                 frame, (unsigned long long)cycle, (pbr_pc >> 16) & 0xff, pbr_pc & 0xffff,
+	                 (unsigned long long)h_video, (unsigned long long)h_cpu, (unsigned long long)h_ss,
+	                 (unsigned long long)h_slow, (unsigned long long)h_fast, ndirty);
+	fputs(line, out);
+	chain = Hash(line, n, chain);
+	lines++;
+}
+
+void SimHashLog::Close()
+{
+	if (!out) return;
+	fprintf(out, "# frames=%d hash=%016llx\n", lines, (unsigned long long)chain);
+	fclose(out);
+	out = nullptr;
+	active = false;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Per-frame state hash timeline (--hash-log). At every vblank one text line
+// records the frame, the 14M cycle count, PBR:PC and 64-bit hashes of the
+// framebuffer, the CPU registers, the soft switches, all of slowram and the
+// fastram pages the CPU wrote during that frame. tools/hashcmp aligns two
+// logs and reports the first frame where they part ways, which narrows a
+// regression (or a FAITHFUL / DUALRATE build difference, or nondeterminism
+// between two identical runs) down to one frame without screenshots.
+struct SimHashLog {
+	static const int kPages = 1 << 16;	// 256-byte pages in the 24-bit address space
+
+	bool active = false;
+
+	~SimHashLog() { Close(); }
+	bool Open(const char *path);
+	void Close();
+
+	// CPU write at a 24-bit address; called from the CPU clock edge
+	void MarkWrite(uint32_t addr) {
+		uint32_t page = (addr >> 8) & (kPages - 1);
+		dirty[page >> 6] |= 1ull << (page & 63);
+	}
+
+	// Registers and soft switches are passed as flat byte blobs so this file
+	// does not depend on the Verilated model.
+	void Frame(int frame, uint64_t cycle, uint32_t pbr_pc,
+	           const uint32_t *fb, size_t fb_pixels,
+	           const uint8_t *cpu, size_t cpu_len,
+	           const uint8_t *softsw, size_t softsw_len,
+	           const uint8_t *slowram, size_t slowram_len,
+	           const uint8_t *fastram);
+
+	static uint64_t Hash(const void *data, size_t len, uint64_t seed = 0);
+
+private:
+	FILE *out = nullptr;
+	uint64_t dirty[kPages / 64] = {};
+	uint64_t chain = 0;		// hash over every line, printed in the trailer
+	int lines = 0;
+};
@@ -592,7 +592,7 @@ void SimInput::Read() {
 			unsigned int ext = ev2ps2[k] & EXT;
 			//fprintf(stderr, "ev2ps2[k] = %x  ext = %x  temp = %x\n", ev2ps2[k], ext, EXT | 0x6b);
 			SimInput_PS2KeyEvent evt = SimInput_PS2KeyEvent(k, m_keyboardState[k], ext, ev2ps2[k]);
-			keyEvents.push(evt);
+			hostEvents.push(evt);
 		}
 		m_keyboardState_last[k] = m_keyboardState[k];
 	}
@@ -609,7 +609,7 @@ void SimInput::Read() {
 		if (caps_mod_last != caps_mod_now) {
 			const unsigned int CAPSLOCK_PS2 = 0x58;
 			SimInput_PS2KeyEvent evt(57, true, false, CAPSLOCK_PS2);
-			keyEvents.push(evt);
+			hostEvents.push(evt);
 			caps_mod_last = caps_mod_now;
 			if (m_keyboardState_last && m_keyboardStateCount > 57) {
 				m_keyboardState_last[57] = caps_mod_now;
@@ -625,7 +625,7 @@ void SimInput::Read() {
 				unsigned int mapped = ev2ps2[k];
 				bool ext = (mapped & EXT) != 0;
 				SimInput_PS2KeyEvent evt = SimInput_PS2KeyEvent(k, m_keyboardState[k], ext, mapped);
-				keyEvents.push(evt);
+				hostEvents.push(evt);
 			}
 			m_keyboardState_last[k] = m_keyboardState[k];
 		}
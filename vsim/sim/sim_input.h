@@ -33,7 +33,8 @@ public:
 	int mappings[16];
 
 	SData* ps2_key = NULL;
-	std::queue<SimInput_PS2KeyEvent> keyEvents;
+	std::queue<SimInput_PS2KeyEvent> keyEvents;	// fed to the core by BeforeEval (sim thread)
+	std::queue<SimInput_PS2KeyEvent> hostEvents;	// filled by Read (GUI thread), forwarded by sim_main
 	unsigned int keyEventTimer = 0;
 	unsigned int keyEventWait = 50000;
 
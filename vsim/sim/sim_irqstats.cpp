@@ -0,0 +1,160 @@
+#include "sim_irqstats.h"
+#include <string>
+
+static const double kTicksPerUs = 14.31818;
+
+static double us(uint64_t ticks)
+{
+	return ticks / kTicksPerUs;
+}
+
+void SimIrqStats::Hist::Add(uint64_t ticks)
+{
+	int b = 0;
+	while (b < kBins - 1 && (ticks >> b) > 1) b++;	// bin b: ticks < 2^(b+1)
+	bins[b]++;
+	count++;
+	sum += ticks;
+	if (ticks < min) min = ticks;
+	if (ticks > max) max = ticks;
+}
+
+uint64_t SimIrqStats::Hist::Percentile(double p) const
+{
+	uint64_t want = (uint64_t)(count * p), seen = 0;
+	for (int b = 0; b < kBins; b++) {
+		seen += bins[b];
+		if (seen > want) return ((uint64_t)2 << b) < max ? (uint64_t)2 << b : max;
+	}
+	return max;
+}
+
+const char *SimIrqStats::Name(int s)
+{
+	static const char *const names[kSources] = { "VBL", "QSEC", "SCANLINE", "ONESEC", "SOUND", "SCC", "ADB" };
+	return s >= 0 && s < kSources ? names[s] : "?";
+}
+
+SimIrqStats::~SimIrqStats()
+{
+	if (log) fclose(log);
+}
+
+// One CSV line per handled interrupt, written at its RTI
+bool SimIrqStats::OpenLog(const char *path)
+{
+	log = fopen(path, "w");
+	if (!log) {
+		fprintf(stderr, "IRQSTATS: cannot write %s\n", path);
+		return false;
+	}
+	fprintf(log, "frame,vector_tick,response_us,handler_us,sources\n");
+	active = true;
+	return true;
+}
+
+void SimIrqStats::Event(unsigned lines, bool irq, bool vector, bool rti, uint64_t tick)
+{
+	unsigned rise = lines & ~last_lines, fall = last_lines & ~lines;
+	for (int s = 0; s < kSources; s++) {
+		if (rise & (1u << s)) {
+			pend_tick[s] = tick;
+			waiting |= 1u << s;
+		}
+		if (fall & (1u << s)) {
+			to_clear[s].Add(tick - pend_tick[s]);
+			waiting &= ~(1u << s);
+		}
+	}
+	if (irq && !last_irq) {
+		assert_tick = tick;
+		assert_waiting = true;
+	}
+
+	// First cycle of a vector pull with the IRQ input asserted. BRK and COP
+	// pull vectors too, but without IRQ pending they aren't counted.
+	if (vector && !last_vector && irq) {
+		uint64_t resp = assert_waiting ? tick - assert_tick : 0;
+		if (assert_waiting) response.Add(resp);
+		assert_waiting = false;
+		for (int s = 0; s < kSources; s++)
+			if (waiting & (1u << s)) to_vector[s].Add(tick - pend_tick[s]);
+		waiting = 0;
+		if (depth < kMaxNest) {
+			vector_tick[depth] = tick;
+			vector_resp[depth] = resp;
+			vector_lines[depth] = lines;
+			depth++;
+		}
+	}
+	if (rti && depth > 0) {
+		depth--;
+		uint64_t h = tick - vector_tick[depth];
+		handler.Add(h);
+		if (log) {
+			std::string src;
+			for (int s = 0; s < kSources; s++)
+				if (vector_lines[depth] & (1u << s)) src += std::string(src.empty() ? "" : "+") + Name(s);
+			fprintf(log, "%d,%llu,%.2f,%.2f,%s\n", frame, (unsigned long long)vector_tick[depth],
+			        us(vector_resp[depth]), us(h), src.empty() ? "-" : src.c_str());
+		}
+	}
+
+	last_lines = lines;
+	last_irq = irq;
+	last_vector = vector;
+}
+
+static void row(FILE *f, const char *name, const SimIrqStats::Hist &h)
+{
+	if (!h.count) {
+		fprintf(f, "%-18s %8d\n", name, 0);
+		return;
+	}
+	fprintf(f, "%-18s %8llu %10.2f %10.2f %10.2f %10.2f %10.2f\n", name, (unsigned long long)h.count,
+	        us(h.min), us(h.sum) / h.count, us(h.Percentile(0.5)), us(h.Percentile(0.99)), us(h.max));
+}
+
+static void hist(FILE *f, const char *name, const SimIrqStats::Hist &h)
+{
+	if (!h.count) return;
+	fprintf(f, "\n# %s histogram (us, log2 buckets)\n", name);
+	uint64_t peak = 0;
+	for (int b = 0; b < SimIrqStats::kBins; b++)
+		if (h.bins[b] > peak) peak = h.bins[b];
+	for (int b = 0; b < SimIrqStats::kBins; b++) {
+		if (!h.bins[b]) continue;
+		uint64_t lo = b ? (uint64_t)1 << b : 0, hi = (uint64_t)2 << b;
+		fprintf(f, "  %9.2f - %9.2f %8llu ", us(lo), us(hi), (unsigned long long)h.bins[b]);
+		for (uint64_t i = 0; i < (h.bins[b] * 50 + peak - 1) / peak; i++) fputc('#', f);
+		fputc('\n', f);
+	}
+}
+
+bool SimIrqStats::Write(const char *path) const
+{
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "IRQSTATS: cannot write %s\n", path);
+		return false;
+	}
+	const char *hdr = "#                     count     min_us    mean_us     p50_us     p99_us     max_us\n";
+	fprintf(f, "# Interrupt latency (14M ticks at %.5f MHz; percentiles are bucket bounds)\n", kTicksPerUs);
+	fprintf(f, "\n# CPU\n%s", hdr);
+	row(f, "assert->vector", response);
+	row(f, "vector->RTI", handler);
+	fprintf(f, "\n# pending -> vector pull\n%s", hdr);
+	for (int s = 0; s < kSources; s++) row(f, Name(s), to_vector[s]);
+	fprintf(f, "\n# pending -> cleared\n%s", hdr);
+	for (int s = 0; s < kSources; s++) row(f, Name(s), to_clear[s]);
+
+	hist(f, "assert->vector", response);
+	hist(f, "vector->RTI", handler);
+	for (int s = 0; s < kSources; s++) {
+		std::string n = std::string(Name(s)) + " pending->vector";
+		hist(f, n.c_str(), to_vector[s]);
+	}
+	fclose(f);
+	printf("IRQSTATS: %llu interrupts -> %s\n", (unsigned long long)handler.count, path);
+	return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Interrupt latency instrumentation (--irq-stats, --irq-log). Sampled every
+// CPU cycle from the core's IRQ sources, the CPU IRQ input, VPB and RTI
+// fetches; all times are 14M ticks, reported in microseconds.
+//
+//   pend -> vector   source went pending until the CPU pulled the IRQ vector
+//   pend -> clear    source went pending until the handler cleared it
+//   assert -> vector CPU IRQ input asserted until the vector pull (I flag, instruction end)
+//   vector -> RTI    time in the handler
+//
+// A source is only "pending" when the core would pass it to the CPU, i.e.
+// VBL and 1/4 s are gated by their INTEN bits as in iigs.sv.
+struct SimIrqStats {
+	enum Source { VBL, QSEC, SCANLINE, ONESEC, SOUND, SCC, ADB, kSources };
+	static const int kBins = 32;		// log2 buckets of 14M ticks
+	static const int kMaxNest = 8;
+
+	struct Hist {
+		uint64_t count = 0, sum = 0, min = ~0ull, max = 0;
+		uint64_t bins[kBins] = {};
+		void Add(uint64_t ticks);
+		uint64_t Percentile(double p) const;	// bucket upper bound
+	};
+
+	bool active = false;
+	int frame = 0;
+
+	~SimIrqStats();
+	bool OpenLog(const char *path);
+
+	// Every CPU cycle. lines: bit per Source; irq: the CPU's IRQ input asserted;
+	// vector: VPB asserted; rti: opcode fetch of an RTI
+	void Cycle(unsigned lines, bool irq, bool vector, bool rti, uint64_t tick) {
+		if (lines != last_lines || irq != last_irq || vector != last_vector || rti)
+			Event(lines, irq, vector, rti, tick);
+	}
+
+	bool Write(const char *path) const;
+
+	static const char *Name(int s);
+
+private:
+	Hist to_vector[kSources], to_clear[kSources];
+	Hist response, handler;
+	uint64_t pend_tick[kSources] = {};
+	unsigned waiting = 0;			// sources pending, not yet vectored
+	uint64_t assert_tick = 0;
+	bool assert_waiting = false;
+
+	uint64_t vector_tick[kMaxNest], vector_resp[kMaxNest];
+	unsigned vector_lines[kMaxNest];
+	int depth = 0;
+
+	unsigned last_lines = 0;
+	bool last_irq = false, last_vector = false;
+	FILE *log = nullptr;
+
+	void Event(unsigned lines, bool irq, bool vector, bool rti, uint64_t tick);
+};
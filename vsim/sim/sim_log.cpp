@@ -0,0 +1,327 @@
+#include "sim_log.h"
+#include <string.h>
+#include <strings.h>
+#include <signal.h>
+#include <chrono>
+
+SimLog simlog;
+
+// Bytes buffered before the writer is woken; it also wakes on a timer
+static const size_t kWakeBytes = 64 * 1024;
+
+const char *SimLog::Name(int cat)
+{
+	static const char *const names[kLogCats] = {
+		"sim", "cpu", "disk", "floppy", "video", "irq", "sound", "scc", "adb", "rtl",
+	};
+	return cat >= 0 && cat < kLogCats ? names[cat] : "?";
+}
+
+// Write out what is buffered, then die of the signal as before
+static void crashFlush(int sig)
+{
+	simlog.CrashFlush();
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+SimLog::SimLog()
+{
+	for (int c = 0; c < kLogCats; c++) threshold[c] = LOG_DEBUG;
+	out = stdout;
+	for (int sig : { SIGSEGV, SIGABRT, SIGFPE, SIGILL
+#ifdef SIGBUS
+	                 , SIGBUS
+#endif
+	     })
+		signal(sig, crashFlush);
+}
+
+SimLog::~SimLog()
+{
+	{
+		std::lock_guard<std::mutex> g(lock);
+		stop = true;
+	}
+	if (writer.joinable()) {
+		wake.notify_one();
+		writer.join();
+	}
+	if (out != stdout) fclose(out);
+	out = stdout;
+}
+
+bool SimLog::Open(const char *path)
+{
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "LOG: cannot write %s\n", path);
+		return false;
+	}
+	Flush();
+	{
+		std::lock_guard<std::mutex> g(io);
+		out = f;
+	}
+	async = true;
+	if (!writer.joinable()) writer = std::thread(&SimLog::Run, this);
+	return true;
+}
+
+static int levelByName(const char *s, size_t n)
+{
+	static const char *const names[] = { "off", "error", "warn", "info", "debug", "trace" };
+	for (int l = LOG_OFF; l <= LOG_TRACE; l++)
+		if (strlen(names[l]) == n && !strncasecmp(s, names[l], n)) return l;
+	return -1;
+}
+
+// Comma-separated <category>=<level>; "all" sets every category
+bool SimLog::Configure(const char *spec)
+{
+	const char *p = spec;
+	while (*p) {
+		const char *end = strchr(p, ',');
+		if (!end) end = p + strlen(p);
+		const char *eq = (const char *)memchr(p, '=', end - p);
+		int level = eq ? levelByName(eq + 1, end - eq - 1) : -1;
+		if (level < 0) {
+			fprintf(stderr, "LOG: bad --log entry '%.*s' (want <category>=off|error|warn|info|debug|trace)\n",
+			        (int)(end - p), p);
+			return false;
+		}
+		size_t n = eq - p;
+		bool all = n == 3 && !strncasecmp(p, "all", 3), found = all;
+		for (int c = 0; c < kLogCats; c++) {
+			if (all || (strlen(Name(c)) == n && !strncasecmp(p, Name(c), n))) {
+				threshold[c] = level;
+				configured[c] = true;
+				found = true;
+			}
+		}
+		if (!found) {
+			fprintf(stderr, "LOG: unknown category '%.*s'\n", (int)n, p);
+			return false;
+		}
+		p = *end ? end + 1 : end;
+	}
+	return true;
+}
+
+void SimLog::Quiet()
+{
+	for (int c = 0; c < kLogCats; c++)
+		if (!configured[c] && threshold[c] > LOG_WARN) threshold[c] = LOG_WARN;
+}
+
+void SimLog::Print(int cat, int level, const char *fmt, ...)
+{
+	(void)cat;
+	char buf[1024];
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	if (n < 0) return;
+	if ((size_t)n >= sizeof(buf)) {
+		// rare long line: format again into a heap string
+		std::string big(n + 1, '\0');
+		va_start(ap, fmt);
+		vsnprintf(&big[0], big.size(), fmt, ap);
+		va_end(ap);
+		Append(level, big.data(), n);
+		return;
+	}
+	Append(level, buf, n);
+}
+
+struct PrefixCat {
+	const char *prefix;
+	int cat;
+};
+
+static const PrefixCat kPrefixes[] = {
+	{ "ADB", LOG_ADB }, { "SCC", LOG_SCC },
+	{ "HDD", LOG_DISK }, { "BLKDEV", LOG_DISK },
+	{ "WOZ", LOG_FLOPPY }, { "IWM", LOG_FLOPPY }, { "FLOPPY", LOG_FLOPPY }, { "FLUX", LOG_FLOPPY }, { "TMAP", LOG_FLOPPY },
+	{ "VBL", LOG_IRQ }, { "FRAME", LOG_IRQ }, { "IRQ", LOG_IRQ },
+	{ "VGC", LOG_VIDEO }, { "VIDEO", LOG_VIDEO },
+	{ "DOC", LOG_SOUND }, { "ES5503", LOG_SOUND }, { "SOUND", LOG_SOUND },
+};
+
+// Does the n-byte word w contain s? (no allocation; Classify runs per line)
+static bool wordHas(const char *w, size_t n, const char *s)
+{
+	size_t len = strlen(s);
+	for (size_t i = 0; i + len <= n; i++)
+		if (!memcmp(w + i, s, len)) return true;
+	return false;
+}
+
+// Category and level of one RTL line from its first word
+int SimLog::Classify(const char *line, int *level)
+{
+	const char *p = line;
+	while (*p == ' ' || *p == '\t') p++;
+	if (*p == '%') {
+		// Verilator's own messages: %Error, %Warning, %Fatal
+		*level = !strncmp(p, "%Warning", 8) ? LOG_WARN : LOG_ERROR;
+		return LOG_RTL;
+	}
+	size_t n = 0;
+	while ((p[n] >= 'A' && p[n] <= 'Z') || (p[n] >= '0' && p[n] <= '9') || p[n] == '_') n++;
+	if (wordHas(p, n, "ERROR")) *level = LOG_ERROR;
+	else if (wordHas(p, n, "WARN")) *level = LOG_WARN;
+	else if (wordHas(p, n, "DEBUG") || wordHas(p, n, "DBG")) *level = LOG_DEBUG;
+	else *level = LOG_INFO;
+	for (const PrefixCat &pc : kPrefixes) {
+		size_t len = strlen(pc.prefix);
+		if (len <= n && !memcmp(p, pc.prefix, len)) return pc.cat;
+	}
+	return LOG_RTL;
+}
+
+void SimLog::Rtl(const char *text)
+{
+	const char *p = text;
+	for (;;) {
+		const char *nl = strchr(p, '\n');
+		if (!nl) {
+			rtl_line += p;
+			return;
+		}
+		const char *line = p;
+		size_t len = nl - p + 1;
+		if (!rtl_line.empty()) {
+			rtl_line.append(p, len);
+			line = rtl_line.c_str();
+			len = rtl_line.size();
+		}
+		int level;
+		int cat = Classify(line, &level);
+		if (Enabled(cat, level)) Append(level, line, len);
+		rtl_line.clear();
+		p = nl + 1;
+	}
+}
+
+void SimLog::Frame(int frame)
+{
+	if (!rate) return;
+	for (int c = 0; c < kLogCats; c++) {
+		if (dropped[c])
+			Print(LOG_SIM, LOG_WARN, "LOG: %s: %u lines over --log-rate %u dropped in frame %d\n", Name(c),
+			      dropped[c], rate, frame);
+		count[c] = dropped[c] = 0;
+	}
+}
+
+void SimLog::Append(int level, const char *text, size_t len)
+{
+	if (!async) {
+		// stdout: stdio orders this against the harness's printf
+		fwrite(text, 1, len, out);
+		if (level <= LOG_ERROR) fflush(out);
+		return;
+	}
+	std::unique_lock<std::mutex> g(lock);
+	if (stop) {
+		fwrite(text, 1, len, out);	// after shutdown (static destructors): write through
+		return;
+	}
+	pending.append(text, len);
+	bool now = level <= LOG_ERROR || pending.size() >= kWakeBytes;
+	g.unlock();
+	if (now) wake.notify_one();
+	if (level <= LOG_ERROR) Flush();	// don't lose an error to a crash that follows it
+}
+
+// Take the buffer and write it. The io lock is taken before the buffer lock
+// is released, so chunks reach the file in the order they were appended,
+// while the sim thread only ever waits for the swap.
+void SimLog::Drain(std::unique_lock<std::mutex> &g, std::string &chunk)
+{
+	chunk.swap(pending);
+	std::lock_guard<std::mutex> w(io);
+	g.unlock();
+	if (!chunk.empty()) fwrite(chunk.data(), 1, chunk.size(), out);
+	fflush(out);
+	chunk.clear();
+}
+
+void SimLog::Flush()
+{
+	std::string chunk;
+	std::unique_lock<std::mutex> g(lock);
+	Drain(g, chunk);
+}
+
+void SimLog::CrashFlush()
+{
+	// the interrupted thread may hold the lock; then its buffer is lost
+	if (lock.try_lock()) {
+		if (!pending.empty()) fwrite(pending.data(), 1, pending.size(), out);
+		pending.clear();
+		lock.unlock();
+	}
+	fflush(out);
+	if (out != stdout) fflush(stdout);
+}
+
+void SimLog::Run()
+{
+	std::string chunk;
+	for (;;) {
+		std::unique_lock<std::mutex> g(lock);
+		wake.wait_for(g, std::chrono::milliseconds(50),
+		              [this] { return stop || pending.size() >= kWakeBytes; });
+		bool done = stop;
+		if (!pending.empty()) Drain(g, chunk);
+		if (done) return;
+	}
+}
+
+// Can the line fmt starts be dropped before it is formatted? Only when no
+// partial line is pending and the first word is literal text, so the
+// category and level Classify gives the formatted line are already known.
+bool SimLog::RtlDropped(const char *fmt)
+{
+	if (!rtl_line.empty() || *fmt < 'A' || *fmt > 'Z') return false;
+	const char *p = fmt;
+	while ((*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_') p++;
+	if (*p == '%') return false;
+	int level;
+	int cat = Classify(fmt, &level);
+	return level > threshold[cat];
+}
+
+// VL_PRINTF target for the Verilated model (see sim_log_vl.h). $display
+// arrives as ("%s", text) already formatted by VL_WRITEF; that text is
+// classified in place rather than formatted a second time.
+void SimLogRtl(const char *fmt, ...)
+{
+	if (kSimLogStripped & (1u << LOG_RTL)) return;
+	va_list ap;
+	if (fmt[0] == '%' && fmt[1] == 's' && !fmt[2]) {
+		va_start(ap, fmt);
+		const char *text = va_arg(ap, const char *);
+		va_end(ap);
+		simlog.Rtl(text);
+		return;
+	}
+	if (simlog.RtlDropped(fmt)) return;
+	char buf[1024];
+	va_start(ap, fmt);
+	int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	if (n < 0) return;
+	if ((size_t)n < sizeof(buf)) {
+		simlog.Rtl(buf);
+		return;
+	}
+	std::string big(n + 1, '\0');
+	va_start(ap, fmt);
+	vsnprintf(&big[0], big.size(), fmt, ap);
+	va_end(ap);
+	simlog.Rtl(big.c_str());
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Levelled, per-subsystem logging for the harness and the RTL (--log,
+// --log-file, --log-rate). On stdout, lines are written through on the same
+// FILE as the harness's own printf, so the two stay in order. With --log-file
+// they are appended to a buffer that a background thread writes, so a chatty
+// subsystem costs a memcpy per line on the simulation thread. A fatal signal
+// (SIGSEGV, SIGABRT, ...) flushes whatever is still buffered first.
+//
+//   SIMLOG(LOG_DISK, LOG_DEBUG, "BLKDEV: LBA=%d\n", lba);
+//
+// Every category starts at debug, so the output is what printf gave until
+// --log or --quiet narrows it. The level is tested before anything is
+// formatted: a category that is off, or --quiet (warnings and errors only),
+// costs one compare per call. Building with -DSIMLOG_NO_<CAT> (make
+// LOG_STRIP="disk floppy") removes a category's harness calls altogether; RTL
+// messages are compiled out by their `ifdef DEBUG_*` guards as before.
+//
+// RTL $display reaches SimLogRtl through VL_PRINTF (sim_log_vl.h). Verilator
+// has already formatted the line by then (VL_WRITEF), so a quiet run still
+// pays for that; what it skips is any second format, the copy and the write.
+// The `ifdef DEBUG_* guards are what keep hot RTL messages free. Messages
+// follow the SUBSYSTEM_WHAT: prefix convention and the first word picks the
+// category: ADB*, SCC*, HDD*/BLKDEV*, WOZ*/IWM*/FLOPPY*/FLUX*/TMAP*,
+// VBL*/FRAME*/IRQ*, VGC*/VIDEO*, DOC*/ES5503*/SOUND*; anything else is "rtl".
+// A first word containing DEBUG or DBG logs at debug level, WARN at warn,
+// ERROR (or Verilator's own %Error/%Warning) at error/warn, the rest at info.
+enum SimLogCat {
+	LOG_SIM, LOG_CPU, LOG_DISK, LOG_FLOPPY, LOG_VIDEO, LOG_IRQ, LOG_SOUND, LOG_SCC, LOG_ADB, LOG_RTL,
+	kLogCats
+};
+enum SimLogLevel { LOG_OFF, LOG_ERROR, LOG_WARN, LOG_INFO, LOG_DEBUG, LOG_TRACE };
+
+static const unsigned kSimLogStripped = 0
+#ifdef SIMLOG_NO_SIM
+	| 1u << LOG_SIM
+#endif
+#ifdef SIMLOG_NO_CPU
+	| 1u << LOG_CPU
+#endif
+#ifdef SIMLOG_NO_DISK
+	| 1u << LOG_DISK
+#endif
+#ifdef SIMLOG_NO_FLOPPY
+	| 1u << LOG_FLOPPY
+#endif
+#ifdef SIMLOG_NO_VIDEO
+	| 1u << LOG_VIDEO
+#endif
+#ifdef SIMLOG_NO_IRQ
+	| 1u << LOG_IRQ
+#endif
+#ifdef SIMLOG_NO_SOUND
+	| 1u << LOG_SOUND
+#endif
+#ifdef SIMLOG_NO_SCC
+	| 1u << LOG_SCC
+#endif
+#ifdef SIMLOG_NO_ADB
+	| 1u << LOG_ADB
+#endif
+#ifdef SIMLOG_NO_RTL
+	| 1u << LOG_RTL
+#endif
+	;
+
+struct SimLog {
+	SimLog();
+	~SimLog();		// drains the buffer and stops the writer
+
+	bool Open(const char *path);		// --log-file (default stdout)
+	bool Configure(const char *spec);	// --log "disk=debug,rtl=off,all=warn"
+	void Quiet();				// --quiet: categories not set by --log drop to warn
+	void SetRate(unsigned lines) { rate = lines; }	// --log-rate: info and below, per category per frame
+
+	// Cheap enough for every call site; counts against the rate limit
+	bool Enabled(int cat, int level) {
+		if (level > threshold[cat]) return false;
+		if (rate && level > LOG_WARN && count[cat]++ >= rate) {
+			dropped[cat]++;
+			return false;
+		}
+		return true;
+	}
+
+	void Print(int cat, int level, const char *fmt, ...)
+#ifdef __GNUC__
+		__attribute__((format(printf, 4, 5)))
+#endif
+		;
+	void Rtl(const char *text);		// Verilator output, split into lines and classified
+	bool RtlDropped(const char *fmt);	// line would be dropped whatever its arguments
+	void Frame(int frame);			// vblank: report and reset the rate limit
+	void Flush();				// write out everything buffered so far
+	void CrashFlush();			// Flush for a signal handler: never blocks
+
+	static const char *Name(int cat);
+	static int Classify(const char *line, int *level);
+
+private:
+	int threshold[kLogCats];
+	bool configured[kLogCats] = {};
+	unsigned rate = 0, count[kLogCats] = {}, dropped[kLogCats] = {};
+	std::string rtl_line;			// $write text not yet ended by a newline
+
+	FILE *out = nullptr;
+	bool async = false;			// --log-file: buffer for the writer thread
+	std::string pending;
+	std::mutex lock;			// pending, stop
+	std::mutex io;				// out, and the order of writes to it
+	std::condition_variable wake;
+	std::thread writer;
+	bool stop = false;
+
+	void Append(int level, const char *text, size_t len);
+	void Drain(std::unique_lock<std::mutex> &g, std::string &chunk);
+	void Run();
+};
+
+extern SimLog simlog;
+
+#define SIMLOG(cat, level, ...) \
+	do { \
+		if (!(kSimLogStripped & (1u << (cat))) && simlog.Enabled(cat, level)) simlog.Print(cat, level, __VA_ARGS__); \
+	} while (0)
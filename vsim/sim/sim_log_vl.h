@@ -0,0 +1,11 @@
+#pragma once
+
+// Force-included into every C++ file of the Verilated build (Makefile) so
+// $display / $write and Verilator's own messages reach SimLog (sim_log.h)
+// instead of printf. verilated.h only defines VL_PRINTF when it is unset.
+void SimLogRtl(const char *fmt, ...)
+#ifdef __GNUC__
+	__attribute__((format(printf, 1, 2)))
+#endif
+	;
+#define VL_PRINTF SimLogRtl
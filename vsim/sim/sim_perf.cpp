@@ -0,0 +1,101 @@
+#include "sim_perf.h"
+
+void SimPerf::Clear()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	head = count = 0;
+	frame_head = frame_count = 0;
+	version++;
+	started = false;
+}
+
+void SimPerf::Snapshot(View &view)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (view.version == version) return;
+	view.samples.resize(count);
+	for (int i = 0; i < count; i++) view.samples[i] = ring[(Offset() + i) % kSamples];
+	view.frame_ms.assign(frame_ms, frame_ms + frame_count);
+	view.version = version;
+}
+
+void SimPerf::Update(double now, double run, uint64_t ticks, int frame, uint64_t disk_bytes, float audio_ms)
+{
+	if (!started) {
+		started = true;
+		t0 = last_t = now;
+		last_run = frame_run = run;
+		last_ticks = ticks;
+		last_disk = disk_bytes;
+		last_frame = sample_frame = frame;
+		for (int c = 0; c < kCycleTypes; c++) last_cycles[c] = cycles[c];
+		return;
+	}
+
+	// eval time of each frame that completed since the last pass
+	if (frame != last_frame) {
+		int n = frame > last_frame ? frame - last_frame : 1;
+		float ms = (float)((run - frame_run) * 1000.0 / n);
+		std::lock_guard<std::mutex> guard(lock);
+		for (int i = 0; i < n && i < kFrameTimes; i++) {
+			frame_ms[frame_head] = ms;
+			frame_head = (frame_head + 1) % kFrameTimes;
+			if (frame_count < kFrameTimes) frame_count++;
+		}
+		version++;
+		frame_run = run;
+		last_frame = frame;
+	}
+
+	double dt = now - last_t;
+	if (dt < kInterval) return;
+
+	std::lock_guard<std::mutex> guard(lock);
+	Sample &s = ring[head];
+	uint64_t cpu = 0, d[kCycleTypes];
+	for (int c = 0; c < kCycleTypes; c++) {
+		d[c] = cycles[c] - last_cycles[c];
+		cpu += d[c];
+		last_cycles[c] = cycles[c];
+	}
+	int frames = frame - sample_frame;
+	double run_dt = run - last_run;
+	s.t = now - t0;
+	s.frame = frame;
+	s.mcycles = (ticks - last_ticks) / dt / 1e6;
+	s.guest_mhz = cpu / dt / 1e6;
+	s.ms_per_frame = frames > 0 ? run_dt * 1000.0 / frames : 0.0;
+	for (int c = 0; c < kCycleTypes; c++) s.mix[c] = cpu ? 100.0 * d[c] / cpu : 0.0;
+	s.disk_kbs = (disk_bytes - last_disk) / dt / 1024.0;
+	s.audio_ms = audio_ms;
+	s.harness = 100.0 * (1.0 - run_dt / dt);
+	if (s.harness < 0) s.harness = 0;
+
+	head = (head + 1) % kSamples;
+	if (count < kSamples) count++;
+	version++;
+	last_t = now;
+	last_run = run;
+	last_ticks = ticks;
+	last_disk = disk_bytes;
+	sample_frame = frame;
+}
+
+bool SimPerf::WriteCsv(const char *path) const
+{
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "PERF: cannot write %s\n", path);
+		return false;
+	}
+	fprintf(f, "t,frame,mcycles_per_s,guest_mhz,ms_per_frame,fast_pct,slow_pct,sync_pct,disk_kbs,audio_ms,harness_pct\n");
+	for (int i = 0; i < count; i++) {
+		const Sample &s = ring[(Offset() + i) % kSamples];
+		fprintf(f, "%.3f,%.0f,%.3f,%.3f,%.2f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n", s.t, s.frame, s.mcycles,
+		        s.guest_mhz, s.ms_per_frame, s.mix[FAST], s.mix[SLOW], s.mix[SYNC], s.disk_kbs, s.audio_ms,
+		        s.harness);
+	}
+	fclose(f);
+	printf("PERF: %d samples -> %s\n", count, path);
+	return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <mutex>
+#include <vector>
+
+// Throughput samples for the GUI performance panel. The sim thread calls
+// Update() once per pass with the running totals; every kInterval seconds the
+// deltas become one Sample in a ring that WriteCsv exports. Per-frame eval
+// times feed a second ring for the frame-time histogram. The GUI thread never
+// reads the rings directly: it takes a View with Snapshot().
+struct SimPerf {
+	enum CycleType { FAST, SLOW, SYNC, kCycleTypes };
+	static const int kSamples = 1200;	// 5 minutes at kInterval
+	static const int kFrameTimes = 3600;
+	static constexpr double kInterval = 0.25;
+
+	struct Sample {
+		double t;			// wall seconds since the first update
+		double frame;
+		double mcycles;			// million 14M sim ticks per wall second
+		double guest_mhz;		// CPU cycles per wall microsecond
+		double ms_per_frame;		// RunBatch time per video frame
+		double mix[kCycleTypes];	// % of CPU cycles
+		double disk_kbs;		// block device DMA bytes
+		double audio_ms;		// audio queued ahead of the device
+		double harness;			// % of wall time outside RunBatch
+	};
+
+	bool active = false;
+	uint64_t cycles[kCycleTypes] = {};	// CPU cycles by class, from the CPU hook
+
+	void Cycle(CycleType t) { cycles[t]++; }
+
+	// now: wall seconds; run: seconds spent in RunBatch so far (cumulative)
+	void Update(double now, double run, uint64_t ticks, int frame, uint64_t disk_bytes, float audio_ms);
+	void Clear();
+
+	// GUI-owned copy of both rings, samples oldest first
+	struct View {
+		std::vector<Sample> samples;
+		std::vector<float> frame_ms;
+		unsigned version = 0;
+	};
+	// Refresh view if the rings changed since it was last taken. Any thread.
+	void Snapshot(View &view);
+
+	bool WriteCsv(const char *path) const;	// sim thread, the only writer
+
+private:
+	int Offset() const { return count < kSamples ? 0 : head; }	// oldest sample
+
+	std::mutex lock;		// rings and version; Update/Clear vs Snapshot
+	unsigned version = 1;
+	Sample ring[kSamples];
+	int head = 0, count = 0;
+	float frame_ms[kFrameTimes];
+	int frame_head = 0, frame_count = 0;
+
+	bool started = false;
+	double t0 = 0, last_t = 0, last_run = 0, frame_run = 0;
+	uint64_t last_ticks = 0, last_disk = 0, last_cycles[kCycleTypes] = {};
+	int last_frame = 0, sample_frame = 0;
+};
@@ -0,0 +1,228 @@
+#include "sim_profile.h"
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+
+static const uint32_t kEmpty = 0xFFFFFFFF;
+static const uint32_t kTop = 0xFFFFFFFF;	// call tree root: code not inside any seen call
+
+SimProfile::SimProfile()
+{
+	table.assign(1 << 14, Entry{kEmpty, 0, {0, 0, 0}, 0});
+	nodes.push_back(Node{kTop, 0, 0, 0, 1});
+}
+
+SimProfile::Entry *SimProfile::Lookup(uint32_t addr)
+{
+	size_t mask = table.size() - 1;
+	for (size_t i = (addr * 0x9E3779B1u) & mask;; i = (i + 1) & mask) {
+		Entry &e = table[i];
+		if (e.addr == addr) return &e;
+		if (e.addr == kEmpty) {
+			if ((used + 1) * 10 >= table.size() * 7) {
+				Grow();
+				return Lookup(addr);
+			}
+			e.addr = addr;
+			used++;
+			return &e;
+		}
+	}
+}
+
+void SimProfile::Grow()
+{
+	std::vector<Entry> old;
+	old.swap(table);
+	table.assign(old.size() * 2, Entry{kEmpty, 0, {0, 0, 0}, 0});
+	size_t mask = table.size() - 1;
+	for (const Entry &e : old) {
+		if (e.addr == kEmpty) continue;
+		size_t i = (e.addr * 0x9E3779B1u) & mask;
+		while (table[i].addr != kEmpty) i = (i + 1) & mask;
+		table[i] = e;
+	}
+}
+
+void SimProfile::Enter(uint32_t func, uint32_t ret, bool irq)
+{
+	if (stack.size() >= kMaxDepth) return;	// runaway (stack tricks): stay flat
+	stack.push_back(Frame{node, ret, irq});
+	uint64_t key = (uint64_t)node << 24 | func;
+	auto it = children.find(key);
+	if (it == children.end()) {
+		it = children.emplace(key, (uint32_t)nodes.size()).first;
+		nodes.push_back(Node{func, node, 0, 0, 0});
+	}
+	node = it->second;
+	nodes[node].calls++;
+}
+
+// Apply the control flow of the previous instruction now that we know where
+// it went. Returns are matched against the return address pushed by the call,
+// so PHA/RTS jump tables and other stack tricks don't unwind the tree.
+void SimProfile::Instruction(uint32_t addr, uint8_t opcode)
+{
+	instructions++;
+	if (irq_pending) {
+		irq_pending = false;
+		Enter(addr, 0, true);
+	} else if (cur) {
+		switch (last_op) {
+		case 0x20:	// JSR abs
+		case 0xFC:	// JSR (abs,X)
+			Enter(addr, (last_addr & 0xFF0000) | ((last_addr + 3) & 0xFFFF), false);
+			break;
+		case 0x22:	// JSL
+			Enter(addr, (last_addr & 0xFF0000) | ((last_addr + 4) & 0xFFFF), false);
+			break;
+		case 0x60:	// RTS
+		case 0x6B:	// RTL
+			for (size_t i = stack.size(); i-- > 0 && !stack[i].irq;) {
+				if (stack[i].ret == addr) {
+					node = stack[i].node;
+					stack.resize(i);
+					break;
+				}
+			}
+			break;
+		case 0x40:	// RTI
+			for (size_t i = stack.size(); i-- > 0;) {
+				if (stack[i].irq) {
+					node = stack[i].node;
+					stack.resize(i);
+					break;
+				}
+			}
+			break;
+		}
+	}
+	cur = Lookup(addr);
+	cur->count++;
+	last_addr = addr;
+	last_op = opcode;
+}
+
+static std::string label(uint32_t addr, const SimProfile::Namer &name)
+{
+	if (addr == kTop) return "(top)";
+	char buf[16];
+	snprintf(buf, sizeof(buf), "%02X:%04X", (addr >> 16) & 0xFF, addr & 0xFFFF);
+	std::string s = buf, n = name ? name(addr) : std::string();
+	return n.empty() ? s : s + " " + n;
+}
+
+static double pct(uint64_t a, uint64_t b)
+{
+	return b ? 100.0 * a / b : 0.0;
+}
+
+bool SimProfile::Write(const char *path, const Namer &name, int top) const
+{
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "PROFILE: cannot write %s\n", path);
+		return false;
+	}
+
+	std::vector<const Entry *> ins;
+	uint64_t type[3] = {0, 0, 0}, ticks = 0;
+	for (const Entry &e : table) {
+		if (e.addr == kEmpty) continue;
+		ins.push_back(&e);
+		for (int t = 0; t < 3; t++) type[t] += e.type[t];
+		ticks += e.ticks;
+	}
+	uint64_t cycles = type[FAST] + type[SLOW] + type[SYNC];
+	fprintf(f, "# 65816 profile: %llu instructions, %llu cycles (fast %.1f%%, slow %.1f%%, sync %.1f%%), "
+	        "%llu 14M ticks (%.2f ticks/cycle)\n",
+	        (unsigned long long)instructions, (unsigned long long)cycles,
+	        pct(type[FAST], cycles), pct(type[SLOW], cycles), pct(type[SYNC], cycles),
+	        (unsigned long long)ticks, cycles ? (double)ticks / cycles : 0.0);
+
+	// Functions: self from every call tree node of the entry point, inclusive
+	// counted once per outermost activation so recursion doesn't double it.
+	std::vector<uint64_t> incl(nodes.size()), incl_ticks(nodes.size());
+	for (size_t i = 0; i < nodes.size(); i++) {
+		incl[i] = nodes[i].cycles;
+		incl_ticks[i] = nodes[i].ticks;
+	}
+	for (size_t i = nodes.size(); i-- > 1;) {	// children always follow their parent
+		incl[nodes[i].parent] += incl[i];
+		incl_ticks[nodes[i].parent] += incl_ticks[i];
+	}
+	struct Func { uint64_t self = 0, self_ticks = 0, incl = 0, incl_ticks = 0, calls = 0; };
+	std::map<uint32_t, Func> funcs;
+	for (size_t i = 0; i < nodes.size(); i++) {
+		Func &fn = funcs[nodes[i].func];
+		fn.self += nodes[i].cycles;
+		fn.self_ticks += nodes[i].ticks;
+		fn.calls += nodes[i].calls;
+		bool outer = true;
+		for (uint32_t p = i; p && outer;) {
+			p = nodes[p].parent;
+			outer = nodes[p].func != nodes[i].func;
+		}
+		if (outer) {
+			fn.incl += incl[i];
+			fn.incl_ticks += incl_ticks[i];
+		}
+	}
+	std::vector<std::pair<uint32_t, Func>> fs(funcs.begin(), funcs.end());
+	std::sort(fs.begin(), fs.end(), [](const std::pair<uint32_t, Func> &a, const std::pair<uint32_t, Func> &b) {
+		return a.second.self_ticks > b.second.self_ticks;
+	});
+	fprintf(f, "\n# Functions by self time (call tree from JSR/JSL/RTS/RTL, interrupts, RTI)\n");
+	fprintf(f, "#  self%%   incl%%   self_cycles   incl_cycles  ticks/cyc      calls  entry\n");
+	for (size_t i = 0; i < fs.size() && (int)i < top; i++) {
+		const Func &fn = fs[i].second;
+		fprintf(f, "%7.2f %7.2f %13llu %13llu %10.2f %10llu  %s\n",
+		        pct(fn.self_ticks, ticks), pct(fn.incl_ticks, ticks),
+		        (unsigned long long)fn.self, (unsigned long long)fn.incl,
+		        fn.self ? (double)fn.self_ticks / fn.self : 0.0,
+		        (unsigned long long)fn.calls, label(fs[i].first, name).c_str());
+	}
+
+	std::sort(ins.begin(), ins.end(), [](const Entry *a, const Entry *b) { return a->ticks > b->ticks; });
+	fprintf(f, "\n# Instructions by time\n");
+	fprintf(f, "#  time%%        cycles      count  cyc/ins       fast       slow       sync  ticks/cyc  addr\n");
+	for (size_t i = 0; i < ins.size() && (int)i < top; i++) {
+		const Entry &e = *ins[i];
+		uint64_t c = e.type[FAST] + e.type[SLOW] + e.type[SYNC];
+		fprintf(f, "%7.2f %13llu %10u %8.2f %10llu %10llu %10llu %10.2f  %s\n",
+		        pct(e.ticks, ticks), (unsigned long long)c, e.count, e.count ? (double)c / e.count : 0.0,
+		        (unsigned long long)e.type[FAST], (unsigned long long)e.type[SLOW], (unsigned long long)e.type[SYNC],
+		        c ? (double)e.ticks / c : 0.0, label(e.addr, name).c_str());
+	}
+	fclose(f);
+	printf("PROFILE: %zu instructions, %zu call paths -> %s\n", ins.size(), nodes.size(), path);
+	return true;
+}
+
+std::string SimProfile::Path(uint32_t n, const Namer &name) const
+{
+	std::string s;
+	for (;;) {
+		std::string l = label(nodes[n].func, name);
+		std::replace(l.begin(), l.end(), ';', ',');
+		s = s.empty() ? l : l + ";" + s;
+		if (!n) return s;
+		n = nodes[n].parent;
+	}
+}
+
+// One line per call path: "frame;frame;frame ticks". Weighted by 14M ticks so
+// slow and sync cycles show at their real cost.
+bool SimProfile::WriteFolded(const char *path, const Namer &name) const
+{
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "PROFILE: cannot write %s\n", path);
+		return false;
+	}
+	for (size_t i = 0; i < nodes.size(); i++)
+		if (nodes[i].ticks)
+			fprintf(f, "%s %llu\n", Path(i, name).c_str(), (unsigned long long)nodes[i].ticks);
+	fclose(f);
+	return true;
+}
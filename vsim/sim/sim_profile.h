@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Guest-code profiler (--profile). Every CPU cycle is charged to the
+// instruction being executed (PBR:PC of its opcode fetch), split by cycle
+// type, and to a node of a call tree rebuilt from JSR/JSL/RTS/RTL and
+// interrupt entry/RTI. At exit it writes a sorted text report and, with
+// --profile-folded, collapsed stacks for flamegraph.pl / speedscope.
+//
+//   FAST  full-speed cycle
+//   SLOW  1 MHz mode (speed register bit 7 clear, or disk motor forcing it)
+//   SYNC  fast mode, stretched to sync with the 1 MHz side (I/O, E0/E1, shadowing)
+//
+// Ticks are 14M clocks, so ticks/cycle shows where the stretching lands.
+struct SimProfile {
+	enum Type { FAST, SLOW, SYNC };
+	static const size_t kMaxDepth = 256;
+
+	bool active = false;
+
+	// Name for a 24-bit address, or "" when there is none
+	typedef std::function<std::string(uint32_t)> Namer;
+
+	SimProfile();
+
+	// CPU clock edge. opcode_fetch marks the first cycle of an instruction
+	// (VPA && NextState == 1); vector_pull is VPB asserted (interrupt entry).
+	void Cycle(uint32_t addr, bool opcode_fetch, uint8_t opcode, bool vector_pull, Type type, uint32_t ticks) {
+		if (opcode_fetch) Instruction(addr & 0xFFFFFF, opcode);
+		if (vector_pull) irq_pending = true;
+		if (!cur) return;
+		cur->type[type]++;
+		cur->ticks += ticks;
+		nodes[node].cycles++;
+		nodes[node].ticks += ticks;
+	}
+
+	bool Write(const char *path, const Namer &name, int top = 100) const;
+	bool WriteFolded(const char *path, const Namer &name) const;
+
+private:
+	struct Entry {				// one per instruction address
+		uint32_t addr;			// 0xFFFFFFFF = empty slot
+		uint32_t count;
+		uint64_t type[3];
+		uint64_t ticks;
+	};
+	struct Node {				// call tree node: one per distinct call path
+		uint32_t func;			// entry address
+		uint32_t parent;
+		uint64_t cycles, ticks;		// self
+		uint64_t calls;
+	};
+	struct Frame {
+		uint32_t node;
+		uint32_t ret;			// expected return address (calls)
+		bool irq;
+	};
+
+	// flat profile: open addressing, linear probe, power-of-two size
+	std::vector<Entry> table;
+	size_t used = 0;
+	Entry *cur = nullptr;
+
+	std::vector<Node> nodes;
+	std::unordered_map<uint64_t, uint32_t> children;	// parent << 24 | func -> node
+	std::vector<Frame> stack;
+	uint32_t node = 0;
+
+	uint32_t last_addr = 0;
+	uint8_t last_op = 0xEA;
+	bool irq_pending = false;
+	uint64_t instructions = 0;
+
+	void Instruction(uint32_t addr, uint8_t opcode);
+	Entry *Lookup(uint32_t addr);
+	void Grow();
+	void Enter(uint32_t func, uint32_t ret, bool irq);
+	std::string Path(uint32_t n, const Namer &name) const;
+};
@@ -0,0 +1,82 @@
+#include "sim_text.h"
+
+// MouseText $40-$5F. Unicode has no exact match for some glyphs (the apples,
+// the running man halves); these are the closest common symbols.
+static const char *const kMouseText[32] = {
+	"\xEF\xA3\xBF",		// $40 closed apple (U+F8FF)
+	"\xE2\x8C\x98",		// $41 open apple (place of interest sign)
+	"\xF0\x9F\xAE\xB0",	// $42 mouse pointer
+	"\xE2\x8C\x9B",		// $43 hourglass
+	"\xE2\x9C\x93",		// $44 check mark
+	"\xF0\x9F\xAE\xB1",	// $45 inverse check mark
+	"\xF0\x9F\xAE\xB2",	// $46 running man, left half
+	"\xF0\x9F\xAE\xB3",	// $47 running man, right half
+	"\xE2\x86\x90",		// $48 left arrow
+	"\xE2\x80\xA6",		// $49 ellipsis
+	"\xE2\x86\x93",		// $4A down arrow
+	"\xE2\x86\x91",		// $4B up arrow
+	"\xE2\x96\x94",		// $4C overbar
+	"\xE2\x86\xB5",		// $4D return
+	"\xE2\x96\x88",		// $4E solid block
+	"\xE2\x87\x87",		// $4F scroll left
+	"\xE2\x87\x89",		// $50 scroll right
+	"\xE2\x87\x8A",		// $51 scroll down
+	"\xE2\x87\x88",		// $52 scroll up
+	"\xE2\x94\x80",		// $53 horizontal line
+	"\xE2\x94\x94",		// $54 lower left corner
+	"\xE2\x86\x92",		// $55 right arrow
+	"\xE2\x96\x92",		// $56 checkerboard
+	"\xE2\x96\x92",		// $57 checkerboard (phase 2)
+	"\xF0\x9F\xAE\xB9",	// $58 folder, left half
+	"\xF0\x9F\xAE\xBA",	// $59 folder, right half
+	"\xE2\x96\x95",		// $5A right vertical bar
+	"\xE2\x97\x86",		// $5B diamond
+	"\xE2\x95\x90",		// $5C top and bottom bars
+	"\xE2\x94\xBC",		// $5D cross
+	"\xE2\x96\x90",		// $5E right bar, left half block
+	"\xE2\x96\x8F",		// $5F left vertical bar
+};
+
+// printable ASCII as one-byte strings, so every glyph is a const char *
+static char kAscii[128][2];
+
+const char *SimTextGlyph(uint8_t code, bool altchar)
+{
+	uint8_t v;
+	if (code >= 0x80) {
+		v = code & 0x7F;		// normal
+	} else if (code < 0x40) {
+		v = code;			// inverse
+	} else if (code < 0x60) {
+		if (altchar) return kMouseText[code - 0x40];
+		v = code;			// flashing upper case
+	} else {
+		v = altchar ? code : code - 0x40;	// inverse lower case / flashing symbols
+	}
+	if (v < 0x20) v += 0x40;		// $00-$1F display as @A-Z[\]^_
+	if (v >= 0x7F) v = ' ';
+	if (!kAscii[v][0]) kAscii[v][0] = (char)v;
+	return kAscii[v];
+}
+
+void SimTextScreen(const uint8_t *main, const uint8_t *aux, const SimTextMode &mode,
+                   std::vector<std::string> &rows)
+{
+	rows.assign(24, std::string());
+	for (int r = mode.first_row; r < 24; r++) {
+		uint16_t base = SimTextRowAddr(r, mode.page2);
+		std::string &s = rows[r];
+		for (int c = 0; c < 40; c++) {
+			if (mode.col80) s += SimTextGlyph(aux[base + c], mode.altchar);
+			s += SimTextGlyph(main[base + c], mode.altchar);
+		}
+	}
+}
+
+void SimTextWrite(FILE *f, const std::vector<std::string> &rows)
+{
+	for (const std::string &r : rows) {
+		size_t end = r.find_last_not_of(' ');
+		fprintf(f, "%s\n", end == std::string::npos ? "" : r.substr(0, end + 1).c_str());
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Apple II text page decoder. Turns the 40/80-column text page into 24 rows
+// of UTF-8 without going through the video output, so tests can assert on
+// exact strings. The display always fetches from banks E0 (main) and E1
+// (aux), i.e. slowram, which every bank 00/01 text write is shadowed into.
+struct SimTextMode {
+	bool col80 = false;	// 80COL: aux/main interleaved
+	bool page2 = false;	// display page 2 ($0800) - PAGE2 && !80STORE
+	bool altchar = false;	// ALTCHARSET: $40-$5F MouseText, $60-$7F lowercase
+	int first_row = 0;	// first row shown as text: 0 TEXT, 20 MIXED graphics, 24 none (graphics, SHR)
+};
+
+// Screen code to UTF-8. Inverse and flashing characters come back as their
+// plain glyph; MouseText maps to the nearest Unicode symbol.
+const char *SimTextGlyph(uint8_t code, bool altchar);
+
+// Rows above mode.first_row are not on screen as text and come back empty
+void SimTextScreen(const uint8_t *main, const uint8_t *aux, const SimTextMode &mode,
+                   std::vector<std::string> &rows);
+
+// rows, one per line, trailing blanks trimmed
+void SimTextWrite(FILE *f, const std::vector<std::string> &rows);
+
+// Base address of text row 0-23 within a bank
+static inline uint16_t SimTextRowAddr(int row, bool page2)
+{
+	return (page2 ? 0x0800 : 0x0400) + 0x80 * (row & 7) + 0x28 * (row >> 3);
+}
@@ -0,0 +1,163 @@
+#include "sim_trigger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static std::string trim(const std::string &s)
+{
+	size_t a = s.find_first_not_of(" \t"), b = s.find_last_not_of(" \t");
+	return a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+}
+
+// "FF:6D00", "$FF6D00", "e1:0400" -> 24-bit address
+static bool parse_hex(std::string s, uint32_t &out)
+{
+	std::string h;
+	for (char c : trim(s))
+		if (c != '$' && c != ':') h += c;
+	if (h.empty()) return false;
+	char *end;
+	out = (uint32_t)strtoul(h.c_str(), &end, 16);
+	return *end == 0;
+}
+
+bool SimTriggers::ParseCond(const std::string &s, Cond &c)
+{
+	size_t op;
+	if (s.compare(0, 5, "text~") == 0) {
+		c.kind = TEXT;
+		c.text = trim(s.substr(5));
+		if (c.text.size() >= 2 && c.text.front() == '"' && c.text.back() == '"')
+			c.text = c.text.substr(1, c.text.size() - 2);
+		return !c.text.empty();
+	}
+	if (s.compare(0, 4, "pc==") == 0) {
+		c.kind = PC;
+		return parse_hex(s.substr(4), c.addr);
+	}
+	if (s.compare(0, 4, "mem[") == 0 && (op = s.find(']')) != std::string::npos) {
+		c.kind = MEM;
+		std::string rest = trim(s.substr(op + 1));
+		if (rest.compare(0, 2, "==") && rest.compare(0, 2, "!=")) return false;
+		c.ne = rest[0] == '!';
+		return parse_hex(s.substr(4, op - 4), c.addr) && parse_hex(rest.substr(2), c.value);
+	}
+	if (s.compare(0, 11, "disk-idle>=") == 0) {
+		c.kind = DISK_IDLE;
+		c.value = atoi(s.c_str() + 11);
+		return true;
+	}
+	if (s.compare(0, 7, "frame>=") == 0) {
+		c.kind = FRAME;
+		c.value = atoi(s.c_str() + 7);
+		return true;
+	}
+	return false;
+}
+
+bool SimTriggers::Add(const char *spec)
+{
+	Trigger t;
+	t.spec = spec;
+	std::string s(spec);
+	size_t arrow = s.find("->");
+	if (arrow == std::string::npos) {
+		fprintf(stderr, "Error: --trigger '%s': expected '<condition> -> <action>'\n", spec);
+		return false;
+	}
+
+	std::string conds = s.substr(0, arrow);
+	size_t pos = 0;
+	while (true) {
+		size_t amp = conds.find("&&", pos);
+		std::string one = trim(conds.substr(pos, amp == std::string::npos ? std::string::npos : amp - pos));
+		Cond c;
+		if (!ParseCond(one, c)) {
+			fprintf(stderr, "Error: --trigger: cannot parse condition '%s'\n", one.c_str());
+			return false;
+		}
+		if (c.kind == PC) watch_pc.push_back(c.addr);
+		t.conds.push_back(c);
+		if (amp == std::string::npos) break;
+		pos = amp + 2;
+	}
+
+	std::string acts = s.substr(arrow + 2) + ",";
+	pos = 0;
+	for (size_t comma; (comma = acts.find(',', pos)) != std::string::npos; pos = comma + 1) {
+		std::string a = trim(acts.substr(pos, comma - pos));
+		if (a.empty()) continue;
+		if (a == "screenshot") t.actions |= SCREENSHOT;
+		else if (a == "dump") t.actions |= DUMP;
+		else if (a == "stop") t.actions |= STOP;
+		else if (a == "text") t.actions |= TEXT_DUMP;
+		else if (a == "savestate") {
+			fprintf(stderr, "Error: --trigger: savestate is not supported (no save states in this sim yet)\n");
+			return false;
+		} else {
+			fprintf(stderr, "Error: --trigger: unknown action '%s' (screenshot, dump, text, stop)\n", a.c_str());
+			return false;
+		}
+	}
+	if (!t.actions) {
+		fprintf(stderr, "Error: --trigger '%s': no action\n", spec);
+		return false;
+	}
+	has_stop |= (t.actions & STOP) != 0;
+	list.push_back(t);
+	return true;
+}
+
+void SimTriggers::Hit(uint32_t addr)
+{
+	for (Trigger &t : list)
+		for (Cond &c : t.conds)
+			if (c.kind == PC && c.addr == addr) c.latched = true;
+}
+
+unsigned SimTriggers::Frame(int frame, const SimTriggerView &view)
+{
+	disk_idle = disk_busy ? 0 : disk_idle + 1;
+	disk_busy = false;
+
+	std::vector<std::string> rows;
+	unsigned fired = 0;
+	for (size_t i = 0; i < list.size(); i++) {
+		Trigger &t = list[i];
+		if (t.fired) continue;
+		bool ok = true;
+		for (const Cond &c : t.conds) {
+			switch (c.kind) {
+			case TEXT:
+				if (rows.empty()) SimTextScreen(view.slowram, view.slowram + 0x10000, view.text, rows);
+				ok = false;
+				for (const std::string &r : rows)
+					if (r.find(c.text) != std::string::npos) { ok = true; break; }
+				break;
+			case PC:
+				ok = c.latched;
+				break;
+			case MEM: {
+				uint32_t bank = (c.addr >> 16) & 0xFF;
+				uint8_t v = (bank == 0xE0 || bank == 0xE1) ? view.slowram[(bank & 1) << 16 | (c.addr & 0xFFFF)]
+				                                           : view.fastram[c.addr & 0xFFFFFF];
+				ok = (v == (c.value & 0xFF)) != c.ne;
+				break;
+			}
+			case DISK_IDLE:
+				ok = disk_idle >= (int)c.value;
+				break;
+			case FRAME:
+				ok = frame >= (int)c.value;
+				break;
+			}
+			if (!ok) break;
+		}
+		if (!ok) continue;
+		t.fired = true;
+		fired |= t.actions;
+		printf("TRIGGER: #%zu '%s' fired at frame %d\n", i + 1, t.spec.c_str(), frame);
+	}
+	if (fired & STOP) stopped = true;
+	return fired;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "sim_text.h"
+
+// Condition-based triggers (--trigger), so tests can stop or capture when
+// their goal is reached instead of at a guessed frame number:
+//
+//   --trigger 'text~"System OK" -> screenshot,stop'
+//   --trigger 'pc==FF:6D00 && disk-idle>=60 -> dump'
+//
+// Conditions, joined with &&:
+//   text~"..."        displayed text (40/80 col, current page; only the bottom
+//                     4 rows under MIXED graphics, none under graphics or SHR)
+//                     contains the string
+//   pc==BB:AAAA       an opcode was fetched from PBR:PC BB:AAAA, the CPU's own
+//                     address before LC bank 2 / aux mapping (sticky once seen)
+//   mem[BB:AAAA]==NN  byte in memory (E0/E1 from slowram) equals / != NN
+//   disk-idle>=N      no IWM or HDD access for N frames
+//   frame>=N          video frame count
+//
+// Actions: screenshot, dump (--memory-dump files), text (--dump-text file),
+// stop. Each trigger fires once, at the first vblank where all of its
+// conditions hold; bus-event conditions are latched in between. Addresses
+// and bytes are hex ('$' optional), frame counts decimal.
+struct SimTriggerView {
+	const uint8_t *fastram;
+	const uint8_t *slowram;
+	SimTextMode text;
+};
+
+struct SimTriggers {
+	enum Action { SCREENSHOT = 1, DUMP = 2, STOP = 4, TEXT_DUMP = 8 };
+
+	bool Add(const char *spec);
+	bool Active() const { return !list.empty(); }
+	bool HasStop() const { return has_stop; }
+	bool Stopped() const { return stopped; }
+
+	// CPU cycle hooks (24-bit bus address)
+	void Fetch(uint32_t addr) {
+		for (uint32_t pc : watch_pc)
+			if (pc == addr) { Hit(addr); break; }
+	}
+	void Data(uint32_t addr) {
+		uint32_t bank = addr >> 16, a16 = addr & 0xFFFF;
+		if ((bank == 0x00 || bank == 0x01 || bank == 0xE0 || bank == 0xE1) &&
+		    ((a16 >= 0xC0E0 && a16 <= 0xC0FF) || a16 == 0xC031))
+			disk_busy = true;
+	}
+
+	// vblank: returns the OR of the actions of every trigger that fired
+	unsigned Frame(int frame, const SimTriggerView &view);
+
+private:
+	enum Kind { TEXT, PC, MEM, DISK_IDLE, FRAME };
+	struct Cond {
+		Kind kind;
+		std::string text;
+		uint32_t addr = 0;
+		bool ne = false;
+		uint32_t value = 0;
+		bool latched = false;
+	};
+	struct Trigger {
+		std::string spec;
+		std::vector<Cond> conds;
+		unsigned actions = 0;
+		bool fired = false;
+	};
+	std::vector<Trigger> list;
+	std::vector<uint32_t> watch_pc;
+	bool has_stop = false, stopped = false;
+	bool disk_busy = false;
+	int disk_idle = 0;
+
+	bool ParseCond(const std::string &s, Cond &c);
+	void Hit(uint32_t addr);
+};
@@ -36,6 +36,20 @@ WNDCLASSEX wc;
 SDL_Window* window;
 SDL_GLContext gl_context;
 GLuint tex;
+
+// Pixel buffer ring for dirty-row uploads. Each upload orphans the next
+// buffer and maps it, so the copy never waits for the GPU to finish reading
+// an earlier one. GL 1.5 entry points, looked up at runtime; without them
+// glTexSubImage2D reads straight from the frame.
+static const int kPbos = 3;
+static GLuint pbo[kPbos];
+static int pbo_next;
+static bool pbo_ok;
+static PFNGLGENBUFFERSPROC pglGenBuffers;
+static PFNGLBINDBUFFERPROC pglBindBuffer;
+static PFNGLBUFFERDATAPROC pglBufferData;
+static PFNGLMAPBUFFERPROC pglMapBuffer;
+static PFNGLUNMAPBUFFERPROC pglUnmapBuffer;
 #endif
 ImTextureID texture_id;
 ImGuiIO io;
@@ -50,7 +64,6 @@ bool last_hblank;
 bool last_vblank;
 bool last_hsync;
 bool last_vsync;
-bool frame_ready = 1;
 
 // Statistics
 #ifdef WIN32
@@ -183,8 +196,8 @@ SimVideo::SimVideo(int width, int height, int rotate)
 	output_width = width;
 	output_height = height;
 	output_size = output_width * output_height * 4;
-	output_rotate = rotate;
-	output_vflip = 0;
+	SetOrientation(rotate, false);
+	row_seq.assign(output_height, 0);
 
 	count_pixel = 0;
 	count_line = 0;
@@ -278,6 +291,16 @@ int SimVideo::Initialise(const char* windowTitle) {
 
 	memset(output_ptr, 0xAA, output_size);
 
+	// The GUI thread draws from these; headless runs only use output_ptr
+	publish_frames = !headless;
+	if (publish_frames) {
+		for (int i = 0; i < 3; i++) {
+			frames[i] = (uint32_t*)malloc(output_size);
+			memcpy(frames[i], output_ptr, output_size);
+			frame_rows[i].assign(output_height, 0);
+		}
+	}
+
 
 #ifdef WIN32
 	// Upload texture to graphics system
@@ -337,6 +360,14 @@ int SimVideo::Initialise(const char* windowTitle) {
 		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, output_width, output_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, output_ptr);
 		texture_id = (ImTextureID)tex;
+
+		pglGenBuffers = (PFNGLGENBUFFERSPROC)SDL_GL_GetProcAddress("glGenBuffers");
+		pglBindBuffer = (PFNGLBINDBUFFERPROC)SDL_GL_GetProcAddress("glBindBuffer");
+		pglBufferData = (PFNGLBUFFERDATAPROC)SDL_GL_GetProcAddress("glBufferData");
+		pglMapBuffer = (PFNGLMAPBUFFERPROC)SDL_GL_GetProcAddress("glMapBuffer");
+		pglUnmapBuffer = (PFNGLUNMAPBUFFERPROC)SDL_GL_GetProcAddress("glUnmapBuffer");
+		pbo_ok = pglGenBuffers && pglBindBuffer && pglBufferData && pglMapBuffer && pglUnmapBuffer;
+		if (pbo_ok) pglGenBuffers(kPbos, pbo);
 	}
 #endif
 	return 0;
@@ -344,12 +375,16 @@ int SimVideo::Initialise(const char* windowTitle) {
 
 void SimVideo::UpdateTexture() {
 
+	const uint32_t* frame = LatestFrame();
 #ifdef WIN32
 	// Update the texture!
 	// D3D11_USAGE_DEFAULT MUST be set in the texture description (somewhere above) for this to work.
 	// (D3D11_USAGE_DYNAMIC is for use with map / unmap.) ElectronAsh.
-	if (frame_ready) {
-		g_pd3dDeviceContext->UpdateSubresource(texture, 0, NULL, output_ptr, output_width * 4, 0);
+	if (frame && DirtySpans()) {
+		for (auto& sp : spans) {
+			D3D11_BOX box = { 0, (UINT)sp.first, 0, (UINT)output_width, (UINT)sp.second, 1 };
+			g_pd3dDeviceContext->UpdateSubresource(texture, 0, &box, frame + sp.first * output_width, output_width * 4, 0);
+		}
 	}
 	// Rendering
 	ImGui::Render();
@@ -358,8 +393,29 @@ void SimVideo::UpdateTexture() {
 	ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 	g_pSwapChain->Present(output_usevsync, 0); // Present without vsync
 #else
-	if (frame_ready) {
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, output_width, output_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, output_ptr);
+	if (frame && !headless && DirtySpans()) {
+		const size_t pitch = output_width * 4;
+		const uint8_t* src = (const uint8_t*)frame;
+		uint8_t* dst = NULL;
+		glBindTexture(GL_TEXTURE_2D, tex);
+		if (pbo_ok) {
+			pglBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo[pbo_next]);
+			pbo_next = (pbo_next + 1) % kPbos;
+			pglBufferData(GL_PIXEL_UNPACK_BUFFER, output_size, NULL, GL_STREAM_DRAW);
+			dst = (uint8_t*)pglMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+			if (dst) {
+				for (auto& sp : spans)
+					memcpy(dst + sp.first * pitch, src + sp.first * pitch, (sp.second - sp.first) * pitch);
+				pglUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				src = NULL;	// offsets into the bound buffer from here on
+			} else {
+				pglBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+		}
+		for (auto& sp : spans)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, sp.first, output_width, sp.second - sp.first, GL_RGBA, GL_UNSIGNED_BYTE,
+				(const void*)((uintptr_t)src + sp.first * pitch));
+		if (dst) pglBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 	}
 	if (!headless) {
 		// Rendering
@@ -371,9 +427,6 @@ void SimVideo::UpdateTexture() {
 		SDL_GL_SwapWindow(window);
 	}
 #endif
-
-	frame_ready = 0;
-
 }
 
 void SimVideo::CleanUp() {
@@ -402,6 +455,48 @@ void SimVideo::CleanUp() {
 }
 
 
+// Sim thread: the frame in output_ptr is complete, hand it to the GUI. The
+// back buffer already holds everything up to its own last publish.
+void SimVideo::PublishFrame() {
+	uint32_t* dst = frames[frame_back];
+	uint32_t since = frame_seqs[frame_back];
+	for (int y = 0; y < output_height; y++) {
+		if (row_seq[y] > since)
+			memcpy(dst + y * output_width, output_ptr + y * output_width, output_width * 4);
+	}
+	frame_rows[frame_back] = row_seq;
+	frame_seqs[frame_back] = frame_seq++;
+	frame_back = frame_latest.exchange(frame_back | kFresh, std::memory_order_acq_rel) & ~kFresh;
+}
+
+// GUI thread: take the newest frame if one arrived since the last call
+const uint32_t* SimVideo::LatestFrame() {
+	if (!publish_frames) return output_ptr;
+	if (!(frame_latest.load(std::memory_order_acquire) & kFresh)) return NULL;
+	frame_front = frame_latest.exchange(frame_front, std::memory_order_acq_rel) & ~kFresh;
+	return frames[frame_front];
+}
+
+// GUI thread: rows of the front frame newer than the texture, merged into
+// spans across gaps of up to kSpanGap clean rows
+int SimVideo::DirtySpans() {
+	spans.clear();
+	if (!publish_frames) {
+		spans.push_back(std::make_pair(0, output_height));
+		return 1;
+	}
+	const std::vector<uint32_t>& rows = frame_rows[frame_front];
+	for (int y = 0; y < output_height; y++) {
+		if (rows[y] <= uploaded_seq) continue;
+		if (!spans.empty() && y - spans.back().second <= kSpanGap)
+			spans.back().second = y + 1;
+		else
+			spans.push_back(std::make_pair(y, y + 1));
+	}
+	uploaded_seq = frame_seqs[frame_front];
+	return (int)spans.size();
+}
+
 void SimVideo::StartFrame() {
 #ifdef WIN32
 	ImGui_ImplDX11_NewFrame();
@@ -414,18 +509,79 @@ void SimVideo::StartFrame() {
 #endif
 }
 
+void SimVideo::SetOrientation(int rotate, bool vflip) {
+	output_rotate = rotate;
+	output_vflip = vflip;
+	write_line = rotate ? &SimVideo::WriteColumn : &SimVideo::WriteRow;
+}
+
+// Unrotated: the line is one texture row (flipped rows for output_vflip)
+void SimVideo::WriteRow(int oy, int count) {
+	int y = output_vflip ? output_height - oy : oy;
+	if (y < 0) { y = 0; }
+	if (y > output_height - 1) { y = output_height - 1; }
+
+	// Pixels past the right edge clamp onto the last column; the last one wins
+	int n = count;
+	if (n > output_width) {
+		line[output_width - 1] = line[(n - 1) & kLineMask];
+		n = output_width;
+	}
+	uint32_t* dst = output_ptr + y * output_width;
+	if (memcmp(dst, line, n * 4)) {
+		memcpy(dst, line, n * 4);
+		row_seq[y] = frame_seq;
+	}
+}
+
+// Rotated by 90 degrees either way: the line is one texture column
+void SimVideo::WriteColumn(int oy, int count) {
+	int x = output_rotate == -1 ? oy : output_width - oy;
+	if (x < 0) { x = 0; }
+	if (x > output_width - 1) { x = output_width - 1; }
+
+	for (int i = 0; i < count && i < kLineMax; i++) {
+		int y = output_rotate == -1 ? output_height - i : i;
+		if (output_vflip) { y = output_height - y; }
+		if (y < 0) { y = 0; }
+		if (y > output_height - 1) { y = output_height - 1; }
+
+		uint32_t& p = output_ptr[y * output_width + x];
+		if (p != line[i]) {
+			p = line[i];
+			row_seq[y] = frame_seq;
+		}
+	}
+}
+
+void SimVideo::CommitLine() {
+	if (track_bounds) {
+		if (count_pixel > stats_xMax) { stats_xMax = count_pixel; }
+		if (count_line > stats_yMax) { stats_yMax = count_line; }
+		if (count_pixel < stats_xMin) { stats_xMin = count_pixel; }
+		if (count_line < stats_yMin) { stats_yMin = count_line; }
+	}
+	if (count_pixel) {
+		(this->*write_line)(count_line - 1, count_pixel);
+	}
+}
+
 void SimVideo::Clock(bool hblank, bool vblank, bool hsync, bool vsync, uint32_t colour) {
 
-	bool de = !(hblank || vblank);
+	// Inside the visible part of a line, away from any edge: just collect it
+	if (!(hblank | vblank | last_hblank | last_vblank)) {
+		line[count_pixel++ & kLineMask] = colour;
+		return;
+	}
 
-	bool hs_falling = (!hsync && last_hsync);
-	bool hs_rising = (hsync && !last_hsync);
+	bool de = !(hblank || vblank);
 	bool hb_falling = (!hblank && last_hblank);
-	bool hb_rising = (hblank && !last_hblank);
-	bool vs_falling = (!vsync && last_vsync);
-	bool vs_rising = (vsync && !last_vsync);
 	bool vb_falling = (!vblank && last_vblank);
-	bool vb_rising = (vblank && !last_vblank);
+
+	// Visible part of the line just ended
+	if (!de && !(last_hblank || last_vblank)) {
+		CommitLine();
+	}
 
 	if (!vblank) {
 		// Next line on end of hblank
@@ -435,16 +591,15 @@ void SimVideo::Clock(bool hblank, bool vblank, bool hsync, bool vsync, uint32_t
 			count_pixel = 0;
 		}
 		if (de) {
-			count_pixel++;
+			line[count_pixel++ & kLineMask] = colour;
 		}
 	}
 
-	//frame_ready = 1;
 	// Reset on vblank falling edge (start of visible frame at vcount=0)
 	if (vb_falling) {
 		count_frame++;
 		count_line = 0;
-		frame_ready = 1;
+		if (publish_frames) PublishFrame();
 #ifdef WIN32
 		GetSystemTime(&actualtime);
 		time_ms = (actualtime.wSecond * 1000) + actualtime.wMilliseconds;
@@ -458,50 +613,6 @@ void SimVideo::Clock(bool hblank, bool vblank, bool hsync, bool vsync, uint32_t
 		stats_fps = (float)(1000.0 / stats_frameTime);
 	}
 
-	// Only draw outside of blanks
-	if (de) {
-
-		int ox = count_pixel - 1;
-		int oy = count_line - 1;
-		int x = ox, xs = output_width, y = oy;
-
-		if (output_rotate == -1) {
-			// Rotate output by 90 degrees clockwise
-			y = output_height - ox;
-			xs = output_width;
-			x = oy;
-		}
-		if (output_rotate == 1) {
-			// Rotate output by 90 degrees clockwise
-			y = ox;
-			xs = output_width;
-			x = output_width - oy;
-		}
-
-		if (output_vflip) {
-			y = output_height - y;
-		}
-
-		// Clamp values to stop access violations on texture
-		if (x < 0) { x = 0; }
-		if (x > output_width - 1) { x = output_width - 1; }
-		if (y < 0) { y = 0; }
-		if (y > output_height - 1) { y = output_height - 1; }
-
-		// Generate texture address
-		uint32_t vga_addr = (y * xs) + x;
-
-		// Write pixel to texture
-		output_ptr[vga_addr] = colour;
-
-	}
-
-	// Track bounds (debug)
-	if (count_pixel > stats_xMax) { stats_xMax = count_pixel; }
-	if (count_line > stats_yMax) { stats_yMax = count_line; }
-	if (count_pixel < stats_xMin) { stats_xMin = count_pixel; }
-	if (count_line < stats_yMin) { stats_yMin = count_line; }
-
 	last_hblank = hblank;
 	last_vblank = vblank;
 	last_hsync = hsync;
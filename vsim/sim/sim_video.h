@@ -2,6 +2,8 @@
 
 #include <string>
 #include <cstdint>
+#include <atomic>
+#include <vector>
 #ifndef _MSC_VER
 #include "imgui_impl_sdl.h"
 #include "imgui_impl_opengl2.h"
@@ -31,15 +33,56 @@ public:
 	int stats_xMin;
 	int stats_yMax;
 	int stats_yMin;
+	bool track_bounds = false;	// update the stats_ bounds above, once per line
+
+	// Scanline being drawn. Clock() only stores pixels here; CommitLine()
+	// places the line when its visible part ends, through the writer
+	// SetOrientation() picked for the current rotate/flip.
+	static const int kLineMax = 2048;
+	static const int kLineMask = kLineMax - 1;
+	uint32_t line[kLineMax];
+	void (SimVideo::*write_line)(int oy, int count);
 
 	ImTextureID texture_id;
 
+	// Completed frames for the GUI thread while the sim runs on its own
+	// (triple buffer). At the start of each frame Clock() copies output_ptr
+	// into the back buffer and swaps it with the middle one; UpdateTexture()
+	// swaps the middle one to the front only when a newer frame is waiting.
+	// Neither side waits for the other.
+	bool publish_frames = false;
+	uint32_t* frames[3] = {};
+	int frame_back = 0;
+	int frame_front = 1;
+	std::atomic<int> frame_latest{ 2 };	// middle buffer index, | kFresh until taken
+	static const int kFresh = 4;
+
+	// Dirty rows. Clock() stamps a texture row with frame_seq when one of its
+	// pixels changes; each published buffer keeps a copy of the stamps, so
+	// PublishFrame() copies and UpdateTexture() uploads only rows newer than
+	// what that buffer / the texture already holds, however many frames the
+	// GUI skipped. A static screen uploads nothing.
+	uint32_t frame_seq = 1;			// frame being drawn
+	std::vector<uint32_t> row_seq;
+	std::vector<uint32_t> frame_rows[3];
+	uint32_t frame_seqs[3] = {};
+	uint32_t uploaded_seq = 0;
+	std::vector<std::pair<int, int>> spans;	// [first, last) rows to upload
+	static const int kSpanGap = 4;		// rows of clean gap worth uploading to save a call
+
 	SimVideo(int width, int height, int rotate);
 	~SimVideo();
 	void UpdateTexture();
 	void CleanUp();
 	void StartFrame();
 	void Clock(bool hblank, bool vblank, bool hsync, bool vsync, uint32_t colour);
+	void SetOrientation(int rotate, bool vflip);
+	void CommitLine();
+	void WriteRow(int oy, int count);
+	void WriteColumn(int oy, int count);
+	void PublishFrame();
+	const uint32_t* LatestFrame();	// newest published frame, or NULL if already taken
+	int DirtySpans();			// fill spans for the frame LatestFrame() returned
 	int Initialise(const char* windowTitle);
 };
 
@@ -0,0 +1,131 @@
+#include "sim_watchdog.h"
+#include "sim_hashlog.h"
+#include <stdio.h>
+#include <string.h>
+
+const char *SimWatchdog::Name(Status s)
+{
+	switch (s) {
+	case CRASH: return "CRASH";
+	case HANG: return "HANG";
+	case STATIC: return "STATIC";
+	default: return "OK";
+	}
+}
+
+bool SimWatchdog::Parse(const char *list)
+{
+	std::string s(list);
+	size_t pos = 0;
+	while (pos <= s.size()) {
+		size_t comma = s.find(',', pos);
+		std::string name = s.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+		if (name == "crash") detect_crash = true;
+		else if (name == "hang") detect_hang = true;
+		else if (name == "static") detect_static = true;
+		else if (name == "all") detect_crash = detect_hang = detect_static = true;
+		else {
+			fprintf(stderr, "Error: unknown detector '%s' (crash, hang, static, all)\n", name.c_str());
+			return false;
+		}
+		if (comma == std::string::npos) break;
+		pos = comma + 1;
+	}
+	return true;
+}
+
+void SimWatchdog::Trip(Status s, int frame, const std::string &why)
+{
+	status = s;
+	trip_frame = frame;
+	detail = why;
+	printf("WATCHDOG: %s at frame %d: %s\n", Name(s), frame, why.c_str());
+	fflush(stdout);
+}
+
+bool SimWatchdog::Frame(int frame, const uint32_t *fb, size_t fb_pixels)
+{
+	if (Tripped()) return false;
+
+	if (detect_crash && monitor) {
+		if (monitor_frame < 0) monitor_frame = frame;
+		if (frame - monitor_frame >= crash_frames) {
+			Trip(CRASH, frame, "entered the ROM monitor at frame " + std::to_string(monitor_frame));
+			return true;
+		}
+	}
+
+	if (detect_hang) {
+		if (fr_io) {
+			run_frames = 0;
+		} else if (fr_lo > fr_hi) {		// no fetches at all (WAI / STP)
+			run_frames++;
+		} else {
+			uint32_t lo = fr_lo < run_lo ? fr_lo : run_lo;
+			uint32_t hi = fr_hi > run_hi ? fr_hi : run_hi;
+			if (run_frames && hi - lo < kLoopBytes) {
+				run_lo = lo;
+				run_hi = hi;
+				run_frames++;
+			} else if (fr_hi - fr_lo < kLoopBytes) {	// start a new run here
+				run_lo = fr_lo;
+				run_hi = fr_hi;
+				run_frames = 1;
+			} else {
+				run_frames = 0;
+			}
+		}
+		if (!run_frames) {
+			run_lo = 0xFFFFFFFF;
+			run_hi = 0;
+		}
+		if (run_frames >= hang_frames) {
+			char why[128];
+			if (run_lo > run_hi)
+				snprintf(why, sizeof(why), "no instruction fetches for %d frames", run_frames);
+			else
+				snprintf(why, sizeof(why), "PC confined to %02X:%04X-%04X for %d frames with no I/O",
+				         run_lo >> 16, run_lo & 0xFFFF, run_hi & 0xFFFF, run_frames);
+			Trip(HANG, frame, why);
+			return true;
+		}
+	}
+
+	if (detect_static && fb) {
+		uint64_t h = SimHashLog::Hash(fb, fb_pixels * 4);
+		if (h == last_hash && !fr_disk)
+			same_frames++;
+		else
+			same_frames = 0;
+		last_hash = h;
+		if (same_frames >= static_frames) {
+			Trip(STATIC, frame, "screen unchanged for " + std::to_string(same_frames) + " frames with no disk activity");
+			return true;
+		}
+	}
+
+	fr_lo = 0xFFFFFFFF;
+	fr_hi = 0;
+	fr_io = fr_disk = false;
+	return false;
+}
+
+// One JSON object on one line, easy to pick apart from a shell script:
+//   {"status":"HANG","frame":412,"cycles":98304000,"pc":"00:2004","detail":"..."}
+bool SimWatchdog::WriteResult(const char *path, int frame, uint64_t cycles, uint32_t pbr_pc) const
+{
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "WATCHDOG: cannot write %s\n", path);
+		return false;
+	}
+	std::string d;
+	for (char c : detail) {
+		if (c == '"' || c == '\\') d += '\\';
+		d += c;
+	}
+	fprintf(f, "{\"status\":\"%s\",\"frame\":%d,\"cycles\":%llu,\"pc\":\"%02X:%04X\",\"detail\":\"%s\"}\n",
+	        Name(status), frame, (unsigned long long)cycles, (pbr_pc >> 16) & 0xFF, pbr_pc & 0xFFFF, d.c_str());
+	fclose(f);
+	return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// Early-termination detectors for batch runs (--detect). Fed from the CPU
+// clock edge and the vblank boundary; once one trips, the main loop stops the
+// run as if --stop-at-frame had been reached and --result records why.
+//
+//   CRASH   the CPU entered the ROM monitor (FF:9A00-9BFF, BRK / reset into
+//           the monitor); stops crash_frames later so the screenshot shows it
+//   HANG    every opcode fetch for hang_frames frames fell inside one window
+//           of kLoopBytes bytes (or there were none: WAI / STP) and there was
+//           no I/O page access at all
+//   STATIC  the framebuffer hash did not change for static_frames frames and
+//           there was no IWM or HDD access in that time
+struct SimWatchdog {
+	enum Status { OK, CRASH, HANG, STATIC };
+	static const uint32_t kLoopBytes = 32;
+
+	bool detect_crash = false, detect_hang = false, detect_static = false;
+	int crash_frames = 30;
+	int hang_frames = 300;		// ~5 s of guest time
+	int static_frames = 600;	// ~10 s
+
+	Status status = OK;
+	int trip_frame = -1;
+	std::string detail;
+
+	bool Enabled() const { return detect_crash || detect_hang || detect_static; }
+	bool Tripped() const { return status != OK; }
+	bool Parse(const char *list);	// "crash,hang,static" or "all"
+
+	// CPU cycle hooks (bus address, 24 bits)
+	void Fetch(uint32_t addr) {
+		if (addr < fr_lo) fr_lo = addr;
+		if (addr > fr_hi) fr_hi = addr;
+		if ((addr >> 16) == 0xFF && (addr & 0xFFFF) >= 0x9A00 && (addr & 0xFFFF) <= 0x9BFF)
+			monitor = true;
+	}
+	void Data(uint32_t addr) {
+		uint32_t bank = addr >> 16, a16 = addr & 0xFFFF;
+		if ((bank == 0x00 || bank == 0x01 || bank == 0xE0 || bank == 0xE1) && (a16 & 0xFF00) == 0xC000) {
+			fr_io = true;
+			if (a16 >= 0xC0E0 || a16 == 0xC031) fr_disk = true;	// IWM, HDD, disk register
+		}
+	}
+	void Monitor() { monitor = true; }
+
+	// vblank: returns true when a detector has just tripped
+	bool Frame(int frame, const uint32_t *fb, size_t fb_pixels);
+
+	static const char *Name(Status s);
+	bool WriteResult(const char *path, int frame, uint64_t cycles, uint32_t pbr_pc) const;
+
+private:
+	// current frame
+	uint32_t fr_lo = 0xFFFFFFFF, fr_hi = 0;
+	bool fr_io = false, fr_disk = false;
+	bool monitor = false;
+	int monitor_frame = -1;
+
+	// HANG: union of fetch windows over the confined run
+	uint32_t run_lo = 0xFFFFFFFF, run_hi = 0;
+	int run_frames = 0;
+
+	// STATIC
+	uint64_t last_hash = 0;
+	int same_frames = 0;
+
+	void Trip(Status s, int frame, const std::string &why);
+};
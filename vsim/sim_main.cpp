@@ -30,6 +30,17 @@
 #include "sim_audio.h"
 #include "sim_input.h"
 #include "sim_clock.h"
+#include "sim_hashlog.h"
+#include "sim_watchdog.h"
+#include "sim_trigger.h"
+#include "sim_profile.h"
+#include "sim_calltrace.h"
+#include "sim_irqstats.h"
+#include "sim_busstats.h"
+#include "sim_log.h"
+#include "sim_perf.h"
+#include "sim_commands.h"
+#include "sim_fastram.h"
 #include "iigs_fmt.h"      // shared Apple IIgs disk-format codec
 #include <unistd.h>
 #include <vector>
@@ -48,6 +59,7 @@
 #include <string>
 #include <iomanip>
 #include <thread>
+#include <atomic>
 #include <chrono>
 #include <vector>
 #include <map>
@@ -70,7 +82,7 @@ enum class RunState {Stopped, Running, SingleClock, MultiClock, StepIn, NextIRQ}
 // Simulation control
 // ------------------
 int initialReset = 48;
-RunState run_state = RunState::Running;
+std::atomic<RunState> run_state(RunState::Running);
 bool adam_mode = 1;
 int batchSize = 100000;
 int multi_step_amount = 1024;
@@ -82,12 +94,13 @@ const char* windowTitle_Control = "Simulation control";
 const char* windowTitle_DebugLog = "Debug log";
 const char* windowTitle_Video = "VGA output";
 const char* windowTitle_Audio = "Audio output";
+const char* windowTitle_Perf = "Performance";
 bool showDebugLog = true;
 DebugConsole console;
 MemoryEditor mem_edit;
-char pc_breakpoint[10] = "";
-int pc_breakpoint_addr = 0;
+char pc_breakpoint[10] = "";	// GUI widgets
 bool pc_break_enabled;
+long pc_breakpoint_addr = -1;	// what the CPU hook compares, set through to_sim
 bool break_pending = false;
 bool old_vpb = false;
 // Track MVN operands for better source/dest diagnostics
@@ -185,6 +198,9 @@ static inline void hdd_ring_record(unsigned char pbr, unsigned short pc, unsigne
 
 // ROM version selection (0=ROM3, 1=ROM1, default ROM3)
 int initial_rom_select = 0;
+// --fast-rom-load: poke the ROMs straight into fastram instead of streaming
+// them through the ioctl download (which is kept for MiSTer-faithful runs)
+bool fast_rom_load = false;
 
 // Self-test mode support
 bool selftest_mode = false;
@@ -231,6 +247,16 @@ bool headless = false;
 // --------------
 Vemu* top = NULL;
 
+// Fast RAM/ROM (banks 00-FF): the fastram dpram inside the model, or the host
+// buffer behind fastram_dpi.sv in a FASTRAM=host build
+static inline uint8_t* fastRam() {
+#ifdef FASTRAM_HOST
+	return fastram_host.mem;
+#else
+	return (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+#endif
+}
+
 // --- Stage 0: beam-position drift trace (lightweight, self-contained) ---
 // Logs one row per enabled CPU cycle within [beam_trace_start, beam_trace_end],
 // capturing the video beam position (V, H_CHAR) at the instant the CPU cycle
@@ -338,7 +364,7 @@ double sc_time_stamp() {	// Called by $time in Verilog.
 	return main_time;
 }
 
-int CLK_14M_freq = 24000000;
+int CLK_14M_freq = 14318180;	// CLK_14M rising edges per emulated second
 SimClock CLK_14M(1);
 
 int soft_reset = 0;
@@ -363,6 +389,164 @@ uint32_t g_vbl_count;
 #ifndef DISABLE_AUDIO
 SimAudio audio(CLK_14M_freq, false);
 #endif
+// --audio-out / --audio-fingerprint / --audio-frames
+const char* audio_out_path = nullptr;
+const char* audio_fp_path = nullptr;
+int audio_first_frame = 0, audio_last_frame = -1;
+
+// --hash-log: per-frame state hashes (compare with tools/hashcmp)
+SimHashLog hashlog;
+const char* hash_log_path = nullptr;
+int vblank_frame = 0;
+
+// --detect / --result: early termination on crash / hang / static screen
+SimWatchdog watchdog;
+const char* result_path = nullptr;
+
+// --trigger: condition-based screenshot / dump / text / stop
+SimTriggers triggers;
+unsigned trigger_actions = 0;	// fired at vblank, run by the main loop
+
+// --profile / --profile-folded: cycles per PBR:PC and call path
+SimProfile profile;
+const char* profile_path = nullptr;
+const char* profile_folded_path = nullptr;
+unsigned long long profile_tick = 0;	// g_tick14 at the previous CPU cycle
+
+// --calltrace: Toolbox / GS/OS / ProDOS MLI call counts and latency
+SimCallTrace calltrace;
+const char* calltrace_path = nullptr;
+
+// --irq-stats / --irq-log: interrupt latency per IRQ source
+SimIrqStats irqstats;
+const char* irqstats_path = nullptr;
+const char* irqlog_path = nullptr;
+
+// --bus-stats / --bus-log: fast / refresh / slow / sync cycle accounting
+SimBusStats busstats;
+const char* busstats_path = nullptr;
+
+// GUI performance panel: CPU cycle mix from the CPU hook, RunBatch wall time
+SimPerf perf;
+double perf_run_s = 0;
+char perf_csv_path[256] = "perf.csv";
+
+// --eval-time: wall time spent inside top->eval() alone, reported in SIMSTATS
+// (stub_bench.sh). Off by default: two clock reads per tick are not free.
+bool eval_timing = false;
+double eval_s = 0;
+
+// GUI mode runs the simulation on its own thread (simThread). Everything the
+// GUI changes in the model goes through to_sim; results come back on to_gui.
+SimCommands to_sim, to_gui;
+// One host input update in the ring at a time (GUI loop)
+std::atomic<bool> host_input_queued{false};
+bool host_input_sent = false;
+std::atomic<bool> sim_quit(false);
+int sim_exit_code = -1;			// set by the sim thread when a stop condition ends the run
+std::string gui_disk_name[kVDNUM];	// GUI copy of blockdevice.disk_name
+
+// --load: copy a file into RAM at a vblank (bench.sh injects its programs this way)
+struct RamLoad {
+	std::string path;
+	uint32_t addr;
+	int frame;
+};
+std::vector<RamLoad> ram_loads;
+
+// Copy each --load whose frame has come into fastram, or slowram for E0/E1.
+// Done at vblank, so a --reset-at-frame on the same frame already sees it.
+static void ramLoadFrame() {
+	for (size_t i = 0; i < ram_loads.size();) {
+		const RamLoad& l = ram_loads[i];
+		if (video.count_frame < l.frame) { i++; continue; }
+		FILE* f = fopen(l.path.c_str(), "rb");
+		if (!f) {
+			fprintf(stderr, "LOAD: cannot open %s\n", l.path.c_str());
+		} else {
+			uint32_t bank = l.addr >> 16;
+			uint8_t* dst;
+			size_t room;
+			if (bank == 0xE0 || bank == 0xE1) {
+				dst = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram + (l.addr & 0x1FFFF);
+				room = 0x20000 - (l.addr & 0x1FFFF);
+			} else {
+				dst = fastRam() + l.addr;
+				room = 0x1000000 - l.addr;
+			}
+			size_t n = fread(dst, 1, room, f);
+			fclose(f);
+			printf("LOAD: %s -> %02X:%04X (%zu bytes) at frame %d\n", l.path.c_str(), bank, l.addr & 0xFFFF, n,
+			       video.count_frame);
+		}
+		ram_loads.erase(ram_loads.begin() + i);
+	}
+}
+
+// Displayed text page mode from the soft switches. With 80STORE on, PAGE2
+// selects aux memory for writes instead of the displayed page. Super Hi-Res
+// (NEWVIDEO bit 7) hides the text page whatever TEXT says; graphics with
+// MIXED shows only its last 4 rows.
+static SimTextMode textMode() {
+	SimTextMode m;
+	m.col80 = VERTOPINTERN->emu__DOT__iigs__DOT__EIGHTYCOL;
+	m.page2 = VERTOPINTERN->emu__DOT__iigs__DOT__PAGE2 && !VERTOPINTERN->emu__DOT__iigs__DOT__STORE80;
+	m.altchar = VERTOPINTERN->emu__DOT__iigs__DOT__ALTCHARSET;
+	if (VERTOPINTERN->emu__DOT__iigs__DOT__NEWVIDEO & 0x80) m.first_row = 24;
+	else if (!VERTOPINTERN->emu__DOT__iigs__DOT__TEXTG) m.first_row = VERTOPINTERN->emu__DOT__iigs__DOT__MIXG ? 20 : 24;
+	return m;
+}
+
+// Decode the text screen the video is showing (banks E0/E1 in slowram)
+static void textScreen(std::vector<std::string>& rows) {
+	const uint8_t* slowram = (const uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
+	SimTextScreen(slowram, slowram + 0x10000, textMode(), rows);
+}
+
+static void triggerFrame() {
+	SimTriggerView view;
+	view.fastram = fastRam();
+	view.slowram = (const uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
+	view.text = textMode();
+	trigger_actions |= triggers.Frame(video.count_frame, view);
+}
+
+static void hashLogFrame() {
+	uint8_t cpu[16];
+	uint16_t a = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__A, x = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__X;
+	uint16_t y = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__Y, d = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__D;
+	uint16_t sp = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__SP, pc = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PC;
+	uint16_t p = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__P;
+	uint8_t dbr = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__DBR, pbr = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PBR;
+	memcpy(cpu + 0, &a, 2); memcpy(cpu + 2, &x, 2); memcpy(cpu + 4, &y, 2); memcpy(cpu + 6, &d, 2);
+	memcpy(cpu + 8, &sp, 2); memcpy(cpu + 10, &pc, 2); memcpy(cpu + 12, &p, 2);
+	cpu[14] = dbr; cpu[15] = pbr;
+
+	uint8_t ss[] = {
+		VERTOPINTERN->emu__DOT__iigs__DOT__ALTZP, VERTOPINTERN->emu__DOT__iigs__DOT__RAMRD,
+		VERTOPINTERN->emu__DOT__iigs__DOT__RAMWRT, VERTOPINTERN->emu__DOT__iigs__DOT__STORE80,
+		VERTOPINTERN->emu__DOT__iigs__DOT__PAGE2, VERTOPINTERN->emu__DOT__iigs__DOT__HIRES_MODE,
+		VERTOPINTERN->emu__DOT__iigs__DOT__TEXTG, VERTOPINTERN->emu__DOT__iigs__DOT__MIXG,
+		VERTOPINTERN->emu__DOT__iigs__DOT__EIGHTYCOL, VERTOPINTERN->emu__DOT__iigs__DOT__AN3,
+		VERTOPINTERN->emu__DOT__iigs__DOT__RDROM, VERTOPINTERN->emu__DOT__iigs__DOT__LC_WE,
+		VERTOPINTERN->emu__DOT__iigs__DOT__LCRAM2, VERTOPINTERN->emu__DOT__iigs__DOT__INTCXROM,
+		VERTOPINTERN->emu__DOT__iigs__DOT__NEWVIDEO, VERTOPINTERN->emu__DOT__iigs__DOT__shadow,
+		VERTOPINTERN->emu__DOT__iigs__DOT__CYAREG, VERTOPINTERN->emu__DOT__iigs__DOT__SLTROMSEL,
+	};
+
+	hashlog.Frame(video.count_frame, main_time, (uint32_t)pbr << 16 | pc,
+	              output_ptr, (size_t)output_width * output_height,
+	              cpu, sizeof(cpu), ss, sizeof(ss),
+	              (const uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram, 0x20000,
+	              fastRam());
+}
+
+static void writeRunResult() {
+	if (!result_path) return;
+	uint32_t pbr_pc = (uint32_t)VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PBR << 16 |
+	                  VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PC;
+	watchdog.WriteResult(result_path, video.count_frame, main_time, pbr_pc);
+}
 
 // Reset simulation variables and clocks
 void resetSim() {
@@ -402,10 +586,8 @@ long log_index;
 
 bool writeLog(const char* line)
 {
-	// Print to stdout unless in quiet mode
-	if (!quiet_mode) {
-		printf("%s\n",line);
-	}
+	// CPU trace to the log (--quiet drops it to warnings)
+	SIMLOG(LOG_CPU, LOG_INFO, "%s\n", line);
 
 	// Only do memory-intensive operations when debug_6502 is enabled
 	if (debug_6502) {
@@ -634,6 +816,50 @@ static const struct dasm_data32 gs_vectors[] =
 	{ 0xffff, "" }
 };
 
+// Profiler labels: the vector/entry names above, or the monitor ROM names
+// for code in the F8 ROM area; "NAME+$xx" when just past one.
+static std::string profileName(uint32_t addr) {
+	const char* best = nullptr;
+	uint32_t base = 0;
+	for (int i = 0; gs_vectors[i].addr != 0xffff; i++) {
+		uint32_t v = gs_vectors[i].addr;
+		if (v <= addr && addr - v < 4 && (!best || v > base)) { best = gs_vectors[i].name; base = v; }
+	}
+	uint32_t bank = addr >> 16, a16 = addr & 0xFFFF;
+	if (!best && a16 >= 0xF800 && (bank == 0x00 || bank == 0xE0 || bank == 0xE1 || bank == 0xFF)) {
+		for (int i = 0; a2_stuff[i].addr != 0xffff; i++) {
+			uint32_t v = a2_stuff[i].addr;
+			if (v >= 0xF800 && v <= a16 && a16 - v < 0x80 && (!best || v > base)) { best = a2_stuff[i].name; base = v; }
+		}
+		base |= addr & 0xFF0000;
+	}
+	if (!best) return std::string();
+	if (addr == base) return best;
+	return fmt::format("{}+${:x}", best, addr - base);
+}
+
+// --profile / --calltrace / --irq-stats / --bus-stats reports, once, on the way out
+static void writeExitReports() {
+	if (profile.active) {
+		if (profile_path) profile.Write(profile_path, profileName);
+		if (profile_folded_path) profile.WriteFolded(profile_folded_path, profileName);
+		profile.active = false;
+	}
+	if (calltrace.active) {
+		calltrace.Write(calltrace_path);
+		calltrace.active = false;
+	}
+	if (irqstats.active) {
+		if (irqstats_path) irqstats.Write(irqstats_path);
+		irqstats.active = false;
+	}
+	if (busstats.active) {
+		busstats.Summary(stdout);
+		if (busstats_path) busstats.Write(busstats_path);
+		busstats.active = false;
+	}
+}
+
 
 void DumpInstruction() {
 	// Fast path: when quiet mode is active and the in-memory CPU log is disabled,
@@ -1185,11 +1411,16 @@ int verilate() {
 			// separated in time from the CPU write (1st eval, on the CLK_14M edge) --
 			// matching hardware clk_28/clk_sys=/2 and killing the collapsed-clock
 			// same-edge stale read that streaks textfunk's tunnel center.
+			std::chrono::steady_clock::time_point eval_t0;
+			if (eval_timing) eval_t0 = std::chrono::steady_clock::now();
 			top->clk_vid_ext = 0; top->eval();
 			top->clk_vid_ext = 1; top->eval();
 #else
+			std::chrono::steady_clock::time_point eval_t0;
+			if (eval_timing) eval_t0 = std::chrono::steady_clock::now();
 			top->eval();
 #endif
+			if (eval_timing) eval_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - eval_t0).count();
 
 #if VM_TRACE_VCD
 			if (tfp && video.count_frame >= dump_vcd_after_frame)
@@ -1216,12 +1447,61 @@ int verilate() {
 					unsigned char we_n = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__WE;
 					unsigned char we = !we_n;  // Convert to active HIGH for consistency
 					unsigned long addr = VERTOPINTERN->emu__DOT__iigs__DOT__addr_bus;
+					// The CPU's own address, before the memory map moves it (LC bank 2,
+					// aux, E0/E1). On an opcode fetch this is PBR:PC; code-keyed tools
+					// (profile, calltrace, pc== triggers) use it, bus tools use addr.
+					uint32_t cpu_addr = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__A_OUT;
 					unsigned char nextstate = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__NextState;
 					
                     // Extract bank and address for memory tracking
                     unsigned char bank = (addr >> 16) & 0xFF;
                     unsigned short addr16 = addr & 0xFFFF;
 
+                    if (we && vda && hashlog.active) hashlog.MarkWrite(addr);
+                    if (profile.active) {
+                        SimProfile::Type type = VERTOPINTERN->emu__DOT__iigs__DOT__slow ? SimProfile::SLOW :
+                                                VERTOPINTERN->emu__DOT__iigs__DOT__slowMem ? SimProfile::SYNC : SimProfile::FAST;
+                        profile.Cycle(cpu_addr, vpa && nextstate == 1, din, !vpb, type, (uint32_t)(g_tick14 - profile_tick));
+                        profile_tick = g_tick14;
+                    }
+                    if (perf.active)
+                        perf.Cycle(VERTOPINTERN->emu__DOT__iigs__DOT__slow ? SimPerf::SLOW :
+                                   VERTOPINTERN->emu__DOT__iigs__DOT__slowMem ? SimPerf::SYNC : SimPerf::FAST);
+                    if (busstats.active)
+                        busstats.Cycle(addr, we, VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PBR,
+                                       VERTOPINTERN->emu__DOT__iigs__DOT__slow, VERTOPINTERN->emu__DOT__iigs__DOT__slowMem,
+                                       g_tick14);
+                    if (irqstats.active) {
+                        // same gating as cpu_irq in iigs.sv
+                        unsigned pend = VERTOPINTERN->emu__DOT__iigs__DOT__irq_pending;
+                        unsigned inten = VERTOPINTERN->emu__DOT__iigs__DOT__INTEN;
+                        unsigned lines =
+                            ((pend >> 3) & (inten >> 3) & 1) << SimIrqStats::VBL |
+                            ((pend >> 4) & (inten >> 4) & 1) << SimIrqStats::QSEC |
+                            ((pend >> 1) & 1) << SimIrqStats::SCANLINE |
+                            ((pend >> 2) & 1) << SimIrqStats::ONESEC |
+                            (VERTOPINTERN->emu__DOT__iigs__DOT__snd_irq & 1) << SimIrqStats::SOUND |
+                            ((pend >> 7) & 1) << SimIrqStats::SCC |
+                            (VERTOPINTERN->emu__DOT__iigs__DOT__adb_kbd_srq_irq & 1) << SimIrqStats::ADB;
+                        irqstats.Cycle(lines, VERTOPINTERN->emu__DOT__iigs__DOT__cpu_irq, !vpb,
+                                       vpa && nextstate == 1 && din == 0x40, g_tick14);
+                    }
+                    if (calltrace.active) {
+                        calltrace.Cycle();
+                        if (vpa && nextstate == 1)
+                            calltrace.Fetch(cpu_addr, VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__SP,
+                                            VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__X,
+                                            VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__P);
+                    }
+                    if (watchdog.Enabled()) {
+                        if (vpa) watchdog.Fetch(addr);
+                        else if (vda) watchdog.Data(addr);
+                    }
+                    if (triggers.Active()) {
+                        if (vpa && vda) triggers.Fetch(cpu_addr);
+                        else if (vda) triggers.Data(addr);
+                    }
+
                     // --- Stage 0 beam-drift trace: sample (V,H_CHAR) at this CPU cycle ---
                     if (beam_trace_active(video.count_frame)) {
                         unsigned vpos  = VERTOPINTERN->emu__DOT__iigs__DOT__V;
@@ -1732,7 +2012,7 @@ int verilate() {
                             static bool code_integrity_done = false;
                             if (!code_integrity_done && video.count_frame == 870 && vpa) {
                                 code_integrity_done = true;
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
                                 printf("CODE_INTEGRITY at frame=%d:\n", video.count_frame);
                                 // Bank 02 at 27F0
@@ -1782,7 +2062,7 @@ int verilate() {
                             unsigned short pc_gs = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PC;
                             unsigned char pbr_gs = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PBR;
                             if (vpa && pbr_gs == 0xE1 && (pc_gs == 0x00A8 || pc_gs == 0x00B0) && gsos_call_count < 500) {
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
                                 uint16_t sp = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__SP;
                                 uint8_t ret_pcl = fastram[sp + 1];
@@ -1988,7 +2268,7 @@ int verilate() {
                                     fulltrace_done = true;
                                     // Dump parm block state at end of trace
                                     uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
-                                    uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                    uint8_t* fastram = fastRam();
                                     printf("FULLTRACE END: PC=%02X:%04X SP=%04X frame=%d\n",
                                            bank, addr16, sp, video.count_frame);
                                     printf("  Parm block (slow E0:E168): ");
@@ -2010,7 +2290,7 @@ int verilate() {
                             static int parm_wp_count = 0;
                             if (video.count_frame >= 760 && video.count_frame <= 800 && parm_wp_count < 50) {
                                 uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 if (!parm_wp_init) {
                                     parm_wp_init = true;
                                     for (int i = 0; i < 24; i++) {
@@ -2068,7 +2348,7 @@ int verilate() {
                                 unsigned char dbr = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__DBR;
                                 printf("  REGS: A=%04X X=%04X Y=%04X P=%02X SP=%04X D=%04X DBR=%02X\n",
                                        a, x, y, p, sp, d, dbr);
-                                uint8_t* fr = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fr = fastRam();
                                 printf("  STK@SP: ");
                                 for (int i = -2; i <= 16; i++) {
                                     unsigned short saddr = (sp + i) & 0xFFFF;
@@ -2143,7 +2423,7 @@ int verilate() {
                             static bool dumped_hotspots = false;
                             if (video.count_frame == 800 && vpa && !dumped_hotspots) {
                                 dumped_hotspots = true;
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
                                 printf("GSOS_STARTUP_DUMP at frame=%d:\n", video.count_frame);
                                 // GS/OS startup code at E0:E800-E840
@@ -2260,7 +2540,7 @@ int verilate() {
                                 // When BFA5 is first executed, dump the actual opcode
                                 if (!bfa5_checked && pbr_s == 0x00 && pc_s == 0xBFA5) {
                                     bfa5_checked = true;
-                                    uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                    uint8_t* fastram = fastRam();
                                     uint8_t ir = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__IR;
                                     printf("BFA5_OPCODE: IR=%02X fastram[BFA5]=%02X fastram[BFA6]=%02X fastram[BFA7]=%02X frame=%d\n",
                                            ir, fastram[0xBFA5], fastram[0xBFA6], fastram[0xBFA7], video.count_frame);
@@ -2305,7 +2585,7 @@ int verilate() {
                             unsigned short pc_now_dr = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PC;
                             unsigned char pbr_now_dr = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PBR;
                             if (pbr_now_dr == 0xFF && pc_now_dr == 0x3C40 && vpa && driver_ret_count >= 170 && driver_ret_count < 250) {
-                                uint8_t* mainram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* mainram = fastRam();
                                 uint16_t sp = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__SP;
                                 // RTS pops 2 bytes (PCL, PCH), adds 1
                                 uint8_t ret_lo = mainram[sp + 1];
@@ -2335,7 +2615,7 @@ int verilate() {
                             unsigned char pbr_now = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PBR;
                             if (pbr_now == 0xFF && pc_now == 0x5D65 && vpa && appledisk_call_count < 500) {
                                 appledisk_call_count++;
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 // At this point, NONtoEXT may have already run (if non-extended cmd)
                                 // Extended format: $42-$44=buf, $45=cmdcode, $46=pcount,
                                 //   $47=unused, $48-$4B=block(32bit)
@@ -2494,7 +2774,7 @@ int verilate() {
                                     uint8_t dbr = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__DBR;
                                     // Read block and buffer from BOTH main RAM (bank 0) and slow RAM (bank E1)
                                     // using DP-relative offsets
-                                    uint8_t* mainram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                    uint8_t* mainram = fastRam();
                                     // cmdblockl at DP+$48 in bank 0
                                     uint16_t dp_blk_off = dp_reg + 0x48;
                                     uint32_t dp_blk = mainram[dp_blk_off] | (mainram[dp_blk_off+1] << 8) |
@@ -2519,7 +2799,7 @@ int verilate() {
                                     const int bank_e1_offset = 0x10000;
                                     uint8_t error2 = slowram[bank_e1_offset + 0x0F44];
                                     // Read DP values for block number and buffer
-                                    uint8_t* mainram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                    uint8_t* mainram = fastRam();
                                     uint16_t dp_reg = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__D;
                                     uint16_t dp_buf_off = dp_reg + 0x42;
                                     uint32_t buf_addr = mainram[dp_buf_off] | (mainram[dp_buf_off+1] << 8) |
@@ -2809,7 +3089,7 @@ int verilate() {
                                     if (buf_dump_count < 300) {
                                         buf_dump_count++;
                                         uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
-                                        uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                        uint8_t* fastram = fastRam();
                                         const int bank_e1_offset = 0x10000;
                                         unsigned short d_reg = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__D;
                                         unsigned char altzp = VERTOPINTERN->emu__DOT__iigs__DOT__ALTZP;
@@ -2872,7 +3152,7 @@ int verilate() {
                             static int aede_count2 = 0;
                             if (pc_now_ae == 0xAEDE && pbr_now_ae == 0x00 && vpa && aede_count2 < 300) {
                                 aede_count2++;
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
                                 unsigned short a_reg = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__A;
                                 unsigned char p_reg = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__P;
@@ -2908,7 +3188,7 @@ int verilate() {
                         {
                             unsigned short pc_f4 = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PC;
                             unsigned char pbr_f4 = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__PBR;
-                            uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                            uint8_t* fastram = fastRam();
                             uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
                             // Trap at key points in E0:F4xx loop during stuck calls
                             {
@@ -3108,7 +3388,7 @@ int verilate() {
                         {
                             static uint8_t prev_07f8 = 0xFF;
                             static int w07f8_count = 0;
-                            uint8_t* fastram_07 = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                            uint8_t* fastram_07 = fastRam();
                             uint8_t cur_07f8 = fastram_07[0x07F8];
                             if (cur_07f8 != prev_07f8 && w07f8_count < 30) {
                                 w07f8_count++;
@@ -3137,7 +3417,7 @@ int verilate() {
                         {
                             static uint8_t prev_7758 = 0xFF;
                             static int w7758_count = 0;
-                            uint8_t* fastram_7758 = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                            uint8_t* fastram_7758 = fastRam();
                             uint8_t cur_7758 = fastram_7758[0x7758];
                             if (cur_7758 != prev_7758 && w7758_count < 30) {
                                 w7758_count++;
@@ -3169,7 +3449,7 @@ int verilate() {
                         {
                             static uint16_t prev_bd04 = 0xFFFF;
                             static int bd04_count = 0;
-                            uint8_t* fastram_bd04 = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                            uint8_t* fastram_bd04 = fastRam();
                             uint16_t cur_bd04 = fastram_bd04[0xBD04] | (fastram_bd04[0xBD05] << 8);
                             if (cur_bd04 != prev_bd04 && bd04_count < 30) {
                                 bd04_count++;
@@ -3210,7 +3490,7 @@ int verilate() {
                         {
                             static uint16_t prev_bd28 = 0xFFFF;
                             static int bd28_count = 0;
-                            uint8_t* fastram_wp = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                            uint8_t* fastram_wp = fastRam();
                             uint16_t cur_bd28 = fastram_wp[0xBD28] | (fastram_wp[0xBD29] << 8);
                             if (cur_bd28 != prev_bd28 && bd28_count < 200) {
                                 bd28_count++;
@@ -3240,7 +3520,7 @@ int verilate() {
                                 unsigned char dbr_now = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__DBR;
                                 unsigned char p_now = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__P;
                                 uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 printf("WOZ_E455 #%d: A=%04X X=%04X Y=%04X D=%04X SP=%04X DBR=%02X P=%02X\n",
                                        e455_count, a_now, x_now, y_now, d_now, sp_now, dbr_now, p_now);
                                 // Dump 128 bytes of code around E455 (E400-E47F)
@@ -3288,7 +3568,7 @@ int verilate() {
                                 unsigned short a_wp = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__A;
                                 unsigned short d_wp = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__D;
                                 unsigned short sp_wp = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__SP;
-                                uint8_t* fastram_wp = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram_wp = fastRam();
                                 printf("WOZ_VCR2E_CHANGE #%d: %04X -> %04X at PC=%02X:%04X A=%04X D=%04X SP=%04X frame=%d\n",
                                        vcr2e_count, prev_vcr2e, cur_vcr2e, pbr_wp, pc_wp, a_wp, d_wp, sp_wp, video.count_frame);
                                 // Dump code at the PC and surrounding area
@@ -3307,7 +3587,7 @@ int verilate() {
                             static uint16_t prev_vcr42 = 0xFFFF;
                             static int vcr42_count = 0;
                             uint8_t* slowram_wp = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
-                            uint8_t* fastram_wp = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                            uint8_t* fastram_wp = fastRam();
                             uint16_t cur_vcr42 = slowram_wp[0xE128] | (slowram_wp[0xE129] << 8);
                             if (cur_vcr42 != prev_vcr42 && vcr42_count < 200) {
                                 vcr42_count++;
@@ -3457,7 +3737,7 @@ int verilate() {
                                 f571_count++;
                                 unsigned char p = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__P;
                                 unsigned short a = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__A;
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 uint8_t aa00 = fastram[0xAA00];
                                 uint8_t aa01 = fastram[0xAA01];
                                 printf("GSOS_F571 #%d: carry=%d A=%04X $AA00=%02X %02X frame=%d\n",
@@ -3471,7 +3751,7 @@ int verilate() {
                             if (bank == 0xE0 && (addr16 == 0xF54A || addr16 == 0xF538) && vpa && f54a_count < 20) {
                                 f54a_count++;
                                 unsigned short sp = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__SP;
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 // RTS return addr is at SP+1,SP+2 (lo,hi), RTS adds 1
                                 uint8_t ret_lo = fastram[(sp+1) & 0xFFFF];
                                 uint8_t ret_hi = fastram[(sp+2) & 0xFFFF];
@@ -3560,7 +3840,7 @@ int verilate() {
                             static uint16_t prev_9a00 = 0xFFFF;
                             static int w9a_count = 0;
                             static int w9a_armed = 0; // only arm after APPLEDISK fires enough times
-                            uint8_t* fastram_9a = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                            uint8_t* fastram_9a = fastRam();
                             uint16_t cur_9a00 = fastram_9a[0x9A00] | (fastram_9a[0x9A01] << 8);
                             // Also check bytes 4-5 to detect content changes
                             uint16_t cur_9a04 = fastram_9a[0x9A04] | (fastram_9a[0x9A05] << 8);
@@ -3593,7 +3873,7 @@ int verilate() {
                                 unsigned short x = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__X;
                                 unsigned short y = VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__Y;
                                 uint8_t* slowram = (uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram;
-                                uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fastram = fastRam();
                                 uint8_t shadow_reg = VERTOPINTERN->emu__DOT__iigs__DOT__shadow;
                                 uint8_t retry   = slowram[0x10000 + 0x0FB1]; // Retry
                                 // Get RTL return address from stack (SP+1 = low, SP+2 = high, SP+3 = bank)
@@ -3774,8 +4054,7 @@ int verilate() {
 					old_vpb = vpb;
 
 					if (vpa && nextstate == 1) {
-						const long break_addr = strtol(pc_breakpoint, NULL, 16);
-						break_pending |= pc_break_enabled && break_addr == ins_pc[0];
+						break_pending |= pc_breakpoint_addr == ins_pc[0];
 						break_pending |= run_state == RunState::StepIn;
 						//console.AddLog(fmt::format("LOG? ins_index ={0:x} ins_pc[0]={1:06x} ", ins_index, ins_pc[0]).c_str());
 													// JSR/JSL
@@ -3861,7 +4140,7 @@ int verilate() {
                                 static bool b2_reported = false;
                                 if (!b2_reported && pbr_now == 0x17) {
                                     b2_reported = true;
-                                    uint8_t* fr = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                    uint8_t* fr = fastRam();
                                     for (int b = 0x02; b <= 0x20; b++) {
                                         int nz = 0, first = -1, last = -1;
                                         for (int o = 0; o < 0x10000; o++) {
@@ -3886,7 +4165,7 @@ int verilate() {
                                 static bool bank17_init = false;
                                 static int bank17_writes_logged = 0;
                                 static int bank17_writes_total = 0;
-                                uint8_t* fr = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fr = fastRam();
                                 uint8_t* bank17 = fr + 0x170000;
                                 if (!bank17_init) {
                                     memcpy(bank17_shadow, bank17, 0x10000);
@@ -3915,7 +4194,7 @@ int verilate() {
                                 static unsigned char prev_17e4 = 0;
                                 static bool prev_init = false;
                                 static int watch_hits = 0;
-                                uint8_t* fr = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+                                uint8_t* fr = fastRam();
                                 unsigned char v4 = fr[0x17E4];
                                 if (!prev_init) { prev_17e4 = v4; prev_init = true; }
                                 if (v4 != prev_17e4 && v4 == 0x17 && watch_hits < 20) {
@@ -3953,19 +4232,35 @@ int verilate() {
 		}
 
 #ifndef DISABLE_AUDIO
-        if (!headless) {
+        if (!headless || audio.capture.active) {
             if (CLK_14M.IsRising())
             {
+                audio.Frame(video.count_frame);
                 audio.Clock(top->AUDIO_L, top->AUDIO_R);
             }
         }
 #endif
 
-		// Output pixels on rising edge of pixel clock
-        if (!headless) {
+		// Output pixels on rising edge of pixel clock (headless too, once the
+		// framebuffer exists, so count_frame advances for frame-based options)
+        if (!headless || output_ptr) {
             if (CLK_14M.IsRising() && top->CE_PIXEL) {
                 uint32_t colour = 0xFF000000 | top->VGA_B << 16 | top->VGA_G << 8 | top->VGA_R;
                 video.Clock(top->VGA_HB, top->VGA_VB, top->VGA_HS, top->VGA_VS, colour);
+                if (video.count_frame != vblank_frame) {
+                    vblank_frame = video.count_frame;
+                    calltrace.frame = video.count_frame;
+                    irqstats.frame = video.count_frame;
+                    if (busstats.active) busstats.Frame(video.count_frame);
+                    if (!ram_loads.empty()) ramLoadFrame();
+                    simlog.Frame(video.count_frame);
+                    if (hashlog.active) hashLogFrame();
+                    if (watchdog.Enabled()) {
+                        if (monitor_trap_fired) watchdog.Monitor();
+                        watchdog.Frame(video.count_frame, output_ptr, (size_t)output_width * output_height);
+                    }
+                    if (triggers.Active()) triggerFrame();
+                }
             }
         }
 
@@ -4007,6 +4302,7 @@ last_cpu_addr=VERTOPINTERN->emu__DOT__iigs__DOT__addr_bus;
 
 void RunBatch(int steps)
 {
+	auto t0 = std::chrono::steady_clock::now();
 	for (int step = 0; step < steps; step++) {
 		verilate();
 		if (break_pending) {
@@ -4015,6 +4311,7 @@ void RunBatch(int steps)
 			break;
 		}
 	}
+	if (perf.active) perf_run_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
 }
 
 unsigned char mouse_clock = 0;
@@ -4057,6 +4354,8 @@ bool reset_at_frame_cold = false;  // true = cold reset, false = warm reset
 // -------------------------
 std::vector<int> memory_dump_frames;
 bool memory_dump_mode = false;
+std::vector<int> text_dump_frames;
+bool text_dump_mode = false;
 
 // SmartPort Block I/O Handler
 // ---------------------------
@@ -4066,11 +4365,15 @@ std::string disk_image = "";   // HDD unit 0 (--disk)
 std::string disk_image2 = "";  // HDD unit 1 (--disk2)
 std::string woz_image = "";  // WOZ disk image (flux-based)
 int woz_mount_index = -1;     // Auto-detected: 4=5.25", 5=3.5"
+FloppySource woz_source;      // original image behind a converted --woz (write-back)
 
 // Convert a non-WOZ floppy image (.po/.dsk/.do/.nib/.2mg) to a temporary WOZ
 // using the shared codec (iigs_fmt), so --woz accepts any floppy format. If the
 // file is already a WOZ (or can't be converted), the original path is returned.
-static std::string prepareFloppyImage(const std::string& path) {
+// When src is given it describes where the sectors live in the original, so
+// the block device can write dirty tracks back to it (NIB sources are not).
+static std::string prepareFloppyImage(const std::string& path, FloppySource* src = nullptr) {
+    if (src) *src = FloppySource();
     FILE* f = fopen(path.c_str(), "rb");
     if (!f) return path;
     fseek(f, 0, SEEK_END);
@@ -4095,10 +4398,11 @@ static std::string prepareFloppyImage(const std::string& path) {
         size_t plen = raw.size();
         TwoMG m; DC42 d;
         if (twomg_parse(raw.data(), raw.size(), &m)) { pay = raw.data() + m.data_offset; plen = m.data_len; }
-        else if (dc42_parse(raw.data(), raw.size(), &d)) { pay = raw.data() + 84; plen = d.data_size; }
+        else if (dc42_parse(raw.data(), raw.size(), &d)) { pay = raw.data() + 84; plen = d.data_size; if (src) src->dc42 = true; }
         if (plen != A2_35_IMAGE_SIZE) return path;
         woz.resize(2 * 1024 * 1024);
         wn = a2_po_to_woz35(woz.data(), woz.size(), pay);
+        if (src) { src->offset = pay - raw.data(); src->length = plen; }
     } else if (cls == DC_FLOPPY_525) {
         const uint8_t* pay = raw.data();
         size_t plen = raw.size();
@@ -4114,6 +4418,7 @@ static std::string prepareFloppyImage(const std::string& path) {
             if (plen != A2_525_IMAGE_SIZE) return path;
             if (order_prodos) a2_prodos_to_dos(dsk.data(), pay);
             else              memcpy(dsk.data(), pay, A2_525_IMAGE_SIZE);
+            if (src) { src->offset = pay - raw.data(); src->length = plen; src->prodos_order = order_prodos; }
         }
         woz.resize(512 * 1024);
         wn = a2_dsk_to_woz525(woz.data(), woz.size(), dsk.data());
@@ -4129,10 +4434,27 @@ static std::string prepareFloppyImage(const std::string& path) {
     close(fd);
     if (wrote != (ssize_t)wn) return path;
     printf("Converted floppy %s -> %s (%zu-byte WOZ)\n", path.c_str(), tmpl, wn);
+    if (src && src->length) src->path = path;
     fflush(stdout);
     return std::string(tmpl);
 }
 
+// Copy a ROM image straight into the unified fastram dpram at base (the same
+// place the ioctl download puts it: boot.rom at FC0000, boot1.rom at F80000).
+// Must run before the first eval; returns bytes loaded, 0 if the file is missing.
+static long fastLoadRom(const char* file, uint32_t base, uint32_t max_len) {
+    FILE* f = fopen(file, "rb");
+    if (!f) {
+        fprintf(stderr, "FASTROM: cannot open %s\n", file);
+        return 0;
+    }
+    uint8_t* fastram = fastRam();
+    long n = (long)fread(fastram + base, 1, max_len, f);
+    fclose(f);
+    fprintf(stderr, "FASTROM: %s -> %06X (%ld bytes)\n", file, base, n);
+    return n;
+}
+
 // Returns 4 for 5.25", 5 for 3.5", -1 on error
 static int detectWozType(const char* filepath) {
     FILE *f = fopen(filepath, "rb");
@@ -4573,13 +4895,57 @@ void show_help() {
 	printf("  -screenshot <frames>          Legacy form of --screenshot (deprecated)\n");
 	printf("  --memory-dump <frames>        Dump memory at specified frame numbers\n");
 	printf("                                (comma-separated list, e.g., 100,200,300)\n");
+	printf("  --dump-text <frames>          Write the decoded text screen (UTF-8) to\n");
+	printf("                                text_frame_NNNN.txt at the given frames; rows that\n");
+	printf("                                graphics, MIXED or SHR cover come out blank\n");
 	printf("  --stop-at-frame <frame>       Exit simulation after specified frame\n");
 	printf("  --reset-at-frame <frame>      Trigger warm reset at specified frame\n");
 	printf("  --cold-reset-at-frame <frame> Trigger cold reset at specified frame\n");
 	printf("  --rom <1|3|rom1|rom3>         Select ROM version (default: rom3)\n");
+	printf("  --fast-rom-load               Preload boot.rom/boot1.rom into fastram (skip ioctl download)\n");
+	printf("  --audio-rate <44100|48000>    Audio output sample rate (default: 48000)\n");
+	printf("  --audio-out <file.wav>        Capture audio to a 16-bit stereo WAV (works headless)\n");
+	printf("  --audio-fingerprint <file>    Write per-frame audio energy/spectrum fingerprint\n");
+	printf("                                (compare with tools/audiofp)\n");
+	printf("  --audio-frames <A..B>         Limit capture/fingerprint to frames A..B (A.. = to end)\n");
+	printf("  --log <cat>=<level>[,...]     Log levels (off/error/warn/info/debug/trace) per category:\n");
+	printf("                                sim cpu disk floppy video irq sound scc adb rtl, or all.\n");
+	printf("                                RTL $display lines are sorted by their PREFIX_ word\n");
+	printf("  --log-file <file>             Write log lines (harness and RTL) to a file, not stdout\n");
+	printf("  --log-rate <n>                At most n info/debug lines per category per frame\n");
+	printf("  --eval-time                   Time top->eval() alone and add eval=<s> to SIMSTATS\n");
+	printf("  --hash-log <file>             Write per-frame hashes of video, CPU, soft switches and\n");
+	printf("                                written RAM pages (compare with tools/hashcmp)\n");
+	printf("  --profile <file>              Charge every CPU cycle (fast/slow/sync) to its PBR:PC and\n");
+	printf("                                call path; write a sorted report at exit\n");
+	printf("  --profile-folded <file>       Collapsed call stacks (14M ticks) for flamegraph.pl\n");
+	printf("  --calltrace <file>            Count and time Toolbox (JSL E1/0000), GS/OS (E1/00A8) and\n");
+	printf("                                ProDOS 8 MLI (JSR BF00) calls; report at exit\n");
+	printf("  --irq-stats <file>            Interrupt latency histograms per source (VBL, QSEC,\n");
+	printf("                                scanline, 1 s, sound, SCC, ADB) and handler time\n");
+	printf("  --irq-log <file.csv>          One CSV line per interrupt as it is handled\n");
+	printf("  --bus-stats <file>            Classify every CPU cycle (fast, refresh, slow, I/O /\n");
+	printf("                                shadow / E0-E1 sync) per run and per PBR; report at exit\n");
+	printf("  --bus-log <file.csv>          Per-frame cycle class counts\n");
+	printf("  --load <frame>:<file>@<BB:AAAA>\n");
+	printf("                                Copy a file into RAM at that frame's vblank (E0/E1 go to\n");
+	printf("                                slowram). Repeatable; a warm reset via SOFTEV runs it\n");
+	printf("  --detect <crash,hang,static|all>\n");
+	printf("                                Stop early when the guest enters the monitor (CRASH),\n");
+	printf("                                spins in a tiny loop with no I/O (HANG) or the screen\n");
+	printf("                                stops changing with no disk activity (STATIC)\n");
+	printf("  --hang-frames <n>             Frames in a tight loop before HANG (default 300)\n");
+	printf("  --static-frames <n>           Unchanged frames before STATIC (default 600)\n");
+	printf("  --result <file>               Write the run status (OK/CRASH/HANG/STATIC) as JSON\n");
+	printf("  --trigger '<cond> -> <actions>'\n");
+	printf("                                Run screenshot/dump/text/stop when a condition holds at vblank:\n");
+	printf("                                text~\"System OK\", pc==FF:6D00, mem[E1:0400]==C1,\n");
+	printf("                                disk-idle>=60, frame>=500; join with &&. Repeatable.\n");
+	printf("                                With a stop trigger, --stop-at-frame is a timeout (exit 3)\n");
+	printf("                                pc== is the CPU's PBR:PC, before LC/aux/shadow mapping\n");
 	printf("  --selftest                    Enable self-test mode\n");
 	printf("  --no-cpu-log                  Disable CPU log storage in memory (saves memory)\n");
-	printf("  --quiet                       Suppress CPU instruction trace to stdout (faster)\n");
+	printf("  --quiet                       CPU trace and info/debug log lines off (--log overrides)\n");
 	printf("  --disk <filename>             Use specified HDD image (slot 7 unit 0, no disk mounted by default)\n");
 	printf("  --disk2 <filename>            Use specified HDD image for slot 7 unit 1\n");
 	printf("  --woz <filename>              Floppy image: .woz, or .po/.dsk/.do/.nib/.2mg (auto-converted to WOZ)\n");
@@ -4686,7 +5052,7 @@ void save_memory_dump(int frame_number) {
 	snprintf(filename, sizeof(filename), "memdump_frame_%04d_fastram.bin", frame_number);
 	FILE* f = fopen(filename, "wb");
 	if (f) {
-		fwrite(&VERTOPINTERN->emu__DOT__fastram__DOT__ram, 1, 8388608, f);
+		fwrite(fastRam(), 1, 8388608, f);
 		fclose(f);
 		printf("Fast RAM dump saved: %s (8MB)\n", filename);
 	} else {
@@ -4724,7 +5090,7 @@ void save_memory_dump(int frame_number) {
 		}
 		
 		fprintf(f, "\nBank 00 $0600-$06FF (main text screen):\n");
-		uint8_t* fastram = (uint8_t*)&VERTOPINTERN->emu__DOT__fastram__DOT__ram;
+		uint8_t* fastram = fastRam();
 		for (int i = 0; i < 256; i += 16) {
 			fprintf(f, "00:%04X: ", 0x0600 + i);
 			for (int j = 0; j < 16 && (i + j) < 256; j++) {
@@ -4734,6 +5100,14 @@ void save_memory_dump(int frame_number) {
 			fprintf(f, "\n");
 		}
 		
+		SimTextMode mode = textMode();
+		std::vector<std::string> rows;
+		textScreen(rows);
+		fprintf(f, "\nText screen (%d col, page %d%s%s):\n", mode.col80 ? 80 : 40, mode.page2 ? 2 : 1,
+		        mode.altchar ? ", MouseText" : "",
+		        mode.first_row >= 24 ? ", not displayed" : mode.first_row ? ", mixed: rows 20-23" : "");
+		SimTextWrite(f, rows);
+
 		fclose(f);
 		printf("Memory summary saved: %s\n", filename);
 	} else {
@@ -4741,7 +5115,300 @@ void save_memory_dump(int frame_number) {
 	}
 }
 
+// --dump-text: decoded text page as UTF-8, one screen row per line
+void save_text_dump(int frame_number) {
+	char filename[256];
+	snprintf(filename, sizeof(filename), "text_frame_%04d.txt", frame_number);
+	FILE* f = fopen(filename, "w");
+	if (!f) {
+		printf("Error: Could not save text dump %s\n", filename);
+		return;
+	}
+	std::vector<std::string> rows;
+	textScreen(rows);
+	SimTextWrite(f, rows);
+	fclose(f);
+	printf("Text screen saved: %s\n", filename);
+}
+
+// Throughput over time from SimPerf samples, a frame-time histogram and CSV export
+static void drawPerfWindow(int x, int y, int width) {
+	ImGui::Begin(windowTitle_Perf);
+	ImGui::SetWindowPos(windowTitle_Perf, ImVec2(x, y), ImGuiCond_Once);
+	ImGui::SetWindowSize(windowTitle_Perf, ImVec2(width, 880), ImGuiCond_Once);
+
+	static SimPerf::View view;
+	perf.Snapshot(view);
+	int n = (int)view.samples.size(), off = 0;
+	const SimPerf::Sample* d = view.samples.data();
+	const int stride = sizeof(SimPerf::Sample);
+	if (n) {
+		const SimPerf::Sample& s = view.samples.back();
+		ImGui::Text("%.2f M ticks/s  guest %.3f MHz  %.1f ms/frame  harness %.0f%%  batch %d",
+			s.mcycles, s.guest_mhz, s.ms_per_frame, s.harness, batchSize);
+	} else {
+		ImGui::Text("Start running to collect samples");
+	}
+	ImGui::PushItemWidth(200);
+	ImGui::InputText("##perfcsv", perf_csv_path, sizeof(perf_csv_path));
+	ImGui::PopItemWidth();
+	ImGui::SameLine();
+	if (ImGui::Button("Export CSV")) {
+		std::string path = perf_csv_path;
+		to_sim.Send([path] { perf.WriteCsv(path.c_str()); });
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Clear")) to_sim.Send([] { perf.Clear(); });
+
+	const ImPlotAxisFlags fit = ImPlotAxisFlags_AutoFit;
+	const ImPlotAxisFlags right = ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_Opposite;
+	ImVec2 size(-1, 150);
+	if (ImPlot::BeginPlot("Throughput", size)) {
+		ImPlot::SetupAxes("s", "M ticks/s", fit, fit);
+		ImPlot::SetupAxis(ImAxis_Y2, "guest MHz", right);
+		ImPlot::PlotLine("sim ticks/s", &d->t, &d->mcycles, n, off, stride);
+		ImPlot::SetAxes(ImAxis_X1, ImAxis_Y2);
+		ImPlot::PlotLine("guest MHz", &d->t, &d->guest_mhz, n, off, stride);
+		ImPlot::EndPlot();
+	}
+	if (ImPlot::BeginPlot("Frame cost", size)) {
+		ImPlot::SetupAxes("s", "ms/frame", fit, fit);
+		ImPlot::SetupAxis(ImAxis_Y2, "%", right);
+		ImPlot::PlotLine("eval ms/frame", &d->t, &d->ms_per_frame, n, off, stride);
+		ImPlot::SetAxes(ImAxis_X1, ImAxis_Y2);
+		ImPlot::PlotLine("harness %", &d->t, &d->harness, n, off, stride);
+		ImPlot::EndPlot();
+	}
+	if (ImPlot::BeginPlot("Cycle mix", size)) {
+		ImPlot::SetupAxes("s", "% of CPU cycles", fit, 0);
+		ImPlot::SetupAxisLimits(ImAxis_Y1, 0, 100, ImPlotCond_Once);
+		ImPlot::PlotLine("fast", &d->t, &d->mix[SimPerf::FAST], n, off, stride);
+		ImPlot::PlotLine("slow", &d->t, &d->mix[SimPerf::SLOW], n, off, stride);
+		ImPlot::PlotLine("sync", &d->t, &d->mix[SimPerf::SYNC], n, off, stride);
+		ImPlot::EndPlot();
+	}
+	if (ImPlot::BeginPlot("I/O", size)) {
+		ImPlot::SetupAxes("s", "disk KB/s", fit, fit);
+		ImPlot::SetupAxis(ImAxis_Y2, "audio ms", right);
+		ImPlot::PlotLine("disk KB/s", &d->t, &d->disk_kbs, n, off, stride);
+		ImPlot::SetAxes(ImAxis_X1, ImAxis_Y2);
+		ImPlot::PlotLine("audio buffered", &d->t, &d->audio_ms, n, off, stride);
+		ImPlot::EndPlot();
+	}
+	if (ImPlot::BeginPlot("Frame time histogram", size)) {
+		ImPlot::SetupAxes("ms/frame", "frames", fit, fit);
+		if (!view.frame_ms.empty()) ImPlot::PlotHistogram("frames", view.frame_ms.data(), (int)view.frame_ms.size(), 40);
+		ImPlot::EndPlot();
+	}
+	ImGui::End();
+}
+
+// GUI mode, sim thread: the per-frame work the headless loop does inline --
+// input injections, screenshots and dumps, --reset-at-frame and the stop
+// conditions. Returns the exit code once the run should end, otherwise -1.
+static int guiFrameTasks()
+{
+	SIMLOG(LOG_SIM, LOG_INFO, "Frame: %d\n", video.count_frame);
+	// Handle key injections in GUI mode too
+	if (!key_injections.empty()) {
+		process_key_injections(video.count_frame);
+	}
+	// Handle mouse injections in GUI mode too
+	if (!mouse_injections.empty() || mouse_injection_active) {
+		process_mouse_injections(video.count_frame);
+	}
+	// Handle joystick injections in GUI mode too
+	if (!joystick_injections.empty() || joystick_injection_active) {
+		process_joystick_injections(video.count_frame);
+	}
+
+	// Check if this frame should be screenshotted
+	bool took_screenshot_this_frame = false;
+	if (screenshot_mode) {
+		auto it = std::find(screenshot_frames.begin(), screenshot_frames.end(), video.count_frame);
+		if (it != screenshot_frames.end()) {
+			save_screenshot(video.count_frame);
+			screenshot_frames.erase(it);  // Remove frame from list after capturing
+			took_screenshot_this_frame = true;
+		}
+	}
+	if (trigger_actions & SimTriggers::SCREENSHOT) {
+		save_screenshot(video.count_frame);
+		took_screenshot_this_frame = true;
+	}
+	if (trigger_actions & SimTriggers::DUMP) save_memory_dump(video.count_frame);
+	if (trigger_actions & SimTriggers::TEXT_DUMP) save_text_dump(video.count_frame);
+	trigger_actions = 0;
+
+	// Check if this frame should have memory dumped
+	if (memory_dump_mode) {
+		auto it = std::find(memory_dump_frames.begin(), memory_dump_frames.end(), video.count_frame);
+		if (it != memory_dump_frames.end()) {
+			save_memory_dump(video.count_frame);
+			memory_dump_frames.erase(it);  // Remove frame from list after dumping
+		}
+	}
+	if (text_dump_mode) {
+		auto it = std::find(text_dump_frames.begin(), text_dump_frames.end(), video.count_frame);
+		if (it != text_dump_frames.end()) {
+			save_text_dump(video.count_frame);
+			text_dump_frames.erase(it);
+		}
+	}
+
+	// Check if we should trigger reset at this frame
+	if (reset_at_frame_enabled && video.count_frame == reset_at_frame) {
+		fprintf(stderr, "GUI: Triggering %s reset at frame %d\n",
+				reset_at_frame_cold ? "COLD" : "WARM", reset_at_frame);
+		reset_pending = 1;
+		reset_pending_cold = reset_at_frame_cold ? 1 : 0;
+		reset_at_frame_enabled = false;  // Only trigger once
+	}
+
+	// Check if we should stop at this frame
+	if (watchdog.Tripped() || triggers.Stopped()) {
+		if (triggers.Stopped()) {
+			printf("Stop trigger fired at frame %d, exiting...\n", video.count_frame);
+		} else {
+			printf("Stopping at frame %d (%s), exiting...\n", video.count_frame, SimWatchdog::Name(watchdog.status));
+			if (screenshot_mode && !screenshot_frames.empty()) save_screenshot(video.count_frame);
+		}
+#ifndef DISABLE_AUDIO
+		audio.capture.Close();
+#endif
+		hashlog.Close();
+		writeRunResult();
+		writeExitReports();
+		return 0;
+	}
+	if (stop_at_frame_enabled && video.count_frame == stop_at_frame) {
+		if (took_screenshot_this_frame) {
+			printf("Reached stop frame %d after taking screenshot, exiting...\n", stop_at_frame);
+		} else {
+			printf("Reached stop frame %d, exiting...\n", stop_at_frame);
+		}
+#ifndef DISABLE_AUDIO
+		audio.capture.Close();
+#endif
+		hashlog.Close();
+		writeRunResult();
+		writeExitReports();
+		if (triggers.HasStop()) {
+			printf("TRIGGER: no stop trigger fired before frame %d\n", stop_at_frame);
+			return 3;
+		}
+		return 0;
+	}
+	return -1;
+}
+
+// GUI mode, sim thread: one GUI frame of host input -- joystick bits from the
+// key mapping and mouse deltas -- unless --inject-* input overrides it
+static void setHostInput(int joy, bool menu, int mx, int my, int mb)
+{
+	top->menu = menu;
+	top->joystick_0 = joy;
+	top->joystick_1 = top->joystick_0;
+
+	// Apply joystick/paddle values via analog inputs
+	if (joystick_injection_active) {
+		top->joystick_l_analog_0 = pack_analog(injected_paddle0, injected_paddle1);
+		top->joystick_l_analog_1 = pack_analog(injected_paddle2, injected_paddle3);
+		// Override button bits for injected buttons
+		if (injected_joy_buttons & 1) top->joystick_0 |= (1 << 4);  // Button 0
+		if (injected_joy_buttons & 2) top->joystick_0 |= (1 << 5);  // Button 1
+	} else {
+		// Default centered position (128 = signed 0)
+		top->joystick_l_analog_0 = pack_analog(128, 128);
+		top->joystick_l_analog_1 = pack_analog(128, 128);
+	}
+
+	// Mouse input: injected values win over the captured mouse / arrow keys
+	if (mouse_injection_active) {
+		// Negate Y: user's positive dy = move down, but internal convention is negative Y = down
+		mx = injected_mouse_x;
+		my = -injected_mouse_y;
+		mb = injected_mouse_buttons;
+	}
+
+	// Build PS/2 mouse packet (matching MiSTer hps_io format):
+	// Byte 0 [7:0]: YOvfl[7], XOvfl[6], Ysign[5], Xsign[4], 1[3], Mbtn[2], Rbtn[1], Lbtn[0]
+	// Byte 1 [15:8]: X delta (signed 8-bit)
+	// Byte 2 [23:16]: Y delta (signed 8-bit, already negated by MiSTer)
+	// Bit 24: Toggle bit for event detection
+	unsigned char status_byte = (mb & 0x07) | 0x08;  // Bit 3 always 1 per PS/2 spec
+	if (mx < 0) status_byte |= 0x10;  // X sign bit
+	if (my < 0) status_byte |= 0x20;  // Y sign bit
+
+	unsigned long mouse_temp = status_byte;
+	mouse_temp |= ((unsigned char)mx << 8);
+	mouse_temp |= ((unsigned char)my << 16);
+
+	// Toggle clock when there's mouse movement OR button state changed
+	// Critical: must detect button releases (when mouse_buttons becomes 0)
+	if (mx != 0 || my != 0 || mb != prev_mouse_buttons) {
+		mouse_clock = !mouse_clock;
+	}
+	prev_mouse_buttons = mb;
+	if (mouse_clock) { mouse_temp |= (1UL << 24); }
+
+	top->ps2_mouse = mouse_temp;
+	top->ps2_mouse_ext = mx + (mb << 8);
+}
+
+// GUI mode: mount/eject on the sim thread, then hand the drive's name back
+static void guiDiskCommand(int index, std::function<void()> fn)
+{
+	to_sim.Send([index, fn] {
+		fn();
+		std::string name = blockdevice.IsMounted(index) ? blockdevice.disk_name[index] : "";
+		to_gui.Send([index, name] { gui_disk_name[index] = name; });
+	});
+}
+
+// GUI mode: the model runs here at headless speed. The GUI thread draws the
+// newest frame SimVideo published and never touches the model directly; its
+// commands are run between batches, so batchSize bounds their latency.
+static void simThread()
+{
+	int last_frame = -1;
+	while (!sim_quit) {
+		to_sim.Run();
+		to_gui.Retry();
+		switch (run_state) {
+		case RunState::StepIn:
+		case RunState::NextIRQ:
+		case RunState::Running: RunBatch(batchSize); break;
+		case RunState::SingleClock: verilate(); run_state = RunState::Stopped; break;
+		case RunState::MultiClock: RunBatch(multi_step_amount); run_state = RunState::Stopped; break;
+		default: std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		float audio_ms = 0;
+#ifndef DISABLE_AUDIO
+		audio_ms = audio.buffered_ms;
+#endif
+		perf.Update(std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(),
+			perf_run_s, main_time, video.count_frame, blockdevice.bytes_moved, audio_ms);
+		if (video.count_frame != last_frame) {
+			last_frame = video.count_frame;
+			int rc = guiFrameTasks();
+			if (rc >= 0) {
+				sim_exit_code = rc;
+				sim_quit = true;
+			}
+		}
+	}
+}
+
+// Write floppies back while simlog still exists: this runs before the static
+// destructors of everything constructed ahead of main, ~SimBlockDevice's own
+// flush then finds nothing dirty
+static void flushDisksAtExit() {
+	blockdevice.FlushAll();
+}
+
 int main(int argc, char** argv, char** env) {
+    atexit(flushDisksAtExit);
     // Detect headless from env
     const char* env_headless = getenv("HEADLESS");
     if (env_headless && env_headless[0] && env_headless[0] != '0') headless = true;
@@ -4778,6 +5445,16 @@ int main(int argc, char** argv, char** env) {
 			}
 			printf("Memory dump mode enabled for frames: %s\n", frames_str.c_str());
 			i++; // Skip the next argument since it's the frame list
+		} else if (strcmp(argv[i], "--dump-text") == 0 && i + 1 < argc) {
+			text_dump_mode = true;
+			std::string frames_str = argv[i + 1];
+			std::stringstream ss(frames_str);
+			std::string frame_num;
+			while (std::getline(ss, frame_num, ',')) {
+				text_dump_frames.push_back(std::stoi(frame_num));
+			}
+			printf("Text dump mode enabled for frames: %s\n", frames_str.c_str());
+			i++;
 		} else if (strcmp(argv[i], "--stop-at-frame") == 0 && i + 1 < argc) {
 			stop_at_frame_enabled = true;
 			stop_at_frame = std::stoi(argv[i + 1]);
@@ -4830,6 +5507,85 @@ int main(int argc, char** argv, char** env) {
 				return 1;
 			}
 			i++;
+		} else if (strcmp(argv[i], "--fast-rom-load") == 0) {
+			fast_rom_load = true;
+		} else if (strcmp(argv[i], "--audio-rate") == 0 && i + 1 < argc) {
+			int rate = atoi(argv[i + 1]);
+			if (rate != 44100 && rate != 48000) {
+				fprintf(stderr, "Error: --audio-rate must be 44100 or 48000\n");
+				return 1;
+			}
+#ifndef DISABLE_AUDIO
+			audio.sample_rate = rate;
+#endif
+			i++;
+		} else if (strcmp(argv[i], "--audio-out") == 0 && i + 1 < argc) {
+			audio_out_path = argv[++i];
+		} else if (strcmp(argv[i], "--load") == 0 && i + 1 < argc) {
+			std::string arg = argv[++i];
+			size_t colon = arg.find(':'), at = arg.rfind('@');
+			if (colon == std::string::npos || at == std::string::npos || at < colon) {
+				fprintf(stderr, "Error: --load requires format <frame>:<file>@<BB:AAAA>\n");
+				return 1;
+			}
+			std::string hex = arg.substr(at + 1);
+			hex.erase(std::remove(hex.begin(), hex.end(), ':'), hex.end());
+			RamLoad l;
+			l.frame = std::stoi(arg.substr(0, colon));
+			l.path = arg.substr(colon + 1, at - colon - 1);
+			l.addr = (uint32_t)strtoul(hex.c_str(), nullptr, 16) & 0xFFFFFF;
+			ram_loads.push_back(l);
+		} else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+			if (!simlog.Configure(argv[++i])) return 1;
+		} else if (strcmp(argv[i], "--log-file") == 0 && i + 1 < argc) {
+			if (!simlog.Open(argv[++i])) return 1;
+		} else if (strcmp(argv[i], "--log-rate") == 0 && i + 1 < argc) {
+			simlog.SetRate((unsigned)std::stoi(argv[++i]));
+		} else if (strcmp(argv[i], "--eval-time") == 0) {
+			eval_timing = true;
+		} else if (strcmp(argv[i], "--hash-log") == 0 && i + 1 < argc) {
+			hash_log_path = argv[++i];
+		} else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+			profile_path = argv[++i];
+			profile.active = true;
+		} else if (strcmp(argv[i], "--profile-folded") == 0 && i + 1 < argc) {
+			profile_folded_path = argv[++i];
+			profile.active = true;
+		} else if (strcmp(argv[i], "--calltrace") == 0 && i + 1 < argc) {
+			calltrace_path = argv[++i];
+			calltrace.active = true;
+		} else if (strcmp(argv[i], "--irq-stats") == 0 && i + 1 < argc) {
+			irqstats_path = argv[++i];
+			irqstats.active = true;
+		} else if (strcmp(argv[i], "--irq-log") == 0 && i + 1 < argc) {
+			irqlog_path = argv[++i];
+		} else if (strcmp(argv[i], "--bus-stats") == 0 && i + 1 < argc) {
+			busstats_path = argv[++i];
+			busstats.active = true;
+		} else if (strcmp(argv[i], "--bus-log") == 0 && i + 1 < argc) {
+			if (!busstats.OpenLog(argv[++i])) return 1;
+		} else if (strcmp(argv[i], "--detect") == 0 && i + 1 < argc) {
+			if (!watchdog.Parse(argv[++i])) return 1;
+		} else if (strcmp(argv[i], "--hang-frames") == 0 && i + 1 < argc) {
+			watchdog.hang_frames = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--static-frames") == 0 && i + 1 < argc) {
+			watchdog.static_frames = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--result") == 0 && i + 1 < argc) {
+			result_path = argv[++i];
+		} else if (strcmp(argv[i], "--trigger") == 0 && i + 1 < argc) {
+			if (!triggers.Add(argv[++i])) return 1;
+		} else if (strcmp(argv[i], "--audio-fingerprint") == 0 && i + 1 < argc) {
+			audio_fp_path = argv[++i];
+		} else if (strcmp(argv[i], "--audio-frames") == 0 && i + 1 < argc) {
+			const char* range = argv[i + 1];
+			const char* dots = strstr(range, "..");
+			audio_first_frame = atoi(range);
+			audio_last_frame = dots ? (dots[2] ? atoi(dots + 2) : -1) : audio_first_frame;
+			if (audio_first_frame < 0 || (audio_last_frame >= 0 && audio_last_frame < audio_first_frame)) {
+				fprintf(stderr, "Error: --audio-frames expects A..B with A <= B (or A..)\n");
+				return 1;
+			}
+			i++;
 		} else if (strcmp(argv[i], "--selftest") == 0) {
 			selftest_mode = true;
 			printf("Self-test mode enabled - will simulate Command+Option+Control+Reset\n");
@@ -4838,7 +5594,7 @@ int main(int argc, char** argv, char** env) {
 			printf("CPU log memory storage disabled to save memory (stdout traces still enabled)\n");
 		} else if (strcmp(argv[i], "--quiet") == 0) {
 			quiet_mode = true;
-			printf("Quiet mode enabled - CPU instruction trace suppressed\n");
+			printf("Quiet mode enabled - CPU trace and info/debug log lines suppressed\n");
         } else if (strcmp(argv[i], "--headless") == 0) {
             headless = true;
         } else if (strcmp(argv[i], "--disk") == 0 && i + 1 < argc) {
@@ -4851,7 +5607,7 @@ int main(int argc, char** argv, char** env) {
             i++; // Skip the next argument since it's the filename
         } else if (strcmp(argv[i], "--woz") == 0 && i + 1 < argc) {
             // Accept any floppy format: convert .po/.dsk/.do/.nib/.2mg to WOZ.
-            woz_image = prepareFloppyImage(argv[i + 1]);
+            woz_image = prepareFloppyImage(argv[i + 1], &woz_source);
             i++;
             woz_mount_index = detectWozType(woz_image.c_str());
             if (woz_mount_index < 0) woz_mount_index = 5;  // Default to 3.5"
@@ -4997,6 +5753,10 @@ int main(int argc, char** argv, char** env) {
     }
 
 	// Create core and initialise
+#ifdef FASTRAM_HOST
+	if (!fastram_host.Allocate()) return 1;
+	printf("FASTRAM: 16MB host buffer (%s pages)\n", fastram_host.backing);
+#endif
 	top = new Vemu();
 	Verilated::commandArgs(argc, argv);
 
@@ -5041,8 +5801,15 @@ int main(int argc, char** argv, char** env) {
 	// Queue both ROMs at startup via ioctl (loaded into unified SDRAM)
 	// ROM3 (256KB) at FC0000: ioctl_index=0 (boot.rom on MiSTer)
 	// ROM1 (128KB) at F80000: ioctl_index=0x40 (boot1.rom on MiSTer, [15:6]=1)
-	bus.QueueDownload("boot.rom", 0, 1);
-	bus.QueueDownload("boot1.rom", 0x40, 1);
+	// With --fast-rom-load the images are poked into fastram up front, so no
+	// download holds reset and the core leaves reset after initialReset cycles.
+	if (fast_rom_load) {
+		fastLoadRom("boot.rom", 0xFC0000, 0x40000);
+		fastLoadRom("boot1.rom", 0xF80000, 0x20000);
+	} else {
+		bus.QueueDownload("boot.rom", 0, 1);
+		bus.QueueDownload("boot1.rom", 0x40, 1);
+	}
 
 	// Set initial ROM selection from command line (--rom option)
 	top->rom_select = initial_rom_select;
@@ -5078,7 +5845,24 @@ int main(int argc, char** argv, char** env) {
     if (!headless) {
 	    audio.Initialise();
     }
+    if (audio_out_path || audio_fp_path) {
+	    audio.capture.first_frame = audio_first_frame;
+	    audio.capture.last_frame = audio_last_frame;
+	    if (audio_out_path && !audio.capture.OpenWav(audio_out_path, audio.sample_rate)) return 1;
+	    if (audio_fp_path && !audio.capture.OpenFingerprint(audio_fp_path, audio.sample_rate)) return 1;
+    }
 #endif
+    if (quiet_mode) simlog.Quiet();
+    if (hash_log_path && !hashlog.Open(hash_log_path)) return 1;
+    if (irqlog_path && !irqstats.OpenLog(irqlog_path)) return 1;
+    calltrace.read = [](uint32_t a) -> uint8_t {
+        uint32_t bank = (a >> 16) & 0xFF;
+        // ALTZP moves bank 00 zero page and stack to bank 01
+        if (bank == 0x00 && (a & 0xFFFF) < 0x0200 && VERTOPINTERN->emu__DOT__iigs__DOT__ALTZP) bank = 0x01;
+        if (bank == 0xE0 || bank == 0xE1)
+            return ((const uint8_t*)&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram)[(bank & 1) << 16 | (a & 0xFFFF)];
+        return fastRam()[bank << 16 | (a & 0xFFFF)];
+    };
 
     // Set up input module (skip in headless)
     if (!headless) {
@@ -5117,6 +5901,8 @@ int main(int argc, char** argv, char** env) {
     // Setup video output (in headless, SimVideo will be initialized lazily)
     if (!headless) {
         if (video.Initialise(windowTitle) == 1) { return 1; }
+        ImPlot::CreateContext();
+        perf.active = true;
     }
 
     // Mount HDD images into slot 7 backend (only if specified via --disk/--disk2)
@@ -5131,6 +5917,7 @@ int main(int argc, char** argv, char** env) {
     if (!woz_image.empty() && woz_mount_index >= 0) {
         printf("Mounting WOZ image: %s to index %d\n", woz_image.c_str(), woz_mount_index);
         blockdevice.MountDisk(woz_image.c_str(), woz_mount_index);
+        blockdevice.SetFloppySource(woz_mount_index, woz_source);
     }
 
     if (disk_image.empty() && disk_image2.empty() && woz_image.empty()) {
@@ -5154,10 +5941,12 @@ int main(int argc, char** argv, char** env) {
        }
        run_state = RunState::Running;
        int last_logged_frame = -1;
+       auto headless_t0 = std::chrono::steady_clock::now();
+       vluint64_t headless_cycles0 = main_time;
        while (1) {
            RunBatch(4096);
            if (video.count_frame != last_logged_frame) {
-               printf("Frame: %d\n", video.count_frame);
+               SIMLOG(LOG_SIM, LOG_INFO, "Frame: %d\n", video.count_frame);
                last_logged_frame = video.count_frame;
                // Handle key injections
                if (!key_injections.empty()) {
@@ -5221,6 +6010,11 @@ int main(int argc, char** argv, char** env) {
                        screenshot_frames.erase(it);
                    }
                }
+               // Trigger actions latched at vblank
+               if (trigger_actions & SimTriggers::SCREENSHOT) save_screenshot(video.count_frame);
+               if (trigger_actions & SimTriggers::DUMP) save_memory_dump(video.count_frame);
+               if (trigger_actions & SimTriggers::TEXT_DUMP) save_text_dump(video.count_frame);
+               trigger_actions = 0;
                // Handle memory dumps
                if (memory_dump_mode) {
                    auto it2 = std::find(memory_dump_frames.begin(), memory_dump_frames.end(), video.count_frame);
@@ -5229,6 +6023,13 @@ int main(int argc, char** argv, char** env) {
                        memory_dump_frames.erase(it2);
                    }
                }
+               if (text_dump_mode) {
+                   auto it3 = std::find(text_dump_frames.begin(), text_dump_frames.end(), video.count_frame);
+                   if (it3 != text_dump_frames.end()) {
+                       save_text_dump(video.count_frame);
+                       text_dump_frames.erase(it3);
+                   }
+               }
                // Trigger reset at frame (for testing reset functionality)
                if (reset_at_frame_enabled && video.count_frame == reset_at_frame) {
                    fprintf(stderr, "Triggering %s reset at frame %d\n",
@@ -5237,11 +6038,40 @@ int main(int argc, char** argv, char** env) {
                    reset_pending_cold = reset_at_frame_cold ? 1 : 0;
                    reset_at_frame_enabled = false;  // Only trigger once
                }
-               // Stop at frame
-               if (stop_at_frame_enabled && video.count_frame >= stop_at_frame) {
-                   printf("Reached stop frame %d, exiting...\n", stop_at_frame);
+               // Stop at frame, or early when a --detect detector tripped
+               if ((stop_at_frame_enabled && video.count_frame >= stop_at_frame) || watchdog.Tripped() || triggers.Stopped()) {
+                   int rc = 0;
+                   if (triggers.Stopped()) {
+                       printf("Stop trigger fired at frame %d, exiting...\n", video.count_frame);
+                   } else if (watchdog.Tripped()) {
+                       printf("Stopping at frame %d (%s), exiting...\n", video.count_frame, SimWatchdog::Name(watchdog.status));
+                       // the requested screenshot frame will never come; take it now
+                       if (screenshot_mode && !screenshot_frames.empty()) save_screenshot(video.count_frame);
+                   } else {
+                       printf("Reached stop frame %d, exiting...\n", stop_at_frame);
+                       if (triggers.HasStop()) {
+                           printf("TRIGGER: no stop trigger fired before frame %d\n", stop_at_frame);
+                           rc = 3;
+                       }
+                   }
+                   // Machine-readable run cost (stub_bench.sh, CI timing)
+                   double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - headless_t0).count();
+                   vluint64_t cycles = main_time - headless_cycles0;
+                   printf("SIMSTATS: frames=%d cycles=%llu wall=%.3f ns_per_cycle=%.1f ms_per_frame=%.2f",
+                          video.count_frame, (unsigned long long)cycles, wall,
+                          cycles ? wall * 1e9 / cycles : 0.0,
+                          video.count_frame ? wall * 1e3 / video.count_frame : 0.0);
+                   if (eval_timing) printf(" eval=%.3f", eval_s);
+                   printf("\n");
                    if (g_beam_csv) { fflush(g_beam_csv); fclose(g_beam_csv); g_beam_csv = nullptr; }
-                   return 0;
+                   blockdevice.FlushAll();
+#ifndef DISABLE_AUDIO
+                   audio.capture.Close();
+#endif
+                   hashlog.Close();
+                   writeRunResult();
+                   writeExitReports();
+                   return rc;
                }
            }
        }
@@ -5250,10 +6080,17 @@ int main(int argc, char** argv, char** env) {
        // iwm_init();
        // iwm_reset();
 
+	// Hand the model to the sim thread; from here on the GUI only reads it
+	for (int i = 0; i < kVDNUM; i++)
+		if (blockdevice.IsMounted(i)) gui_disk_name[i] = blockdevice.disk_name[i];
+	mem_edit.WriteFn = [](ImU8* data, size_t off, ImU8 d) { to_sim.Send([=] { data[off] = d; }); };
+	std::thread sim_thread(simThread);
+	auto next_gui_frame = std::chrono::steady_clock::now();
+
 #ifdef WIN32
 	MSG msg;
 	ZeroMemory(&msg, sizeof(msg));
-	while (msg.message != WM_QUIT)
+	while (msg.message != WM_QUIT && !sim_quit)
 	{
 		if (PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE))
 		{
@@ -5263,12 +6100,15 @@ int main(int argc, char** argv, char** env) {
 		}
 #else
 	bool done = false;
-	while (!done)
+	while (!done && !sim_quit)
 	{
 		SDL_Event event;
-		// Reset mouse deltas each frame before accumulating events
-		mouse_x = 0;
-		mouse_y = 0;
+		// Reset mouse deltas once they have been handed to the sim
+		if (host_input_sent) {
+			mouse_x = 0;
+			mouse_y = 0;
+			host_input_sent = false;
+		}
 		while (SDL_PollEvent(&event))
 		{
 			ImGui_ImplSDL2_ProcessEvent(&event);
@@ -5319,7 +6159,17 @@ int main(int argc, char** argv, char** env) {
 #endif
 		video.StartFrame();
 
+		to_gui.Run();
+		to_sim.Retry();
 		input.Read();
+		// Keys reach the core through the sim thread's copy of the queue. A key
+		// stays in hostEvents until the ring takes it: a lost key-up would
+		// leave the key held down in the guest.
+		while (!input.hostEvents.empty()) {
+			SimInput_PS2KeyEvent evt = input.hostEvents.front();
+			if (!to_sim.Push([evt] { input.keyEvents.push(evt); })) break;
+			input.hostEvents.pop();
+		}
 
 
 		// Draw GUI
@@ -5330,26 +6180,27 @@ int main(int argc, char** argv, char** env) {
 		ImGui::Begin(windowTitle_Control);
 		ImGui::SetWindowPos(windowTitle_Control, ImVec2(0, 0), ImGuiCond_Once);
 		ImGui::SetWindowSize(windowTitle_Control, ImVec2(500, 150), ImGuiCond_Once);
-		if (ImGui::Button("Reset simulation")) { resetSim(); } ImGui::SameLine();
+		if (ImGui::Button("Reset simulation")) { to_sim.Send(resetSim); } ImGui::SameLine();
 		ImGui::Checkbox("STOPONDIFF", &stop_on_log_mismatch);
-		if (ImGui::Button("Start running")) { run_state = RunState::Running; } ImGui::SameLine();
-		if (ImGui::Button("Stop running")) { run_state = RunState::Stopped; } ImGui::SameLine();
+		if (ImGui::Button("Start running")) { to_sim.Send([] { run_state = RunState::Running; }); } ImGui::SameLine();
+		if (ImGui::Button("Stop running")) { to_sim.Send([] { run_state = RunState::Stopped; }); } ImGui::SameLine();
 		ImGui::PushItemWidth(100);
-		ImGui::InputInt("Run batch size", &batchSize, 1000, 10000);
+		int batch = batchSize;
+		if (ImGui::InputInt("Run batch size", &batch, 1000, 10000)) { to_sim.Send([batch] { batchSize = batch; }); }
 		ImGui::PopItemWidth();
-		if (run_state == RunState::SingleClock || run_state == RunState::MultiClock) { run_state = RunState::Stopped;}
 		ImGui::Text("Clock step:"); ImGui::SameLine();
-		if (ImGui::Button("Single")) { run_state = RunState::SingleClock; }
+		if (ImGui::Button("Single")) { to_sim.Send([] { run_state = RunState::SingleClock; }); }
 		ImGui::SameLine();
-		if (ImGui::Button("Multi")) { run_state = RunState::MultiClock; }
+		if (ImGui::Button("Multi")) { to_sim.Send([] { run_state = RunState::MultiClock; }); }
 		ImGui::SameLine();
 		ImGui::PushItemWidth(100);
-		ImGui::InputInt("Multi clock amount", &multi_step_amount, 1, 10);
+		int multi = multi_step_amount;
+		if (ImGui::InputInt("Multi clock amount", &multi, 1, 10)) { to_sim.Send([multi] { multi_step_amount = multi; }); }
 		ImGui::PopItemWidth();
 		ImGui::Text("CPU:"); ImGui::SameLine();
-		if (ImGui::Button("Step")) { run_state = RunState::StepIn; }
+		if (ImGui::Button("Step")) { to_sim.Send([] { run_state = RunState::StepIn; }); }
 		ImGui::SameLine();
-		if (ImGui::Button("Next IRQ")) { run_state = RunState::NextIRQ; }
+		if (ImGui::Button("Next IRQ")) { to_sim.Send([] { run_state = RunState::NextIRQ; }); }
 
 		//ImGui::SameLine();
 		//		if (ImGui::Button("Load ROM"))
@@ -5360,14 +6211,12 @@ int main(int argc, char** argv, char** env) {
 		ImGui::Text("System Reset:");
 		if (ImGui::Button("Warm Reset (Ctrl+F11)")) {
 			fprintf(stderr, "Warm Reset requested from ImGui menu\n");
-			reset_pending = 1;
-			reset_pending_cold = 0;
+			to_sim.Send([] { reset_pending = 1; reset_pending_cold = 0; });
 		}
 		ImGui::SameLine();
 		if (ImGui::Button("Cold Reset (Ctrl+OA+F11)")) {
 			fprintf(stderr, "Cold Reset requested from ImGui menu\n");
-			reset_pending = 1;
-			reset_pending_cold = 1;
+			to_sim.Send([] { reset_pending = 1; reset_pending_cold = 1; });
 		}
 		ImGui::SameLine();
 		ImGui::TextDisabled("(?)");
@@ -5383,9 +6232,9 @@ int main(int argc, char** argv, char** env) {
 		ImGui::Separator();
 		ImGui::Text("ROM Version:");
 		bool rom1_selected = top->rom_select != 0;
-		if (ImGui::RadioButton("ROM3", !rom1_selected)) { top->rom_select = 0; }
+		if (ImGui::RadioButton("ROM3", !rom1_selected)) { to_sim.Send([] { top->rom_select = 0; }); }
 		ImGui::SameLine();
-		if (ImGui::RadioButton("ROM1", rom1_selected)) { top->rom_select = 1; }
+		if (ImGui::RadioButton("ROM1", rom1_selected)) { to_sim.Send([] { top->rom_select = 1; }); }
 		ImGui::SameLine();
 		ImGui::TextDisabled("(?)");
 		if (ImGui::IsItemHovered()) {
@@ -5402,9 +6251,9 @@ int main(int argc, char** argv, char** env) {
 
 		// 3.5" WOZ drive (index 5)
 		ImGui::Text("3.5\":"); ImGui::SameLine();
-		if (blockdevice.IsMounted(5)) {
-			ImGui::Text("%s", blockdevice.disk_name[5].c_str()); ImGui::SameLine();
-			if (ImGui::Button("Eject 3.5\"")) blockdevice.EjectDisk(5);
+		if (!gui_disk_name[5].empty()) {
+			ImGui::Text("%s", gui_disk_name[5].c_str()); ImGui::SameLine();
+			if (ImGui::Button("Eject 3.5\"")) guiDiskCommand(5, [] { blockdevice.EjectDisk(5); });
 			ImGui::SameLine();
 			if (ImGui::Button("Swap 3.5\""))
 				ImGuiFileDialog::Instance()->OpenDialog("MountWOZ35", "Select WOZ Image", ".woz", ".");
@@ -5416,9 +6265,9 @@ int main(int argc, char** argv, char** env) {
 
 		// 5.25" WOZ drive (index 4)
 		ImGui::Text("5.25\":"); ImGui::SameLine();
-		if (blockdevice.IsMounted(4)) {
-			ImGui::Text("%s", blockdevice.disk_name[4].c_str()); ImGui::SameLine();
-			if (ImGui::Button("Eject 5.25\"")) blockdevice.EjectDisk(4);
+		if (!gui_disk_name[4].empty()) {
+			ImGui::Text("%s", gui_disk_name[4].c_str()); ImGui::SameLine();
+			if (ImGui::Button("Eject 5.25\"")) guiDiskCommand(4, [] { blockdevice.EjectDisk(4); });
 			ImGui::SameLine();
 			if (ImGui::Button("Swap 5.25\""))
 				ImGuiFileDialog::Instance()->OpenDialog("MountWOZ525", "Select WOZ Image", ".woz", ".");
@@ -5436,7 +6285,7 @@ int main(int argc, char** argv, char** env) {
 
 		// Memory debug
 		ImGui::Begin("Fast RAM Editor");
-		mem_edit.DrawContents(&VERTOPINTERN->emu__DOT__fastram__DOT__ram, 16777216, 0);
+		mem_edit.DrawContents(fastRam(), 16777216, 0);
 		ImGui::End();
 		ImGui::Begin("Slow RAM Editor");
 		mem_edit.DrawContents(&VERTOPINTERN->emu__DOT__iigs__DOT__slowram__DOT__ram, 131072, 0);
@@ -5444,7 +6293,7 @@ int main(int argc, char** argv, char** env) {
 
                 // ROM is in unified dpram: ROM3 at FC0000-FFFFFF, ROM1 at F80000-F9FFFF
                 // Show the active ROM based on rom_select
-                uint8_t *ramp = reinterpret_cast<uint8_t *>(&VERTOPINTERN->emu__DOT__fastram__DOT__ram);
+                uint8_t *ramp = fastRam();
 		uint8_t *rom_base = ramp + (top->rom_select ? 0xF80000 : 0xFC0000);
 		uint8_t *rom1p = rom_base + (top->rom_select ? 0x00000 : 0x20000);  // Bank FE (ROM3) or F80000 (ROM1)
 		uint8_t *rom2p = rom_base + (top->rom_select ? 0x10000 : 0x30000);  // Bank FF (ROM3) or F90000 (ROM1)
@@ -5456,8 +6305,12 @@ int main(int argc, char** argv, char** env) {
 		ImGui::End();
 
 		ImGui::Begin("CPU Registers");
-		ImGui::Checkbox("Break", &pc_break_enabled); ImGui::SameLine();
-		ImGui::InputTextWithHint("Address", "0000", pc_breakpoint, IM_ARRAYSIZE(pc_breakpoint), ImGuiInputTextFlags_CharsHexadecimal);
+		bool break_changed = ImGui::Checkbox("Break", &pc_break_enabled); ImGui::SameLine();
+		break_changed |= ImGui::InputTextWithHint("Address", "0000", pc_breakpoint, IM_ARRAYSIZE(pc_breakpoint), ImGuiInputTextFlags_CharsHexadecimal);
+		if (break_changed) {
+			long addr = pc_break_enabled ? strtol(pc_breakpoint, NULL, 16) : -1;
+			to_sim.Send([addr] { pc_breakpoint_addr = addr; });
+		}
 		ImGui::Spacing();
 		ImGui::Text("A       0x%04X", VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__A);
 		ImGui::Text("X       0x%04X", VERTOPINTERN->emu__DOT__iigs__DOT__cpu__DOT__X);
@@ -5527,29 +6380,13 @@ int main(int argc, char** argv, char** env) {
 		ImGui::SetWindowSize(windowTitle_Video, ImVec2(windowWidth, windowHeight), ImGuiCond_Once);
 
 		ImGui::SliderFloat("Zoom", &vga_scale, 1, 8); ImGui::SameLine();
-		ImGui::SliderInt("Rotate", &video.output_rotate, -1, 1); ImGui::SameLine();
-		ImGui::Checkbox("Flip V", &video.output_vflip);
+		int rotate = video.output_rotate;
+		bool vflip = video.output_vflip;
+		bool turned = ImGui::SliderInt("Rotate", &rotate, -1, 1); ImGui::SameLine();
+		turned |= ImGui::Checkbox("Flip V", &vflip);
+		if (turned) { to_sim.Send([rotate, vflip] { video.SetOrientation(rotate, vflip); }); }
 		ImGui::Text("main_time: %ld frame_count: %d sim FPS: %f", main_time, video.count_frame, video.stats_fps);
 		//ImGui::Text("pixel: %06d line: %03d", video.count_pixel, video.count_line);
-		
-		// Log frame number to stdout for user reference
-		static int last_logged_frame = -1;
-		if (video.count_frame != last_logged_frame) {
-			printf("Frame: %d\n", video.count_frame);
-			last_logged_frame = video.count_frame;
-			// Handle key injections in GUI mode too
-			if (!key_injections.empty()) {
-				process_key_injections(video.count_frame);
-			}
-			// Handle mouse injections in GUI mode too
-			if (!mouse_injections.empty() || mouse_injection_active) {
-				process_mouse_injections(video.count_frame);
-			}
-			// Handle joystick injections in GUI mode too
-			if (!joystick_injections.empty() || joystick_injection_active) {
-				process_joystick_injections(video.count_frame);
-			}
-		}
 
 		// Draw VGA output with invisible button overlay to capture clicks
 		ImVec2 vga_size(video.output_width * VGA_SCALE_X, video.output_height * VGA_SCALE_Y);
@@ -5575,45 +6412,6 @@ int main(int argc, char** argv, char** env) {
 			ImGui::Text("Click on display to capture mouse");
 		}
 
-		// Check if this frame should be screenshotted (after texture is displayed)
-		bool took_screenshot_this_frame = false;
-		if (screenshot_mode) {
-			auto it = std::find(screenshot_frames.begin(), screenshot_frames.end(), video.count_frame);
-			if (it != screenshot_frames.end()) {
-				save_screenshot(video.count_frame);
-				screenshot_frames.erase(it);  // Remove frame from list after capturing
-				took_screenshot_this_frame = true;
-			}
-		}
-		
-		// Check if this frame should have memory dumped
-		if (memory_dump_mode) {
-			auto it = std::find(memory_dump_frames.begin(), memory_dump_frames.end(), video.count_frame);
-			if (it != memory_dump_frames.end()) {
-				save_memory_dump(video.count_frame);
-				memory_dump_frames.erase(it);  // Remove frame from list after dumping
-			}
-		}
-		
-		// Check if we should trigger reset at this frame
-		if (reset_at_frame_enabled && video.count_frame == reset_at_frame) {
-			fprintf(stderr, "GUI: Triggering %s reset at frame %d\n",
-					reset_at_frame_cold ? "COLD" : "WARM", reset_at_frame);
-			reset_pending = 1;
-			reset_pending_cold = reset_at_frame_cold ? 1 : 0;
-			reset_at_frame_enabled = false;  // Only trigger once
-		}
-
-		// Check if we should stop at this frame
-		if (stop_at_frame_enabled && video.count_frame == stop_at_frame) {
-			if (took_screenshot_this_frame) {
-				printf("Reached stop frame %d after taking screenshot, exiting...\n", stop_at_frame);
-			} else {
-				printf("Reached stop frame %d, exiting...\n", stop_at_frame);
-			}
-			exit(0);
-		}
-		
 		ImGui::End();
 
 		if (ImGuiFileDialog::Instance()->Display("ChooseFileDlgKey"))
@@ -5626,7 +6424,7 @@ int main(int argc, char** argv, char** env) {
 				// action
 				fprintf(stderr, "filePathName: %s\n", filePathName.c_str());
 				fprintf(stderr, "filePath: %s\n", filePath.c_str());
-				bus.QueueDownload(filePathName, 1, 1);
+				to_sim.Send([filePathName] { bus.QueueDownload(filePathName, 1, 1); });
 			}
 
 			// close
@@ -5636,10 +6434,11 @@ int main(int argc, char** argv, char** env) {
 		// File dialog for 3.5" WOZ mount (any floppy format, converted to WOZ)
 		if (ImGuiFileDialog::Instance()->Display("MountWOZ35")) {
 			if (ImGuiFileDialog::Instance()->IsOk()) {
-				std::string path = prepareFloppyImage(ImGuiFileDialog::Instance()->GetFilePathName());
+				FloppySource src;
+				std::string path = prepareFloppyImage(ImGuiFileDialog::Instance()->GetFilePathName(), &src);
 				int wozType = detectWozType(path.c_str());
 				if (wozType == 5 || wozType == -1) {
-					blockdevice.MountDisk(path, 5);
+					guiDiskCommand(5, [path, src] { blockdevice.MountDisk(path, 5); blockdevice.SetFloppySource(5, src); });
 				} else {
 					printf("WARNING: Selected a 5.25\" WOZ for 3.5\" slot\n");
 				}
@@ -5650,10 +6449,11 @@ int main(int argc, char** argv, char** env) {
 		// File dialog for 5.25" WOZ mount (any floppy format, converted to WOZ)
 		if (ImGuiFileDialog::Instance()->Display("MountWOZ525")) {
 			if (ImGuiFileDialog::Instance()->IsOk()) {
-				std::string path = prepareFloppyImage(ImGuiFileDialog::Instance()->GetFilePathName());
+				FloppySource src;
+				std::string path = prepareFloppyImage(ImGuiFileDialog::Instance()->GetFilePathName(), &src);
 				int wozType = detectWozType(path.c_str());
 				if (wozType == 4 || wozType == -1) {
-					blockdevice.MountDisk(path, 4);
+					guiDiskCommand(4, [path, src] { blockdevice.MountDisk(path, 4); blockdevice.SetFloppySource(4, src); });
 				} else {
 					printf("WARNING: Selected a 3.5\" WOZ for 5.25\" slot\n");
 				}
@@ -5678,7 +6478,13 @@ int main(int argc, char** argv, char** env) {
 			audio.CollectDebug((signed short)top->AUDIO_L, (signed short)top->AUDIO_R);
 		}
 		int channelWidth = (windowWidth / 2) - 16;
-		ImPlot::CreateContext();
+		if (audio.playing) {
+			ImGui::Text("%d Hz  buffered %.0f ms  sim %.0f%% of real time  underruns %u  overruns %u",
+				audio.sample_rate, audio.buffered_ms.load(), audio.sim_speed.load() * 100.0f,
+				audio.underruns.load(), audio.overruns.load());
+		} else {
+			ImGui::Text("No audio device");
+		}
 		if (ImPlot::BeginPlot("Audio - L", ImVec2(channelWidth, 220), ImPlotFlags_NoLegend | ImPlotFlags_NoMenus | ImPlotFlags_NoTitle)) {
 			ImPlot::SetupAxes("T", "A", ImPlotAxisFlags_NoLabel | ImPlotAxisFlags_NoTickMarks, ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_NoLabel | ImPlotAxisFlags_NoTickMarks);
 			ImPlot::SetupAxesLimits(0, 1, -1, 1, ImPlotCond_Once);
@@ -5692,58 +6498,23 @@ int main(int argc, char** argv, char** env) {
 			ImPlot::PlotStairs("", audio.debug_positions, audio.debug_wave_r, audio.debug_max_samples, audio.debug_pos);
 			ImPlot::EndPlot();
 		}
-		ImPlot::DestroyContext();
 		ImGui::End();
 #endif
 
+		drawPerfWindow(windowX + windowWidth + 10, 0, 560);
+
 		video.UpdateTexture();
 
 
 		// Pass inputs to sim
-
-		top->menu = input.inputs[input_menu];
-
-		top->joystick_0 = 0;
+		int joy = 0;
 		for (int i = 0; i < input.inputCount; i++)
 		{
-			if (input.inputs[i]) { top->joystick_0 |= (1 << i); }
-		}
-		top->joystick_1 = top->joystick_0;
-
-		// Apply joystick/paddle values via analog inputs
-		if (joystick_injection_active) {
-			top->joystick_l_analog_0 = pack_analog(injected_paddle0, injected_paddle1);
-			top->joystick_l_analog_1 = pack_analog(injected_paddle2, injected_paddle3);
-			// Override button bits for injected buttons
-			if (injected_joy_buttons & 1) top->joystick_0 |= (1 << 4);  // Button 0
-			if (injected_joy_buttons & 2) top->joystick_0 |= (1 << 5);  // Button 1
-		} else {
-			// Default centered position (128 = signed 0)
-			top->joystick_l_analog_0 = pack_analog(128, 128);
-			top->joystick_l_analog_1 = pack_analog(128, 128);
+			if (input.inputs[i]) { joy |= (1 << i); }
 		}
 
-		/*top->joystick_analog_0 += 1;
-		top->joystick_analog_0 -= 256;*/
-		//top->paddle_0 += 1;
-		//if (input.inputs[0] || input.inputs[1]) {
-		//	spinner_toggle = !spinner_toggle;
-		//	top->spinner_0 = (input.inputs[0]) ? 16 : -16;
-		//	for (char b = 8; b < 16; b++) {
-		//		top->spinner_0 &= ~(1UL << b);
-		//	}
-		//	if (spinner_toggle) { top->spinner_0 |= 1UL << 8; }
-		//}
-
-		// Mouse input: check for injection first, then captured mouse or arrow keys as fallback
-		if (mouse_injection_active) {
-			// Use injected mouse values
-			// Negate Y: user's positive dy = move down, but internal convention is negative Y = down
-			mouse_x = injected_mouse_x;
-			mouse_y = -injected_mouse_y;
-			mouse_buttons = injected_mouse_buttons;
-		} else if (!mouse_captured) {
-			// Fallback to arrow keys when mouse not captured
+		// Mouse input: captured mouse, or arrow keys as fallback
+		if (!mouse_captured) {
 			mouse_buttons = 0;
 			mouse_x = 0;
 			mouse_y = 0;
@@ -5754,41 +6525,25 @@ int main(int argc, char** argv, char** env) {
 			if (input.inputs[input_a]) { mouse_buttons |= 0x01; }
 		}
 		// mouse_x, mouse_y, mouse_buttons already set from SDL events when captured
-
-		// Build PS/2 mouse packet (matching MiSTer hps_io format):
-		// Byte 0 [7:0]: YOvfl[7], XOvfl[6], Ysign[5], Xsign[4], 1[3], Mbtn[2], Rbtn[1], Lbtn[0]
-		// Byte 1 [15:8]: X delta (signed 8-bit)
-		// Byte 2 [23:16]: Y delta (signed 8-bit, already negated by MiSTer)
-		// Bit 24: Toggle bit for event detection
-		unsigned char status_byte = (mouse_buttons & 0x07) | 0x08;  // Bit 3 always 1 per PS/2 spec
-		if (mouse_x < 0) status_byte |= 0x10;  // X sign bit
-		if (mouse_y < 0) status_byte |= 0x20;  // Y sign bit
-
-		unsigned long mouse_temp = status_byte;
-		mouse_temp |= ((unsigned char)mouse_x << 8);
-		mouse_temp |= ((unsigned char)mouse_y << 16);
-
-		// Toggle clock when there's mouse movement OR button state changed
-		// Critical: must detect button releases (when mouse_buttons becomes 0)
-		if (mouse_x != 0 || mouse_y != 0 || mouse_buttons != prev_mouse_buttons) {
-			mouse_clock = !mouse_clock;
+		bool menu = input.inputs[input_menu];
+		int mx = mouse_x, my = mouse_y, mb = mouse_buttons;
+		// Host input is state, not a stream: keep one update in flight at most
+		// so a slow batch can't fill the ring with them; mouse motion keeps
+		// accumulating until the next one goes
+		if (!host_input_queued) {
+			host_input_queued = true;
+			to_sim.Send([joy, menu, mx, my, mb] { host_input_queued = false; setHostInput(joy, menu, mx, my, mb); });
+			host_input_sent = true;
 		}
-		prev_mouse_buttons = mouse_buttons;
-		if (mouse_clock) { mouse_temp |= (1UL << 24); }
-
-		top->ps2_mouse = mouse_temp;
-		top->ps2_mouse_ext = mouse_x + (mouse_buttons << 8);
 
-		// Run simulation
-		switch (run_state) {
-		case RunState::StepIn:
-		case RunState::NextIRQ:
-		case RunState::Running: RunBatch(batchSize); break;
-		case RunState::SingleClock: verilate(); break;
-		case RunState::MultiClock: RunBatch(multi_step_amount); break;
-		default: std::this_thread::sleep_for(std::chrono::milliseconds(10));
-		}
+		// Redraw at display rate; the sim thread never waits for us
+		next_gui_frame += std::chrono::microseconds(16667);
+		auto now = std::chrono::steady_clock::now();
+		if (next_gui_frame < now) next_gui_frame = now;
+		else std::this_thread::sleep_until(next_gui_frame);
 	}
+	sim_quit = true;
+	sim_thread.join();
 
 	// Clean up before exit
 	// --------------------
@@ -5796,8 +6551,12 @@ int main(int argc, char** argv, char** env) {
 #ifndef DISABLE_AUDIO
 	audio.CleanUp();
 #endif 
+	ImPlot::DestroyContext();
 	video.CleanUp();
 	input.CleanUp();
+	blockdevice.FlushAll();
+	if (sim_exit_code >= 0) return sim_exit_code;	// a stop condition already wrote the reports
+	writeExitReports();
 
 	return 0;
 }
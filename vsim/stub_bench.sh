@@ -0,0 +1,95 @@
+#!/bin/bash
+# Per-subsystem eval cost: build Vemu once per stub switch and time a headless
+# run of the same boot, so the cost of each peripheral shows up as the delta
+# against the full build. The delta is taken on eval time (--eval-time, the
+# time inside top->eval() alone), not whole-process wall time.
+#
+# A stub is only a fair comparison if the guest did the same work, so every
+# run also writes --hash-log and is compared with the full build by
+# tools/hashcmp (video and memory; cycle, pc and CPU registers are ignored as
+# for other cross-build checks). A variant that diverges -- say ADB=stub
+# taking a different path through the ROM's ADB init -- is marked, and its
+# saving is not a cost of the stubbed block.
+#
+#   ./stub_bench.sh [frames] [extra Vemu args...]
+#   make bench-stubs BENCH_FRAMES=600 BENCH_ARGS="--disk gsos.hdv"
+#
+# Each variant gets its own object dir (obj_stub_<name>) so the normal
+# obj_dir build is left alone and reruns only rebuild what changed.
+
+FRAMES=${1:-300}
+shift
+EXTRA="$@"
+
+VARIANTS=(
+    "full:"
+    "sound:SOUND=stub"
+    "scc:SCC=stub"
+    "iwm:IWM=stub"
+    "adb:ADB=stub"
+    "paddle:PADDLE=stub"
+    "all:SOUND=stub SCC=stub IWM=stub ADB=stub PADDLE=stub"
+)
+
+[ -x tools/hashcmp ] || make tools/hashcmp > /dev/null || exit 1
+
+declare -A WALL EVAL SAME
+
+for v in "${VARIANTS[@]}"; do
+    name=${v%%:*}
+    vars=${v#*:}
+    echo "=== $name ($vars) ==="
+    if ! make OBJ_DIR=obj_stub_$name $vars > obj_stub_$name.build.txt 2>&1; then
+        echo "  build failed, see obj_stub_$name.build.txt"
+        continue
+    fi
+    rm -f obj_stub_$name.hlog
+    ./obj_stub_$name/Vemu --headless --stop-at-frame $FRAMES --eval-time --hash-log obj_stub_$name.hlog \
+        $EXTRA > obj_stub_$name.run.txt 2>&1
+    stats=$(grep '^SIMSTATS:' obj_stub_$name.run.txt | tail -1)
+    if [ -z "$stats" ]; then
+        echo "  no SIMSTATS line, see obj_stub_$name.run.txt"
+        continue
+    fi
+    echo "  $stats"
+    WALL[$name]=$(echo "$stats" | sed -n 's/.*wall=\([0-9.]*\).*/\1/p')
+    EVAL[$name]=$(echo "$stats" | sed -n 's/.*eval=\([0-9.]*\).*/\1/p')
+    if [ $name = full ]; then
+        SAME[$name]=ref
+    elif [ ! -f obj_stub_full.hlog ]; then
+        SAME[$name]="?"
+    elif ./tools/hashcmp obj_stub_full.hlog obj_stub_$name.hlog --ignore cycle,pc,cpu > obj_stub_$name.cmp.txt; then
+        SAME[$name]=yes
+    else
+        first=$(sed -n 's/^first divergence at frame \([0-9]*\).*/\1/p' obj_stub_$name.cmp.txt)
+        SAME[$name]="NO@${first:-?}"
+        echo "  diverges from full, see obj_stub_$name.cmp.txt"
+    fi
+done
+
+FULL=${EVAL[full]}
+if [ -z "$FULL" ]; then
+    echo "full build did not run, no table"
+    exit 1
+fi
+
+echo ""
+echo "$FRAMES frames $EXTRA"
+printf "%-8s %10s %10s %10s %10s %8s %8s\n" variant "wall s" "eval s" "ms/frame" "saved s" "% eval" "same"
+DIVERGED=0
+for v in "${VARIANTS[@]}"; do
+    name=${v%%:*}
+    e=${EVAL[$name]}
+    if [ -z "$e" ]; then
+        printf "%-8s %10s\n" $name "-"
+        continue
+    fi
+    case ${SAME[$name]} in ref|yes) ;; *) DIVERGED=1 ;; esac
+    awk -v n=$name -v w=${WALL[$name]} -v e=$e -v f=$FULL -v fr=$FRAMES -v s=${SAME[$name]} 'BEGIN {
+        printf "%-8s %10.2f %10.2f %10.2f %10.2f %7.1f%% %8s\n", n, w, e, e * 1000 / fr, f - e, (f - e) * 100 / f, s
+    }'
+done
+if [ $DIVERGED = 1 ]; then
+    echo ""
+    echo "variants not marked yes/ref ran a different workload; their saving is not comparable"
+fi
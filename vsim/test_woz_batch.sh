@@ -29,10 +29,21 @@
 #                   finishes the full set in ~1/7 the wall-clock time. Each
 #                   worker writes its own screenshot via --screenshot-name so
 #                   workers don't collide in the same cwd.
+#   --no-detect     Always run to the frame budget. By default Vemu runs with
+#                   --detect all and stops a disk early once it has crashed
+#                   into the monitor (CRASH), spun in a tight loop with no I/O
+#                   (HANG) or shown the same screen with no disk activity
+#                   (STATIC, classified from the screenshot like a full run).
+#   --prescreen     Run tools/iigsimg screen (software IWM, milliseconds per
+#                   disk) over the work list first. Disks whose boot track has
+#                   no readable sector are recorded as UNREADABLE without
+#                   starting the sim; the rest run as usual. The screen
+#                   verdicts are kept in DIR/screen.tsv.
 #
 # Files produced in DIR/:
 #   index.html            human-review page
 #   results.csv           one row per disk, authoritative state
+#   screen.tsv            software IWM verdicts (--prescreen only)
 #   shots/<hash>.png      deduped screenshot images
 #   retest.txt            generated by HTML checkboxes when you download
 
@@ -44,6 +55,8 @@ BATCH=0
 JOBS=1
 RETEST=""
 REDO_STATUS=""
+PRESCREEN=0
+DETECT=1
 OUT="woz_report"
 WOZTEST_DIR="woztest"
 
@@ -55,9 +68,11 @@ while [[ $# -gt 0 ]]; do
     --jobs|-j)      JOBS="$2"; shift 2 ;;
     --retest)       RETEST="$2"; shift 2 ;;
     --redo-status)  REDO_STATUS="$2"; shift 2 ;;
+    --prescreen)    PRESCREEN=1; shift ;;
+    --no-detect)    DETECT=0; shift ;;
     --out)          OUT="$2"; shift 2 ;;
     --help|-h)
-      sed -n '3,42p' "$0"; exit 0 ;;
+      sed -n '3,53p' "$0"; exit 0 ;;
     *) echo "Unknown argument: $1" >&2; exit 2 ;;
   esac
 done
@@ -66,6 +81,10 @@ if [[ ! -x ./obj_dir/Vemu ]]; then
   echo "ERROR: ./obj_dir/Vemu not found — run make first" >&2
   exit 1
 fi
+if [[ "$PRESCREEN" -eq 1 && ! -x ./tools/iigsimg ]]; then
+  echo "ERROR: ./tools/iigsimg not found — run make iigsimg first" >&2
+  exit 1
+fi
 if [[ ! -d "$WOZTEST_DIR" ]]; then
   echo "ERROR: $WOZTEST_DIR/ not found" >&2
   exit 1
@@ -170,6 +189,20 @@ if [[ "$BATCH" -gt 0 ]]; then
   echo "Batch size: processing $(wc -l < "$WORK_LIST" | tr -d ' ') disks this run"
 fi
 
+if [[ "$PRESCREEN" -eq 1 && -s "$WORK_LIST" ]]; then
+  # Static pass: record disks the IWM can't read a boot sector from, and
+  # only hand the rest to the (minutes-per-disk) RTL sim.
+  ./tools/iigsimg screen --apply --out "$OUT" --from "$WORK_LIST" | tail -n 2
+  awk -F'\t' 'NR > 1 && $2 == "UNREADABLE" { print $1 }' "$OUT/screen.tsv" > "$WORK_LIST.unreadable"
+  while IFS= read -r woz; do
+    printf 'UNREADABLE,0,,0,0,"%s"\n' "$woz" >> "$CSV"
+  done < "$WORK_LIST.unreadable"
+  grep -F -x -v -f "$WORK_LIST.unreadable" "$WORK_LIST" > "$WORK_LIST.keep" || true
+  mv "$WORK_LIST.keep" "$WORK_LIST"
+  echo "Prescreen: $(wc -l < "$WORK_LIST.unreadable" | tr -d ' ') unreadable disks skipped"
+  rm -f "$WORK_LIST.unreadable"
+fi
+
 WORK_COUNT=$(wc -l < "$WORK_LIST" | tr -d ' ')
 if [[ "$WORK_COUNT" -eq 0 ]]; then
   echo "Nothing to do."
@@ -189,7 +222,9 @@ trap 'rm -rf "$TMPDIR_WORK"' EXIT
 PROGRESS_FILE="$TMPDIR_WORK/progress"
 echo 0 > "$PROGRESS_FILE"
 
-export OUT CSV FRAMES TIMEOUT WORK_COUNT TMPDIR_WORK PROGRESS_FILE
+DETECT_ARGS=""
+[[ "$DETECT" -eq 1 ]] && DETECT_ARGS="--detect all"
+export OUT CSV FRAMES TIMEOUT WORK_COUNT TMPDIR_WORK PROGRESS_FILE DETECT_ARGS
 
 # Worker: process one disk. Called with the woz path as $1.
 # Writes a CSV row via flock and prints a progress line.
@@ -199,19 +234,20 @@ run_one_disk() {
 
   # Unique per-invocation screenshot path so parallel workers don't collide
   local shot="$TMPDIR_WORK/shot.$$.$RANDOM.png"
+  local result="${shot%.png}.json"
 
   local start end elapsed rc png_size hash status
   start=$(date +%s)
   if command -v gtimeout >/dev/null 2>&1; then
     gtimeout "$TIMEOUT" ./obj_dir/Vemu --quiet --no-cpu-log \
         --woz "$woz" --stop-at-frame "$FRAMES" --screenshot "$FRAMES" \
-        --screenshot-name "$shot" \
+        --screenshot-name "$shot" --result "$result" $DETECT_ARGS \
         >/dev/null 2>&1
     rc=$?
   else
     ./obj_dir/Vemu --quiet --no-cpu-log \
         --woz "$woz" --stop-at-frame "$FRAMES" --screenshot "$FRAMES" \
-        --screenshot-name "$shot" \
+        --screenshot-name "$shot" --result "$result" $DETECT_ARGS \
         >/dev/null 2>&1 &
     local pid=$!
     (sleep "$TIMEOUT" && kill -9 "$pid" 2>/dev/null) & local watchdog=$!
@@ -221,6 +257,9 @@ run_one_disk() {
   fi
   end=$(date +%s)
   elapsed=$((end - start))
+  # OK / CRASH / HANG / STATIC from the in-sim detectors (--result)
+  local detected=""
+  [[ -f "$result" ]] && detected=$(sed -n 's/.*"status":"\([A-Z]*\)".*/\1/p' "$result")
 
   if [[ -f "$shot" ]]; then
     png_size=$(stat -f%z "$shot" 2>/dev/null || stat -c%s "$shot")
@@ -234,6 +273,10 @@ run_one_disk() {
     else
       status=BOOTED
     fi
+    # A crash or hang caught in-sim beats the screenshot size heuristic
+    if [[ "$detected" == CRASH || "$detected" == HANG ]]; then
+      status=$detected
+    fi
   else
     png_size=0
     hash=""
@@ -262,7 +305,7 @@ run_one_disk() {
       "$n" "$WORK_COUNT" "$status" "$png_size" "$elapsed" "$woz"
   rmdir "$lockdir"
 
-  rm -f "$shot"
+  rm -f "$shot" "$result"
 }
 export -f run_one_disk
 
@@ -341,6 +384,8 @@ cat > "$HTML" <<HTML_HEAD
   .status.BLANK     { background: #888; }
   .status.TIMEOUT   { background: #c33; }
   .status.CRASH     { background: #808; }
+  .status.HANG      { background: #a50; }
+  .status.UNREADABLE { background: #543; }
   .count { color: #555; font-size: 14px; }
   details { margin-top: 8px; }
   summary { cursor: pointer; color: #06c; font-size: 13px; }
@@ -375,6 +420,8 @@ cat > "$HTML" <<HTML_HEAD
   <button data-filter="BLANK">BLANK</button>
   <button data-filter="TIMEOUT">TIMEOUT</button>
   <button data-filter="CRASH">CRASH</button>
+  <button data-filter="HANG">HANG</button>
+  <button data-filter="UNREADABLE">UNREADABLE</button>
 </div>
 <div id="lightbox"><img src="" alt=""></div>
 <div id="report">
@@ -393,7 +440,7 @@ awk -F',' 'NR > 1 {
 }
 END {
   ord["BOOTED"]=0; ord["TEXT_ONLY"]=1; ord["BLANK"]=2
-  ord["TIMEOUT"]=3; ord["CRASH"]=4
+  ord["TIMEOUT"]=3; ord["CRASH"]=4; ord["HANG"]=5; ord["UNREADABLE"]=6
   n = 0
   for (k in count) keys[++n] = k
   for (i=1; i<=n; i++) for (j=i+1; j<=n; j++) {
@@ -447,7 +494,7 @@ cat >> "$HTML" <<'HTML_FOOT'
     totalDisks += n;
   });
   const bar = document.getElementById('summary');
-  ['BOOTED','TEXT_ONLY','BLANK','TIMEOUT','CRASH'].forEach(s => {
+  ['BOOTED','TEXT_ONLY','BLANK','TIMEOUT','CRASH','HANG','UNREADABLE'].forEach(s => {
     if (counts[s]) {
       const pct = (100 * counts[s] / totalDisks).toFixed(1);
       bar.innerHTML += `<span><span class="status ${s}">${s}</span> ${counts[s]} (${pct}%)</span>`;
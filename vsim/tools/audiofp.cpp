@@ -0,0 +1,121 @@
+// Compare two audio fingerprints written by Vemu --audio-fingerprint.
+//
+//   make audiofp
+//   ./tools/audiofp golden.afp test.afp [--tol-db 1.5] [--tol-band 1] [--max-bad 0] [-v]
+//
+// A fingerprint has one line per video frame: "frame rms_l_db rms_r_db bands",
+// where bands is one hex digit per frequency band (6 dB steps). Two frames
+// match when both channel levels are within --tol-db (or both below the
+// silence floor) and every band digit is within --tol-band. Exit status is 0
+// when no more than --max-bad frames differ, 1 otherwise, 2 on bad input.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <string>
+
+struct FpFrame {
+	float l, r;
+	std::string bands;
+};
+
+static const float kSilenceDb = -90.0f;
+
+static bool load(const char *path, std::map<int, FpFrame> &out)
+{
+	FILE *f = fopen(path, "r");
+	if (!f) { fprintf(stderr, "audiofp: cannot open %s\n", path); return false; }
+	char line[256];
+	int lineno = 0;
+	while (fgets(line, sizeof(line), f)) {
+		lineno++;
+		if (line[0] == '#' || line[0] == '\n') continue;
+		int frame;
+		float l, r;
+		char bands[32];
+		if (sscanf(line, "%d %f %f %31s", &frame, &l, &r, bands) != 4) {
+			fprintf(stderr, "audiofp: %s:%d: malformed line\n", path, lineno);
+			fclose(f);
+			return false;
+		}
+		out[frame] = FpFrame{ l, r, bands };
+	}
+	fclose(f);
+	return true;
+}
+
+static bool level_match(float a, float b, float tol)
+{
+	if (a < kSilenceDb && b < kSilenceDb) return true;
+	return fabsf(a - b) <= tol;
+}
+
+static int band_diff(const std::string &a, const std::string &b)
+{
+	if (a.size() != b.size()) return 99;
+	int worst = 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		int d = abs((int)strtol(std::string(1, a[i]).c_str(), nullptr, 16) -
+		            (int)strtol(std::string(1, b[i]).c_str(), nullptr, 16));
+		if (d > worst) worst = d;
+	}
+	return worst;
+}
+
+int main(int argc, char **argv)
+{
+	const char *golden = nullptr, *test = nullptr;
+	float tol_db = 1.5f;
+	int tol_band = 1, max_bad = 0, verbose = 0;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--tol-db") && i + 1 < argc) tol_db = (float)atof(argv[++i]);
+		else if (!strcmp(argv[i], "--tol-band") && i + 1 < argc) tol_band = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--max-bad") && i + 1 < argc) max_bad = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-v")) verbose = 1;
+		else if (!golden) golden = argv[i];
+		else if (!test) test = argv[i];
+		else { fprintf(stderr, "audiofp: unexpected argument %s\n", argv[i]); return 2; }
+	}
+	if (!golden || !test) {
+		fprintf(stderr, "usage: audiofp golden.afp test.afp [--tol-db N] [--tol-band N] [--max-bad N] [-v]\n");
+		return 2;
+	}
+
+	std::map<int, FpFrame> a, b;
+	if (!load(golden, a) || !load(test, b)) return 2;
+
+	int bad = 0, shown = 0, compared = 0;
+	for (auto &ga : a) {
+		auto it = b.find(ga.first);
+		const char *why = nullptr;
+		char detail[128] = "";
+		if (it == b.end()) {
+			why = "missing";
+		} else {
+			compared++;
+			const FpFrame &x = ga.second, &y = it->second;
+			int bd = band_diff(x.bands, y.bands);
+			if (!level_match(x.l, y.l, tol_db) || !level_match(x.r, y.r, tol_db)) why = "level";
+			else if (bd > tol_band) why = "spectrum";
+			snprintf(detail, sizeof(detail), "L %.1f/%.1f R %.1f/%.1f bands %s/%s",
+			         x.l, y.l, x.r, y.r, x.bands.c_str(), y.bands.c_str());
+		}
+		if (!why) continue;
+		bad++;
+		if (verbose || shown < 10) {
+			printf("frame %d: %s %s\n", ga.first, why, detail);
+			shown++;
+		}
+	}
+	for (auto &gb : b)
+		if (!a.count(gb.first)) {
+			bad++;
+			if (verbose || shown < 10) { printf("frame %d: extra\n", gb.first); shown++; }
+		}
+
+	printf("%s: %d frames compared, %d differ (tolerance %.1f dB, %d band steps)\n",
+	       bad <= max_bad ? "MATCH" : "DIFFER", compared, bad, tol_db, tol_band);
+	return bad <= max_bad ? 0 : 1;
+}
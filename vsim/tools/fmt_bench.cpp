@@ -0,0 +1,80 @@
+// Throughput benchmark for the iigs_fmt disk codec.
+//
+//   make fmt_bench && ./tools/fmt_bench [seconds-per-codec]
+//
+// Runs each encode/decode path over a random image for a fixed wall time and
+// reports MB/s of logical (user-visible) image data, so encode and decode of
+// the same format are directly comparable. Round-trips are checked once up
+// front; a mismatch exits non-zero so the bench doubles as a smoke test.
+
+#include "iigs_fmt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+static double g_secs = 0.5;
+static volatile uint32_t g_sink;   // keeps results alive across iterations
+
+typedef void (*BenchFn)(void);
+
+static std::vector<uint8_t> dsk(A2_525_IMAGE_SIZE), dsk2(A2_525_IMAGE_SIZE);
+static std::vector<uint8_t> po(A2_35_IMAGE_SIZE), po2(A2_35_IMAGE_SIZE);
+static std::vector<uint8_t> nib(A2_NIB_IMAGE_SIZE);
+static std::vector<uint8_t> woz525(512 * 1024), woz35(2 * 1024 * 1024);
+static size_t woz525_len, woz35_len;
+
+static void b_crc32(void)       { g_sink ^= woz_crc32(po.data(), po.size()); }
+static void b_dsk_to_nib(void)  { a2_dsk_to_nib(nib.data(), dsk.data()); g_sink ^= nib[100]; }
+static void b_nib_to_dsk(void)  { g_sink ^= a2_nib_to_dsk(dsk2.data(), nib.data()); }
+static void b_dsk_to_woz(void)  { g_sink ^= (uint32_t)a2_dsk_to_woz525(woz525.data(), woz525.size(), dsk.data()); }
+static void b_woz_to_dsk(void)  { g_sink ^= a2_woz525_to_dsk(dsk2.data(), woz525.data(), woz525_len); }
+static void b_po_to_woz(void)   { g_sink ^= (uint32_t)a2_po_to_woz35(woz35.data(), woz35.size(), po.data()); }
+static void b_woz_to_po(void)   { g_sink ^= a2_woz35_to_po(po2.data(), woz35.data(), woz35_len); }
+
+static void run(const char *name, BenchFn fn, size_t bytes)
+{
+	using clk = std::chrono::steady_clock;
+	fn();                                    // warm tables and caches
+	long iters = 0;
+	auto t0 = clk::now();
+	double el = 0;
+	do {
+		fn();
+		iters++;
+		el = std::chrono::duration<double>(clk::now() - t0).count();
+	} while (el < g_secs);
+	double mbs = (double)bytes * iters / el / (1024.0 * 1024.0);
+	printf("%-22s %10.1f MB/s  (%ld iters, %.2f ms/iter)\n", name, mbs, iters, el * 1000.0 / iters);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1) g_secs = atof(argv[1]);
+	if (g_secs <= 0) g_secs = 0.5;
+
+	srand(1);
+	for (auto &b : dsk) b = (uint8_t)rand();
+	for (auto &b : po)  b = (uint8_t)rand();
+
+	a2_dsk_to_nib(nib.data(), dsk.data());
+	woz525_len = a2_dsk_to_woz525(woz525.data(), woz525.size(), dsk.data());
+	woz35_len  = a2_po_to_woz35(woz35.data(), woz35.size(), po.data());
+
+	int bad = 0;
+	if (!a2_nib_to_dsk(dsk2.data(), nib.data()) || dsk2 != dsk)                          { printf("FAIL: NIB round-trip\n"); bad = 1; }
+	if (!woz525_len || !a2_woz525_to_dsk(dsk2.data(), woz525.data(), woz525_len) || dsk2 != dsk) { printf("FAIL: 5.25 WOZ round-trip\n"); bad = 1; }
+	if (!woz35_len || !a2_woz35_to_po(po2.data(), woz35.data(), woz35_len) || po2 != po) { printf("FAIL: 3.5 WOZ round-trip\n"); bad = 1; }
+	if (bad) return 1;
+
+	printf("iigs_fmt codec throughput (%.2fs per codec, MB = logical image bytes)\n", g_secs);
+	run("crc32 (800K)",     b_crc32,      po.size());
+	run("dsk -> nib",       b_dsk_to_nib, dsk.size());
+	run("nib -> dsk",       b_nib_to_dsk, dsk.size());
+	run("dsk -> woz 5.25",  b_dsk_to_woz, dsk.size());
+	run("woz 5.25 -> dsk",  b_woz_to_dsk, dsk.size());
+	run("po -> woz 3.5",    b_po_to_woz,  po.size());
+	run("woz 3.5 -> po",    b_woz_to_po,  po.size());
+	return 0;
+}
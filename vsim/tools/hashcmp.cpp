@@ -0,0 +1,146 @@
+// Compare two per-frame state hash logs written by Vemu --hash-log.
+//
+//   make hashcmp
+//   ./tools/hashcmp a.hlog b.hlog [--ignore cycle,pc,video,cpu,softsw,slowram,fastram] [-n 5] [-v]
+//
+// Frames are aligned by number. The first frame whose compared fields differ
+// is reported with both lines and the field names, followed by the next few
+// divergent frames (-n, default 5; -v prints every one). Frames present in
+// only one log count as divergent. For cross-build comparisons (default vs
+// FAITHFUL=1 or DUALRATE=1) where timing is expected to move, ignore cycle
+// and pc and compare video / memory only.
+//
+// Exit status: 0 identical, 1 divergent, 2 bad input.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+static const int kFields = 8;
+static const char *kFieldNames[kFields] = {
+	"cycle", "pc", "video", "cpu", "softsw", "slowram", "fastram", "dirty",
+};
+
+struct HashLine {
+	std::string f[kFields];
+	std::string text;
+};
+
+static bool load(const char *path, std::map<int, HashLine> &out)
+{
+	FILE *fp = fopen(path, "r");
+	if (!fp) { fprintf(stderr, "hashcmp: cannot open %s\n", path); return false; }
+	char line[512];
+	int lineno = 0;
+	while (fgets(line, sizeof(line), fp)) {
+		lineno++;
+		if (line[0] == '#' || line[0] == '\n') continue;
+		int frame;
+		char f[kFields][40];
+		if (sscanf(line, "%d %39s %39s %39s %39s %39s %39s %39s %39s", &frame,
+		           f[0], f[1], f[2], f[3], f[4], f[5], f[6], f[7]) != 1 + kFields) {
+			fprintf(stderr, "hashcmp: %s:%d: malformed line\n", path, lineno);
+			fclose(fp);
+			return false;
+		}
+		HashLine h;
+		for (int i = 0; i < kFields; i++) h.f[i] = f[i];
+		h.text = line;
+		if (!h.text.empty() && h.text.back() == '\n') h.text.pop_back();
+		out[frame] = h;
+	}
+	fclose(fp);
+	return true;
+}
+
+static bool parse_ignore(const char *list, bool *ignore)
+{
+	std::string s(list);
+	size_t pos = 0;
+	while (pos <= s.size()) {
+		size_t comma = s.find(',', pos);
+		std::string name = s.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+		int i;
+		for (i = 0; i < kFields; i++)
+			if (name == kFieldNames[i]) break;
+		if (i == kFields) {
+			fprintf(stderr, "hashcmp: unknown field '%s'\n", name.c_str());
+			return false;
+		}
+		ignore[i] = true;
+		if (comma == std::string::npos) break;
+		pos = comma + 1;
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	const char *pa = nullptr, *pb = nullptr;
+	bool ignore[kFields] = {};
+	int show = 5, verbose = 0;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--ignore") && i + 1 < argc) {
+			if (!parse_ignore(argv[++i], ignore)) return 2;
+		}
+		else if (!strcmp(argv[i], "-n") && i + 1 < argc) show = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-v")) verbose = 1;
+		else if (!pa) pa = argv[i];
+		else if (!pb) pb = argv[i];
+		else { fprintf(stderr, "hashcmp: unexpected argument %s\n", argv[i]); return 2; }
+	}
+	if (!pa || !pb) {
+		fprintf(stderr, "usage: hashcmp a.hlog b.hlog [--ignore field,...] [-n N] [-v]\n");
+		return 2;
+	}
+	// dirty page counts follow the fastram hash; never compare them on their own
+	ignore[7] = true;
+
+	std::map<int, HashLine> a, b;
+	if (!load(pa, a) || !load(pb, b)) return 2;
+
+	// union of frame numbers, in order
+	std::map<int, int> frames;
+	for (auto &x : a) frames[x.first] |= 1;
+	for (auto &x : b) frames[x.first] |= 2;
+
+	int first = -1, last_match = -1, bad = 0, shown = 0, compared = 0;
+	for (auto &fr : frames) {
+		std::string why;
+		if (fr.second != 3) {
+			why = fr.second == 1 ? "only in first" : "only in second";
+		} else {
+			compared++;
+			const HashLine &x = a[fr.first], &y = b[fr.first];
+			for (int i = 0; i < kFields; i++)
+				if (!ignore[i] && x.f[i] != y.f[i]) {
+					if (!why.empty()) why += ",";
+					why += kFieldNames[i];
+				}
+		}
+		if (why.empty()) {
+			if (first < 0) last_match = fr.first;
+			continue;
+		}
+		bad++;
+		if (first < 0) {
+			first = fr.first;
+			printf("first divergence at frame %d (%s)\n", fr.first, why.c_str());
+			if (a.count(fr.first)) printf("  < %s\n", a[fr.first].text.c_str());
+			if (b.count(fr.first)) printf("  > %s\n", b[fr.first].text.c_str());
+			if (last_match >= 0) printf("  last matching frame %d\n", last_match);
+			shown++;
+		} else if (verbose || shown < show) {
+			printf("frame %d: %s\n", fr.first, why.c_str());
+			shown++;
+		}
+	}
+
+	if (first < 0)
+		printf("IDENTICAL: %d frames compared\n", compared);
+	else
+		printf("DIFFER: %d frames compared, %d differ, first at frame %d\n", compared, bad, first);
+	return first < 0 ? 0 : 1;
+}
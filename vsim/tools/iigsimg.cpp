@@ -0,0 +1,917 @@
+// iigsimg -- command-line disk-image toolkit built on sim/iigs_fmt.
+//
+// Replaces the parsing that woz_classify_platform.py / woz_detect_13sector.py
+// re-implement in Python: everything here goes through the same codec the
+// simulator uses, so a disk that converts here converts the same way in
+// --woz.
+//
+//   iigsimg info    FILE...                 format, class, WOZ INFO, tracks
+//   iigsimg convert IN OUT                  DSK/DO/PO/NIB/2MG/DC42/HDV <-> WOZ
+//                                           (output format from OUT's extension)
+//   iigsimg verify  [-j N] PATH...          round-trip each image through WOZ
+//   iigsimg scan    [-j N] [--out DIR] [--apply] [--mark-13] PATH...
+//                   classify every image under PATH, detect 13-sector and
+//                   flux tracks; --apply writes DIR/catalog.tsv for
+//                   woz_review.sh, --mark-13 appends 13-sector disks to
+//                   DIR/triage.csv (existing rows are never touched)
+//   iigsimg screen  [-j N] [-v] [--out DIR] [--apply] [--from LIST] PATH...
+//                   software IWM pass over every WOZ track (bitstream or
+//                   flux): sync, address/data checksums, readable sectors
+//                   and protection signatures. Verdict per disk is CLEAN,
+//                   PROTECTED, DAMAGED or UNREADABLE; --apply writes
+//                   DIR/screen.tsv (test_woz_batch.sh --prescreen)
+//
+// Directories are walked recursively; files are mmapped and processed on a
+// pool of -j worker threads (default: all cores). Output order is sorted by
+// path regardless of -j.
+
+#include "iigs_fmt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// mmapped input
+// ---------------------------------------------------------------------------
+struct MappedFile {
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+
+	bool Open(const std::string &path)
+	{
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { close(fd); return false; }
+		size = (size_t)st.st_size;
+		if (size) {
+			void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p == MAP_FAILED) { close(fd); size = 0; return false; }
+			data = (const uint8_t *)p;
+		}
+		close(fd);
+		return true;
+	}
+	~MappedFile() { if (data) munmap((void *)data, size); }
+};
+
+static std::string lower_ext(const std::string &path)
+{
+	size_t slash = path.find_last_of('/');
+	size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return "";
+	std::string e = path.substr(dot + 1);
+	for (auto &c : e) c = (char)tolower((unsigned char)c);
+	return e;
+}
+
+static std::string base_name(const std::string &path)
+{
+	size_t slash = path.find_last_of('/');
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+static bool write_file(const std::string &path, const uint8_t *data, size_t len)
+{
+	FILE *f = fopen(path.c_str(), "wb");
+	if (!f) return false;
+	bool ok = fwrite(data, 1, len, f) == len;
+	return (fclose(f) == 0) && ok;
+}
+
+// ---------------------------------------------------------------------------
+// directory walk + worker pool
+// ---------------------------------------------------------------------------
+static const char *const image_exts[] = {
+	"woz", "dsk", "do", "po", "nib", "2mg", "2img", "dc", "dc42", "image", "hdv", nullptr
+};
+
+static bool is_image_ext(const std::string &ext)
+{
+	for (int i = 0; image_exts[i]; i++)
+		if (ext == image_exts[i]) return true;
+	return false;
+}
+
+static void walk(const std::string &path, const char *only_ext, std::vector<std::string> &out)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0) {
+		fprintf(stderr, "iigsimg: %s: not found\n", path.c_str());
+		return;
+	}
+	if (!S_ISDIR(st.st_mode)) {
+		out.push_back(path);    // named explicitly: take it whatever the extension
+		return;
+	}
+	DIR *d = opendir(path.c_str());
+	if (!d) return;
+	while (struct dirent *e = readdir(d)) {
+		if (e->d_name[0] == '.') continue;
+		std::string child = path;
+		if (child.empty() || child.back() != '/') child += '/';
+		child += e->d_name;
+		if (stat(child.c_str(), &st) != 0) continue;
+		if (S_ISDIR(st.st_mode)) {
+			walk(child, only_ext, out);
+		} else {
+			std::string ext = lower_ext(child);
+			if (only_ext ? ext == only_ext : is_image_ext(ext)) out.push_back(child);
+		}
+	}
+	closedir(d);
+}
+
+static void parallel_for(size_t n, int jobs, const std::function<void(size_t)> &fn)
+{
+	if (jobs < 1) jobs = 1;
+	if ((size_t)jobs > n) jobs = (int)n;
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> pool;
+	for (int j = 0; j < jobs; j++)
+		pool.emplace_back([&]() {
+			for (size_t i; (i = next++) < n; ) fn(i);
+		});
+	for (auto &t : pool) t.join();
+}
+
+// ---------------------------------------------------------------------------
+// logical images
+// ---------------------------------------------------------------------------
+// Every input is normalised to one canonical layout per class: 5.25" is a
+// DOS-order 140K DSK, 3.5" an 800K ProDOS-order PO, hard disks raw blocks.
+struct Logical {
+	DiskClass cls = DC_UNKNOWN;
+	std::vector<uint8_t> data;
+	std::string fmt;        // source container: woz1, woz2, 2mg, dc42, nib, dsk, po, hdv
+};
+
+static bool load_logical(const uint8_t *buf, size_t size, const std::string &ext,
+                         Logical &out, std::string &why)
+{
+	int wt = woz_disk_type(buf, size);
+	if (wt > 0) {
+		out.fmt = memcmp(buf, "WOZ1", 4) == 0 ? "woz1" : "woz2";
+		if (wt == 1) {
+			out.cls = DC_FLOPPY_525;
+			out.data.assign(A2_525_IMAGE_SIZE, 0);
+			if (!a2_woz525_to_dsk(out.data.data(), buf, size)) { why = "unreadable 5.25\" tracks"; return false; }
+		} else if (wt == 2) {
+			out.cls = DC_FLOPPY_35;
+			out.data.assign(A2_35_IMAGE_SIZE, 0);
+			if (!a2_woz35_to_po(out.data.data(), buf, size)) { why = "unreadable 3.5\" tracks"; return false; }
+		} else {
+			why = "WOZ disk_type " + std::to_string(wt);
+			return false;
+		}
+		return true;
+	}
+
+	const uint8_t *pay = buf;
+	size_t plen = size;
+	int order_prodos = (ext == "po"), order_nib = (ext == "nib" || size == A2_NIB_IMAGE_SIZE);
+	out.fmt = ext.empty() ? "raw" : ext;
+	TwoMG m;
+	DC42 d;
+	if (twomg_parse(buf, size, &m)) {
+		pay = buf + m.data_offset;
+		plen = m.data_len;
+		order_prodos = (m.format == 1);
+		order_nib = (m.format == 2);
+		out.fmt = "2mg";
+	} else if (dc42_parse(buf, size, &d)) {
+		pay = buf + 84;
+		plen = d.data_size;
+		order_prodos = 1;
+		order_nib = 0;
+		out.fmt = "dc42";
+	}
+
+	if (order_nib) {
+		if (plen != A2_NIB_IMAGE_SIZE) { why = "NIB payload is not 232960 bytes"; return false; }
+		out.cls = DC_FLOPPY_525;
+		out.data.assign(A2_525_IMAGE_SIZE, 0);
+		if (!a2_nib_to_dsk(out.data.data(), pay)) { why = "unreadable NIB tracks"; return false; }
+		return true;
+	}
+	if (plen == A2_525_IMAGE_SIZE) {
+		out.cls = DC_FLOPPY_525;
+		out.data.resize(A2_525_IMAGE_SIZE);
+		if (order_prodos) a2_prodos_to_dos(out.data.data(), pay);
+		else              memcpy(out.data.data(), pay, plen);
+		return true;
+	}
+	if (plen == A2_35_IMAGE_SIZE) {
+		out.cls = DC_FLOPPY_35;
+		out.data.assign(pay, pay + plen);
+		return true;
+	}
+	if (plen > 0 && (plen % A2_BLOCK_SIZE) == 0) {
+		out.cls = DC_HDD;
+		out.data.assign(pay, pay + plen);
+		return true;
+	}
+	why = "unrecognised image";
+	return false;
+}
+
+// Encode a logical image in the container named by ext. Empty result = error.
+static std::vector<uint8_t> encode_as(const Logical &img, const std::string &ext, std::string &why)
+{
+	std::vector<uint8_t> out;
+	const uint8_t *src = img.data.data();
+	size_t len = img.data.size();
+
+	if (ext == "woz") {
+		size_t n = 0;
+		if (img.cls == DC_FLOPPY_525) {
+			out.resize(512 * 1024);
+			n = a2_dsk_to_woz525(out.data(), out.size(), src);
+		} else if (img.cls == DC_FLOPPY_35) {
+			out.resize(2 * 1024 * 1024);
+			n = a2_po_to_woz35(out.data(), out.size(), src);
+		} else {
+			why = "only 140K/800K floppies convert to WOZ";
+		}
+		out.resize(n);
+		return out;
+	}
+	if (ext == "dsk" || ext == "do") {
+		if (img.cls != DC_FLOPPY_525) { why = "DOS order is 5.25\" only"; return out; }
+		out.assign(src, src + len);
+		return out;
+	}
+	if (ext == "nib") {
+		if (img.cls != DC_FLOPPY_525) { why = "NIB is 5.25\" only"; return out; }
+		out.resize(A2_NIB_IMAGE_SIZE);
+		a2_dsk_to_nib(out.data(), src);
+		return out;
+	}
+	// everything below stores ProDOS order
+	std::vector<uint8_t> po(src, src + len);
+	if (img.cls == DC_FLOPPY_525) a2_dos_to_prodos(po.data(), src);
+	if (ext == "po" || ext == "hdv") return po;
+	if (ext == "2mg" || ext == "2img") {
+		out.resize(64 + po.size());
+		out.resize(twomg_build(out.data(), out.size(), po.data(), (uint32_t)po.size(), 1));
+		return out;
+	}
+	if (ext == "dc42" || ext == "dc" || ext == "image") {
+		if (img.cls != DC_FLOPPY_35) { why = "DiskCopy 4.2 output is 800K only"; return out; }
+		out.resize(84 + po.size());
+		out.resize(dc42_build(out.data(), out.size(), po.data(), (uint32_t)po.size(), 0x24, nullptr));
+		return out;
+	}
+	why = "unknown output format ." + ext;
+	return out;
+}
+
+// Logical -> WOZ -> logical; 1 if the round trip is lossless.
+static int round_trip(const Logical &img, std::string &why)
+{
+	if (img.cls != DC_FLOPPY_525 && img.cls != DC_FLOPPY_35) { why = "not a floppy"; return 0; }
+	std::vector<uint8_t> woz = encode_as(img, "woz", why);
+	if (woz.empty()) return 0;
+	Logical back;
+	if (!load_logical(woz.data(), woz.size(), "woz", back, why)) return 0;
+	if (back.data != img.data) { why = "decoded data differs"; return 0; }
+	return 1;
+}
+
+// ---------------------------------------------------------------------------
+// WOZ track survey: 13-sector and flux detection
+// ---------------------------------------------------------------------------
+struct Report {
+	std::string path, fmt, platform, note, err;
+	DiskClass cls = DC_UNKNOWN;
+	int disk_type = 0;          // WOZ INFO disk type, 0 when not a WOZ
+	int info_version = 0;
+	int boot_format = -1;       // INFO v2+ boot_sector_format
+	int tracks = 0, tracks16 = 0, tracks13 = 0, flux_tracks = 0;
+	int verified = -1;          // -1 not run, 0 fail, 1 ok
+};
+
+// Count address prologs per track: D5 AA 96 (6-and-2, 16 sector) versus
+// D5 AA B5 (5-and-3, 13 sector). A track with only the latter is 13-sector.
+static void survey_525(const uint8_t *woz, size_t size, Report &r)
+{
+	static thread_local uint8_t bytes[16 * 1024];
+	for (int t = 0; t < A2_TRACKS_525; t++) {
+		const uint8_t *bits;
+		uint32_t bc;
+		int trk = woz_tmap(woz, size, t * 4);
+		if (trk < 0 || !woz_track_bits(woz, size, trk, &bits, &bc)) continue;
+		int n = woz_frame_bits(bits, bc, bytes, sizeof(bytes));
+		int m16 = 0, m13 = 0;
+		for (int i = 0; i + 2 < n; i++) {
+			if (bytes[i] != 0xd5 || bytes[i + 1] != 0xaa) continue;
+			if (bytes[i + 2] == 0x96) m16++;
+			else if (bytes[i + 2] == 0xb5) m13++;
+		}
+		r.tracks++;
+		if (m16) r.tracks16++;
+		else if (m13) r.tracks13++;
+	}
+}
+
+static void survey_woz(const uint8_t *buf, size_t size, Report &r)
+{
+	uint32_t info_len = 0;
+	const uint8_t *info = woz_find_chunk(buf, size, "INFO", &info_len);
+	if (info && info + 60 <= buf + size) {
+		r.info_version = info[0];
+		if (info[0] >= 2) r.boot_format = info[38];
+	}
+	// WOZ 2.1 flux: INFO v3 FLUX block, and a FLUX chunk mapping quarter
+	// tracks to flux TRKS entries (0xFF = bitstream / absent).
+	uint32_t flux_len = 0;
+	const uint8_t *flux = woz_find_chunk(buf, size, "FLUX", &flux_len);
+	if (flux && flux + 160 <= buf + size)
+		for (int i = 0; i < 160; i++)
+			if (flux[i] != 0xFF) r.flux_tracks++;
+
+	if (r.disk_type == 1) {
+		survey_525(buf, size, r);
+	} else if (r.disk_type == 2) {
+		const uint8_t *bits;
+		uint32_t bc;
+		for (int t = 0; t < 160; t++)
+			if (woz_track_bits(buf, size, t, &bits, &bc)) r.tracks++;
+	}
+}
+
+// Same rules as woz_classify_platform.py so catalog.tsv stays comparable.
+static void set_platform(Report &r)
+{
+	std::string fname = base_name(r.path);
+	for (auto &c : fname) c = (char)tolower((unsigned char)c);
+	bool has_iigs = fname.find("iigs") != std::string::npos;
+	if (r.disk_type == 2)                   { r.platform = "iigs";   r.note = "3.5\" disk"; }
+	else if (r.disk_type == 1 && has_iigs)  { r.platform = "iigs";   r.note = "5.25\" with IIgs in name"; }
+	else if (r.disk_type == 1)              { r.platform = "apple2"; r.note = "5.25\" disk"; }
+	else if (r.fmt.compare(0, 3, "woz") == 0) {
+		r.platform = "unknown";
+		r.note = "disk_type=" + std::to_string(r.disk_type);
+	} else if (r.cls == DC_FLOPPY_525)      { r.platform = "apple2"; r.note = "5.25\" image"; }
+	else if (r.cls == DC_FLOPPY_35 || r.cls == DC_HDD) { r.platform = "iigs"; r.note = r.cls == DC_HDD ? "hard disk" : "3.5\" image"; }
+	else                                    { r.platform = "unknown"; r.note = "not a disk image"; }
+
+	if (r.boot_format == 2) r.note += "; 13-sector (INFO)";
+	else if (r.tracks13 && !r.tracks16) r.note += "; 13-sector";
+	else if (r.tracks13) r.note += "; " + std::to_string(r.tracks13) + " 13-sector tracks";
+	if (r.flux_tracks) r.note += "; " + std::to_string(r.flux_tracks) + " flux tracks";
+}
+
+static bool is_13_sector(const Report &r)
+{
+	return r.boot_format == 2 || (r.tracks13 && !r.tracks16);
+}
+
+static void analyse(Report &r, bool verify)
+{
+	MappedFile f;
+	if (!f.Open(r.path)) { r.err = "cannot open"; r.fmt = "?"; set_platform(r); return; }
+	std::string ext = lower_ext(r.path);
+	r.cls = iigs_classify(f.data, f.size, ext.empty() ? nullptr : ext.c_str());
+	int wt = woz_disk_type(f.data, f.size);
+	if (wt > 0) {
+		r.disk_type = wt;
+		r.fmt = memcmp(f.data, "WOZ1", 4) == 0 ? "woz1" : "woz2";
+		survey_woz(f.data, f.size, r);
+	} else if (f.size >= 4 && memcmp(f.data, "WOZ", 3) == 0) {
+		r.fmt = "woz";          // WOZ magic but no INFO chunk
+		r.err = "no INFO chunk";
+	} else if (twomg_parse(f.data, f.size, nullptr)) {
+		r.fmt = "2mg";
+	} else if (dc42_probe(f.data, f.size)) {
+		r.fmt = "dc42";
+	} else {
+		r.fmt = ext.empty() ? "raw" : ext;
+	}
+	set_platform(r);
+
+	if (verify && r.err.empty()) {
+		Logical img;
+		std::string why;
+		if (!load_logical(f.data, f.size, ext, img, why)) { r.verified = 0; r.err = why; }
+		else if (img.cls == DC_HDD)                        { r.verified = -1; }
+		else { r.verified = round_trip(img, why); if (!r.verified) r.err = why; }
+	}
+}
+
+static const char *class_name(DiskClass c)
+{
+	switch (c) {
+	case DC_HDD:        return "hdd";
+	case DC_FLOPPY_525: return "5.25";
+	case DC_FLOPPY_35:  return "3.5";
+	default:            return "unknown";
+	}
+}
+
+// ---------------------------------------------------------------------------
+// screen: software IWM over every track
+// ---------------------------------------------------------------------------
+// Bit cells come from the TRKS bitstream or, when the FLUX chunk maps the
+// track (the core prefers flux then too), from the flux intervals. Each
+// transition falls in the IWM window nearest its arrival, so an interval of
+// t ticks is round(t / cell) cells: that many minus one zeros, then a one.
+struct TrackScreen {
+	int idx = 0;            // TMAP index: quarter track (5.25") or track*2+side (3.5")
+	bool flux = false;
+	uint32_t bits = 0;
+	int sync = 0;           // self-sync bytes (FF then >= 2 zero cells)
+	int expect = 0;         // sectors a standard track of this kind holds
+	A2TrackScan scan = {};
+};
+
+struct Screen {
+	std::string path, verdict, err;
+	int disk_type = 0;
+	int sectors = 0, expected = 0;
+	int present = 0, blank = 0, damaged = 0;
+	std::vector<TrackScreen> tracks;
+	std::set<std::string> sigs;     // protection / oddity signatures
+	double ms = 0;
+};
+
+static uint32_t flux_to_bits(const uint8_t *flux, uint32_t len, int cell, std::vector<uint8_t> &out)
+{
+	uint64_t total = 0;
+	for (uint32_t i = 0; i < len; i++) total += flux[i];
+	out.assign(total / cell / 8 + 2 + len / 8, 0);
+	uint32_t nb = 0, ticks = 0;
+	for (uint32_t i = 0; i < len; i++) {
+		ticks += flux[i];
+		if (flux[i] == 255) continue;           // 255 = interval continues
+		uint32_t cells = (ticks + cell / 2) / cell;
+		if (cells < 1) cells = 1;
+		nb += cells - 1;
+		if ((nb >> 3) >= out.size()) break;
+		out[nb >> 3] |= (uint8_t)(0x80 >> (nb & 7));
+		nb++;
+		ticks = 0;
+	}
+	return nb;
+}
+
+// IWM read latch: shift cells in until bit 7 is set (as woz_frame_bits), but
+// keep count of the zero cells between bytes so 10-bit self-sync can be told
+// from data $FF. Cells past bit_count wrap to the start of the loop; *lim
+// gets the byte count at the end of the first revolution.
+static int iwm_frame(const uint8_t *bits, uint32_t bit_count, uint32_t total,
+                     uint8_t *out, int cap, int *lim, int *sync)
+{
+	uint8_t sh = 0;
+	int n = 0, zeros = 0;
+	*lim = -1;
+	*sync = 0;
+	for (uint32_t i = 0; i < total && n < cap; i++) {
+		if (i == bit_count) *lim = n;
+		uint32_t k = i % bit_count;
+		int bit = (bits[k >> 3] >> (7 - (k & 7))) & 1;
+		if (!sh) {
+			if (!bit) { zeros++; continue; }
+			if (n && out[n - 1] == 0xff && zeros >= 2 && *lim < 0) (*sync)++;
+			zeros = 0;
+		}
+		sh = (uint8_t)((sh << 1) | bit);
+		if (sh & 0x80) { out[n++] = sh; sh = 0; }
+	}
+	if (*lim < 0) *lim = n;
+	return n;
+}
+
+static void screen_track(const uint8_t *woz, size_t size, int disk_type, int cell,
+                         const uint8_t *fluxmap, int idx, int track, TrackScreen &ts)
+{
+	static thread_local std::vector<uint8_t> fbits;
+	static thread_local uint8_t bytes[64 * 1024];
+	ts.idx = idx;
+	const uint8_t *bits = nullptr;
+	uint32_t bc = 0;
+	int fx = fluxmap ? fluxmap[idx] : 0xff;
+	uint32_t trks_len = 0;
+	const uint8_t *trks = woz_find_chunk(woz, size, "TRKS", &trks_len);
+	if (fx != 0xff && trks && (uint32_t)fx * 8 + 8 <= trks_len) {
+		const uint8_t *e = trks + fx * 8;
+		size_t off = (size_t)(e[0] | (e[1] << 8)) * 512;
+		uint32_t len = (uint32_t)(e[4] | (e[5] << 8) | (e[6] << 16) | ((uint32_t)e[7] << 24));
+		if (off && off + len <= size) {
+			bc = flux_to_bits(woz + off, len, cell, fbits);
+			bits = fbits.data();
+			ts.flux = true;
+		}
+	}
+	if (!bits) {
+		int trk = woz_tmap(woz, size, idx);
+		if (trk < 0 || !woz_track_bits(woz, size, trk, &bits, &bc)) bc = 0;
+	}
+	ts.bits = bc;
+	if (!bc) return;
+	// a second pass over the start catches sectors straddling the index
+	uint32_t wrap = bc < 16384 ? bc : 16384;
+	int lim;
+	int n = iwm_frame(bits, bc, bc + wrap, bytes, sizeof(bytes), &lim, &ts.sync);
+	a2_scan_track(bytes, n, lim, disk_type, track, &ts.scan);
+}
+
+static void screen_woz(Screen &sc)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	MappedFile f;
+	if (!f.Open(sc.path)) { sc.err = "cannot open"; sc.verdict = "ERROR"; return; }
+	sc.disk_type = woz_disk_type(f.data, f.size);
+	if (sc.disk_type != 1 && sc.disk_type != 2) { sc.err = "not a WOZ"; sc.verdict = "ERROR"; return; }
+
+	uint32_t info_len = 0, flux_len = 0;
+	const uint8_t *info = woz_find_chunk(f.data, f.size, "INFO", &info_len);
+	const uint8_t *fluxmap = woz_find_chunk(f.data, f.size, "FLUX", &flux_len);
+	if (fluxmap && (flux_len < 160 || fluxmap + 160 > f.data + f.size)) fluxmap = nullptr;
+	// optimal_bit_timing (INFO v2+) in 125ns ticks: 32 = 4us, 16 = 2us
+	int cell = sc.disk_type == 1 ? 32 : 16;
+	if (info && info_len >= 40 && info[0] >= 2 && info[39]) cell = info[39];
+
+	if (sc.disk_type == 1) {
+		for (int t = 0; t < A2_TRACKS_525; t++) {
+			TrackScreen ts;
+			screen_track(f.data, f.size, 1, cell, fluxmap, t * 4, t, ts);
+			ts.expect = ts.scan.sectors13 ? 13 : A2_SECTORS_PER_TRACK;
+			sc.tracks.push_back(ts);
+		}
+		// data on a half track that differs from both neighbours, or past 34
+		for (int q = 2; q < 160; q += 4) {
+			int h = woz_tmap(f.data, f.size, q);
+			if (h >= 0 && h != woz_tmap(f.data, f.size, q - 2) &&
+			    (q + 2 >= 160 || h != woz_tmap(f.data, f.size, q + 2)))
+				sc.sigs.insert("half-tracks");
+		}
+		for (int q = A2_TRACKS_525 * 4; q < 160; q++)
+			if (woz_tmap(f.data, f.size, q) >= 0 && woz_tmap(f.data, f.size, q) != woz_tmap(f.data, f.size, q - 1)) {
+				sc.sigs.insert("track-35+");
+				break;
+			}
+	} else {
+		for (int nt = 0; nt < 160; nt++) {
+			TrackScreen ts;
+			screen_track(f.data, f.size, 2, cell, fluxmap, nt, nt / 2, ts);
+			ts.expect = 12 - nt / 32;
+			sc.tracks.push_back(ts);
+		}
+	}
+
+	for (const auto &ts : sc.tracks) {
+		const A2TrackScan &s = ts.scan;
+		sc.expected += ts.expect;
+		if (ts.flux) sc.sigs.insert("flux");
+		if (!ts.bits || !s.addr_fields) { sc.blank++; continue; }
+		sc.present++;
+		sc.sectors += s.sectors;
+		if (s.sectors13) sc.sigs.insert("13-sector");
+		if (s.wrong_track) sc.sigs.insert("wrong-track-id");
+		if (s.epilog_bad) sc.sigs.insert("bad-epilogue");
+		if (s.odd_prologs > 2) sc.sigs.insert("odd-prologs");
+		if (!ts.sync) sc.sigs.insert("no-sync");
+		if (sc.disk_type == 1 && ts.bits > A2_NIB_TRACK_SIZE * 8) sc.sigs.insert("long-track");
+		if (s.sectors < ts.expect) sc.damaged++;
+	}
+	if (sc.blank && sc.present) sc.sigs.insert("blank-tracks");
+
+	// Verdict: can the boot track be read at all, then oddities, then damage.
+	// flux / blank tracks / 13-sector / no-sync (NIB-derived images use 8-bit
+	// gap bytes) are reported but are not protection by themselves.
+	static const std::set<std::string> benign = { "flux", "blank-tracks", "13-sector", "no-sync" };
+	bool boot = !sc.tracks.empty() && sc.tracks[0].scan.sectors > 0;
+	bool odd = false;
+	for (const auto &g : sc.sigs)
+		if (!benign.count(g)) odd = true;
+	if (!boot)              sc.verdict = "UNREADABLE";
+	else if (odd)           sc.verdict = "PROTECTED";
+	else if (sc.damaged)    sc.verdict = "DAMAGED";
+	else                    sc.verdict = "CLEAN";
+	sc.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static std::string join_sigs(const std::set<std::string> &sigs)
+{
+	std::string out;
+	for (const auto &g : sigs) out += (out.empty() ? "" : ",") + g;
+	return out.empty() ? "-" : out;
+}
+
+// ---------------------------------------------------------------------------
+// triage.csv (woz_review.sh schema: "woz_path",label,"note",timestamp)
+// ---------------------------------------------------------------------------
+static std::string csv_quote(const std::string &s)
+{
+	std::string q = "\"";
+	for (char c : s) { if (c == '"') q += '"'; q += c; }
+	return q + "\"";
+}
+
+static std::set<std::string> read_triage_paths(const std::string &path)
+{
+	std::set<std::string> seen;
+	FILE *f = fopen(path.c_str(), "r");
+	if (!f) return seen;
+	char line[8192];
+	bool header = true;
+	while (fgets(line, sizeof(line), f)) {
+		if (header) { header = false; continue; }
+		std::string p;
+		const char *c = line;
+		if (*c == '"') {
+			for (c++; *c; c++) {
+				if (*c == '"' && c[1] == '"') { p += '"'; c++; }
+				else if (*c == '"') break;
+				else p += *c;
+			}
+		} else {
+			while (*c && *c != ',' && *c != '\n') p += *c++;
+		}
+		if (!p.empty()) seen.insert(p);
+	}
+	fclose(f);
+	return seen;
+}
+
+// ---------------------------------------------------------------------------
+// commands
+// ---------------------------------------------------------------------------
+static int cmd_info(const std::vector<std::string> &files)
+{
+	int rc = 0;
+	for (const auto &path : files) {
+		Report r;
+		r.path = path;
+		analyse(r, false);
+		if (!r.err.empty() && r.fmt == "?") { printf("%s: %s\n", path.c_str(), r.err.c_str()); rc = 1; continue; }
+		printf("%s\n", path.c_str());
+		printf("  format    %s\n", r.fmt.c_str());
+		printf("  class     %s\n", class_name(r.cls));
+		printf("  platform  %s (%s)\n", r.platform.c_str(), r.note.c_str());
+		if (r.disk_type) {
+			printf("  woz       INFO v%d, disk_type %d", r.info_version, r.disk_type);
+			if (r.boot_format >= 0) printf(", boot_sector_format %d", r.boot_format);
+			printf("\n  tracks    %d", r.tracks);
+			if (r.disk_type == 1) printf(" (16-sector %d, 13-sector %d)", r.tracks16, r.tracks13);
+			if (r.flux_tracks) printf(", flux %d", r.flux_tracks);
+			printf("\n");
+		}
+		if (!r.err.empty()) printf("  error     %s\n", r.err.c_str());
+	}
+	return rc;
+}
+
+static int cmd_convert(const std::string &in, const std::string &out)
+{
+	MappedFile f;
+	if (!f.Open(in)) { fprintf(stderr, "iigsimg: cannot open %s\n", in.c_str()); return 1; }
+	Logical img;
+	std::string why;
+	if (!load_logical(f.data, f.size, lower_ext(in), img, why)) {
+		fprintf(stderr, "iigsimg: %s: %s\n", in.c_str(), why.c_str());
+		return 1;
+	}
+	std::vector<uint8_t> enc = encode_as(img, lower_ext(out), why);
+	if (enc.empty()) {
+		fprintf(stderr, "iigsimg: %s: %s\n", out.c_str(), why.empty() ? "encode failed" : why.c_str());
+		return 1;
+	}
+	if (!write_file(out, enc.data(), enc.size())) {
+		fprintf(stderr, "iigsimg: cannot write %s\n", out.c_str());
+		return 1;
+	}
+	printf("%s (%s, %s) -> %s (%zu bytes)\n", in.c_str(), img.fmt.c_str(), class_name(img.cls),
+	       out.c_str(), enc.size());
+	return 0;
+}
+
+static int cmd_verify(const std::vector<std::string> &files, int jobs)
+{
+	std::vector<Report> reps(files.size());
+	parallel_for(files.size(), jobs, [&](size_t i) {
+		reps[i].path = files[i];
+		analyse(reps[i], true);
+	});
+	int ok = 0, bad = 0, skipped = 0;
+	for (const auto &r : reps) {
+		const char *st = r.verified > 0 ? "OK" : r.verified == 0 ? "FAIL" : "SKIP";
+		if (r.verified > 0) ok++; else if (r.verified == 0) bad++; else skipped++;
+		printf("%-4s %-5s %-5s %s%s%s\n", st, r.fmt.c_str(), class_name(r.cls), r.path.c_str(),
+		       r.err.empty() ? "" : "  -- ", r.err.c_str());
+	}
+	printf("\n%d ok, %d failed, %d skipped (not a floppy)\n", ok, bad, skipped);
+	return bad ? 1 : 0;
+}
+
+static int cmd_scan(const std::vector<std::string> &files, int jobs, const std::string &out_dir,
+                    bool apply, bool mark13)
+{
+	std::vector<Report> reps(files.size());
+	parallel_for(files.size(), jobs, [&](size_t i) {
+		reps[i].path = files[i];
+		analyse(reps[i], false);
+	});
+
+	int n_iigs = 0, n_apple2 = 0, n_unknown = 0, n_woz = 0, n_13 = 0, n_flux = 0;
+	for (const auto &r : reps) {
+		if (r.platform == "iigs") n_iigs++;
+		else if (r.platform == "apple2") n_apple2++;
+		else n_unknown++;
+		if (r.disk_type) n_woz++;
+		if (is_13_sector(r)) { n_13++; printf("  13-SECTOR: %s\n", r.path.c_str()); }
+		if (r.flux_tracks) { n_flux++; printf("  FLUX(%d):  %s\n", r.flux_tracks, r.path.c_str()); }
+	}
+	printf("Scanned %zu images (%d WOZ):\n", reps.size(), n_woz);
+	printf("  iigs    %5d\n", n_iigs);
+	printf("  apple2  %5d\n", n_apple2);
+	printf("  unknown %5d\n", n_unknown);
+	printf("  13-sector %3d\n", n_13);
+	printf("  flux      %3d\n", n_flux);
+
+	if (!apply && !mark13) {
+		printf("\nDry run. --apply writes %s/catalog.tsv, --mark-13 adds 13-sector disks to triage.csv.\n",
+		       out_dir.c_str());
+		return 0;
+	}
+	mkdir(out_dir.c_str(), 0777);
+
+	if (apply) {
+		// TSV like woz_classify_platform.py: paths may hold commas, never tabs.
+		std::string catalog = out_dir + "/catalog.tsv", tmp = catalog + ".tmp";
+		FILE *f = fopen(tmp.c_str(), "w");
+		if (!f) { fprintf(stderr, "iigsimg: cannot write %s\n", tmp.c_str()); return 1; }
+		fprintf(f, "woz_path\tplatform\tdisk_type\tnote\n");
+		for (const auto &r : reps)
+			if (r.fmt.compare(0, 3, "woz") == 0)
+				fprintf(f, "%s\t%s\t%d\t%s\n", r.path.c_str(), r.platform.c_str(), r.disk_type, r.note.c_str());
+		fclose(f);
+		if (rename(tmp.c_str(), catalog.c_str()) != 0) { fprintf(stderr, "iigsimg: cannot rename %s\n", tmp.c_str()); return 1; }
+		printf("\nWrote %s\n", catalog.c_str());
+		std::string legacy = out_dir + "/catalog.csv";
+		if (unlink(legacy.c_str()) == 0) printf("Removed stale %s\n", legacy.c_str());
+	}
+
+	if (mark13) {
+		std::string triage = out_dir + "/triage.csv";
+		std::set<std::string> existing = read_triage_paths(triage);
+		struct stat st;
+		bool header = stat(triage.c_str(), &st) != 0 || st.st_size == 0;
+		FILE *f = fopen(triage.c_str(), "a");
+		if (!f) { fprintf(stderr, "iigsimg: cannot write %s\n", triage.c_str()); return 1; }
+		if (header) fprintf(f, "woz_path,label,note,timestamp\n");
+		char ts[32];
+		time_t now = time(nullptr);
+		strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+		int added = 0;
+		for (const auto &r : reps) {
+			if (!r.disk_type || !is_13_sector(r) || existing.count(r.path)) continue;
+			std::string note = r.boot_format == 2 ? "auto: WOZ INFO boot_sector_format=2 (pre-DOS 3.3)"
+			                                      : "auto: only D5 AA B5 address marks (5-and-3)";
+			fprintf(f, "%s,13_sector,%s,%s\n", csv_quote(r.path).c_str(), csv_quote(note).c_str(), ts);
+			added++;
+		}
+		fclose(f);
+		printf("Added %d entries to %s\n", added, triage.c_str());
+	}
+	printf("Refresh the review with:\n  ./woz_review.sh --out %s\n", out_dir.c_str());
+	return 0;
+}
+
+static int cmd_screen(const std::vector<std::string> &files, int jobs, const std::string &out_dir,
+                      bool apply, bool verbose)
+{
+	std::vector<Screen> scr(files.size());
+	auto t0 = std::chrono::steady_clock::now();
+	parallel_for(files.size(), jobs, [&](size_t i) {
+		scr[i].path = files[i];
+		screen_woz(scr[i]);
+	});
+	double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	std::map<std::string, int> counts;
+	double ms = 0;
+	for (const auto &sc : scr) {
+		counts[sc.verdict]++;
+		ms += sc.ms;
+		if (!sc.err.empty()) { printf("%-10s %s  -- %s\n", sc.verdict.c_str(), sc.path.c_str(), sc.err.c_str()); continue; }
+		printf("%-10s %4d/%-4d %-40s %s\n", sc.verdict.c_str(), sc.sectors, sc.expected,
+		       join_sigs(sc.sigs).c_str(), sc.path.c_str());
+		if (!verbose) continue;
+		for (const auto &ts : sc.tracks) {
+			const A2TrackScan &s = ts.scan;
+			if (sc.disk_type == 1) printf("    T%02d   ", ts.idx / 4);
+			else                   printf("    T%02d.%d ", ts.idx / 2, ts.idx % 2);
+			if (!ts.bits) { printf("(no track)\n"); continue; }
+			printf("%6u bits%s sync %4d  addr %3d (%d bad)  data %3d ok %d bad  sectors %2d/%d",
+			       ts.bits, ts.flux ? " flux" : "     ", ts.sync, s.addr_fields, s.addr_bad,
+			       s.data_ok, s.data_bad, s.sectors, ts.expect);
+			if (s.sectors13)   printf("  13-sector");
+			if (s.wrong_track) printf("  wrong-id %d", s.wrong_track);
+			if (s.epilog_bad)  printf("  bad-epi %d", s.epilog_bad);
+			if (s.odd_prologs) printf("  odd-prolog %d", s.odd_prologs);
+			printf("\n");
+		}
+	}
+	printf("\nScreened %zu images in %.2fs (%.1f ms/disk):", scr.size(), wall,
+	       scr.empty() ? 0.0 : ms / scr.size());
+	for (const auto &c : counts) printf("  %s %d", c.first.c_str(), c.second);
+	printf("\n");
+
+	if (apply) {
+		mkdir(out_dir.c_str(), 0777);
+		std::string tsv = out_dir + "/screen.tsv", tmp = tsv + ".tmp";
+		FILE *f = fopen(tmp.c_str(), "w");
+		if (!f) { fprintf(stderr, "iigsimg: cannot write %s\n", tmp.c_str()); return 1; }
+		fprintf(f, "woz_path\tverdict\tsectors\texpected\tdamaged_tracks\tsignatures\n");
+		for (const auto &sc : scr)
+			fprintf(f, "%s\t%s\t%d\t%d\t%d\t%s\n", sc.path.c_str(), sc.verdict.c_str(),
+			        sc.sectors, sc.expected, sc.damaged, sc.err.empty() ? join_sigs(sc.sigs).c_str() : sc.err.c_str());
+		fclose(f);
+		if (rename(tmp.c_str(), tsv.c_str()) != 0) { fprintf(stderr, "iigsimg: cannot rename %s\n", tmp.c_str()); return 1; }
+		printf("Wrote %s\n", tsv.c_str());
+	}
+	return 0;
+}
+
+static void usage(void)
+{
+	printf("usage:\n"
+	       "  iigsimg info    FILE...\n"
+	       "  iigsimg convert IN OUT        (OUT extension: woz dsk do po nib 2mg dc42 hdv)\n"
+	       "  iigsimg verify  [-j N] PATH...\n"
+	       "  iigsimg scan    [-j N] [--out DIR] [--apply] [--mark-13] [--woz-only] PATH...\n"
+	       "  iigsimg screen  [-j N] [-v] [--out DIR] [--apply] [--from LIST] PATH...\n"
+	       "\n"
+	       "PATH may be a file or a directory (walked recursively for disk images).\n"
+	       "scan --out defaults to woz_report; --apply writes catalog.tsv for woz_review.sh.\n"
+	       "screen --apply writes screen.tsv; --from reads extra paths, one per line.\n");
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "--help")) { usage(); return argc < 2; }
+	std::string cmd = argv[1];
+
+	int jobs = (int)std::thread::hardware_concurrency();
+	if (jobs < 1) jobs = 1;
+	std::string out_dir = "woz_report";
+	bool apply = false, mark13 = false, woz_only = false, verbose = false;
+	std::vector<std::string> args;
+	for (int i = 2; i < argc; i++) {
+		if ((!strcmp(argv[i], "-j") || !strcmp(argv[i], "--jobs")) && i + 1 < argc) jobs = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--out") && i + 1 < argc) out_dir = argv[++i];
+		else if (!strcmp(argv[i], "--apply")) apply = true;
+		else if (!strcmp(argv[i], "--mark-13")) mark13 = true;
+		else if (!strcmp(argv[i], "--woz-only")) woz_only = true;
+		else if (!strcmp(argv[i], "-v")) verbose = true;
+		else if (!strcmp(argv[i], "--from") && i + 1 < argc) {
+			FILE *f = fopen(argv[++i], "r");
+			if (!f) { fprintf(stderr, "iigsimg: cannot open %s\n", argv[i]); return 1; }
+			char line[8192];
+			while (fgets(line, sizeof(line), f)) {
+				line[strcspn(line, "\r\n")] = 0;
+				if (line[0]) args.push_back(line);
+			}
+			fclose(f);
+		}
+		else if (argv[i][0] == '-' && argv[i][1]) { fprintf(stderr, "iigsimg: unknown option %s\n", argv[i]); return 2; }
+		else args.push_back(argv[i]);
+	}
+
+	if (cmd == "convert") {
+		if (args.size() != 2) { usage(); return 2; }
+		return cmd_convert(args[0], args[1]);
+	}
+
+	std::vector<std::string> files;
+	for (const auto &a : args) walk(a, woz_only || cmd == "screen" ? "woz" : nullptr, files);
+	std::sort(files.begin(), files.end());
+	if (files.empty()) { fprintf(stderr, "iigsimg: no images found\n"); return 1; }
+
+	if (cmd == "info")   return cmd_info(files);
+	if (cmd == "verify") return cmd_verify(files, jobs);
+	if (cmd == "scan")   return cmd_scan(files, jobs, out_dir, apply, mark13);
+	if (cmd == "screen") return cmd_screen(files, jobs, out_dir, apply, verbose);
+	usage();
+	return 2;
+}
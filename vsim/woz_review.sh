@@ -162,6 +162,7 @@ cat > "$TMP" <<HTML_HEAD
   .count.BLANK     { background: #888; }
   .count.TIMEOUT   { background: #c33; }
   .count.CRASH     { background: #808; }
+  .count.UNREADABLE { background: #543; }
   .count.ok           { background: #080; }
   .count.more_frames  { background: #068; }
   .count.a13_sector   { background: #607; }
@@ -188,6 +189,7 @@ cat > "$TMP" <<HTML_HEAD
   .badge.BLANK     { background: #888; }
   .badge.TIMEOUT   { background: #c33; }
   .badge.CRASH     { background: #808; }
+  .badge.UNREADABLE { background: #543; }
   .triage-badge { display: inline-block; padding: 2px 8px; border-radius: 3px;
                   font-weight: bold; font-size: 11px; color: #fff; margin-right: 6px; }
   .triage-badge.ok          { background: #080; }
@@ -256,6 +258,7 @@ cat > "$TMP" <<HTML_HEAD
     <button class="status-filter" data-filter="BLANK">BLANK</button>
     <button class="status-filter" data-filter="TIMEOUT">TIMEOUT</button>
     <button class="status-filter" data-filter="CRASH">CRASH</button>
+    <button class="status-filter" data-filter="UNREADABLE">UNREADABLE</button>
     <span class="summary" id="statusSummary"></span>
   </div>
   <div class="filter-row">
@@ -300,7 +303,7 @@ HTML_HEAD
 
 # -------- Per-disk rows --------
 # Sort order: status bucket then path.
-# Status priority: BOOTED < TEXT_ONLY < BLANK < TIMEOUT < CRASH
+# Status priority: BOOTED < TEXT_ONLY < BLANK < TIMEOUT < CRASH < UNREADABLE
 #
 # If woz_report/catalog.tsv exists (generated by woz_classify_platform.py),
 # each row also gets a data-platform="iigs|apple2|unknown" attribute so the
@@ -348,7 +351,7 @@ awk -F',' -v catalog="$CATALOG" '
     if (platform == "") platform = "unknown"
 
     ord["BOOTED"]=0; ord["TEXT_ONLY"]=1; ord["BLANK"]=2
-    ord["TIMEOUT"]=3; ord["CRASH"]=4
+    ord["TIMEOUT"]=3; ord["CRASH"]=4; ord["UNREADABLE"]=5
     sort_key = sprintf("%d|%s", ord[status], path)
     rows[++nrows] = sort_key SUBSEP status SUBSEP size SUBSEP hash SUBSEP path SUBSEP fname SUBSEP platform
   }
@@ -627,7 +630,7 @@ cat >> "$TMP" <<'HTML_FOOT'
         el.appendChild(span);
       });
     }
-    paint('statusSummary', statusCounts, ['BOOTED','TEXT_ONLY','BLANK','TIMEOUT','CRASH']);
+    paint('statusSummary', statusCounts, ['BOOTED','TEXT_ONLY','BLANK','TIMEOUT','CRASH','UNREADABLE']);
     paint('triageSummary', triageCounts,
           ['unreviewed','ok','more_frames','13_sector','broken','boot_fail']);
     paint('platformSummary', platformCounts, ['iigs','apple2','unknown']);